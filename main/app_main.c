@@ -7,12 +7,16 @@
 #include "lvgl.h"
 #include "nvs_flash.h"
 
+#include "history_log.h"
+#include "history_store.h"
 #include "http_service.h"
 #include "i2c_utils.h"
 #include "net_manager.h"
-#include "port_i2c.h"		  // provides port_i2c_* and port_i2c_port_t
-#include "port_i2c_service.h" // provides port_i2c_service_start()
+#include "port_i2c.h" // provides port_i2c_port_t
+#include "port_i2c_stats.h"
 #include "power_aw9523.h"
+#include "sensor_discovery.h" // sensor_discovery_start()
+#include "sensor_sampler.h"	  // sensor_sampler_start()
 #include "sgp30.h"
 #include "sht40.h"
 #include "sntp.h"
@@ -23,24 +27,23 @@
 
 #define TAG "main"
 
-#define SHT40_ADDR 0x44
-#define SGP30_ADDR 0x58
-
-/* -------------------------------------------------------------------------- */
-/* Compile-time external bus selection (one bus for all external I2C devices) */
-/* -------------------------------------------------------------------------- */
-
-static inline port_i2c_port_t external_i2c_selected_port(void) {
-#if CONFIG_EXT_I2C_BUS_PORT_A
-	return PORT_I2C_PORT_A;
-#elif CONFIG_EXT_I2C_BUS_PORT_B
-	return PORT_I2C_PORT_B;
-#elif CONFIG_EXT_I2C_BUS_PORT_C
-	return PORT_I2C_PORT_C;
-#else
-#error "External I2C bus not selected in menuconfig"
-#endif
-}
+/* External sensors the discovery scan looks for, bound when they answer */
+static const sensor_driver_t s_sensor_drivers[] = {
+	{
+		.name = "SHT40",
+		.port = (port_i2c_port_t)CONFIG_SHT40_I2C_PORT,
+		.addr = SHT40_I2C_ADDR,
+		.scl_hz = SHT40_I2C_SCL_HZ,
+		.bind = sht40_register,
+	},
+	{
+		.name = "SGP30",
+		.port = (port_i2c_port_t)CONFIG_SGP30_I2C_PORT,
+		.addr = SGP30_I2C_ADDR,
+		.scl_hz = SGP30_I2C_SCL_HZ,
+		.bind = sgp30_register,
+	},
+};
 
 void app_main(void) {
 	/* --- System init for Wi-Fi --- */
@@ -67,46 +70,35 @@ void app_main(void) {
 	vTaskDelay(pdMS_TO_TICKS(50));
 	ESP_LOGI(TAG, "Grove 5V enabled.");
 
-	/* ---------------------------------------------------------------------- */
-	/* External I2C bus init (single bus chosen from Kconfig) */
-	/* ---------------------------------------------------------------------- */
-	const port_i2c_port_t ext_port = external_i2c_selected_port();
-	ESP_LOGI(TAG, "External I2C bus configured on port %d", (int)ext_port);
-
-	i2c_master_bus_handle_t ext_bus = NULL;
-	port_i2c_bus_config_t cfg;
-
-	ESP_ERROR_CHECK(port_i2c_get_default_bus_config(ext_port, &cfg));
-	ESP_ERROR_CHECK(port_i2c_bus_init(&cfg, &ext_bus));
-
-	/* ---------------------------------------------------------------------- */
-	/* Add external devices (share same bus) */
-	/* ---------------------------------------------------------------------- */
-	i2c_master_dev_handle_t sht_dev = NULL;
-	ESP_ERROR_CHECK(port_i2c_add_device(ext_bus, SHT40_ADDR, 400000, &sht_dev));
-
-	i2c_master_dev_handle_t sgp_dev = NULL;
-	ESP_ERROR_CHECK(port_i2c_add_device(ext_bus, SGP30_ADDR, 100000, &sgp_dev));
-
 	/* ---------------------------------------------------------------------- */
 	/* Start services/tasks */
 	/* ---------------------------------------------------------------------- */
+	if (history_store_init() != ESP_OK) {
+		ESP_LOGW(TAG, "Sensor history disabled");
+	}
 	readings_store_init();
 	net_manager_start();
 
 	sntp_service_init_and_start(CONFIG_TIMEZONE);
 	sntp_service_wait_for_sync(pdMS_TO_TICKS(5000));
 
+	/* Needs the wall clock to place stored minutes; before sensors start */
+	if (history_log_start() != ESP_OK) {
+		ESP_LOGW(TAG, "Sensor history not persisted");
+	}
+
 	http_service_start();
 	weather_task_start();
 	stocks_task_start();
 
-	/* Start the (single) external I2C owner/service */
-	port_i2c_service_start();
-
-	/* Start sensor tasks */
-	sht40_task_start(sht_dev);
-	sgp30_task_start(sgp_dev);
+	/* Scan the external ports; sensors join the sampler as they appear */
+	ESP_ERROR_CHECK(sensor_discovery_start(
+		s_sensor_drivers,
+		sizeof(s_sensor_drivers) / sizeof(s_sensor_drivers[0])));
+	sensor_sampler_start();
+	if (port_i2c_stats_start_log() != ESP_OK) {
+		ESP_LOGW(TAG, "I2C statistics will not be logged");
+	}
 
 	/* ---------------------------------------------------------------------- */
 	/* UI init + loop */
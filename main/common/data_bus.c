@@ -0,0 +1,65 @@
+#include "data_bus.h"
+
+#include "freertos/task.h"
+
+typedef struct {
+	TaskHandle_t task;
+	uint32_t topics;
+} subscriber_t;
+
+static subscriber_t s_subs[DATA_BUS_MAX_SUBSCRIBERS];
+static int s_count;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t data_bus_subscribe(uint32_t topics) {
+	if (topics == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+	esp_err_t err = ESP_ERR_NO_MEM;
+
+	portENTER_CRITICAL(&s_lock);
+	for (int i = 0; i < s_count; i++) {
+		if (s_subs[i].task == self) {
+			s_subs[i].topics |= topics;
+			err = ESP_OK;
+			break;
+		}
+	}
+	if (err != ESP_OK && s_count < DATA_BUS_MAX_SUBSCRIBERS) {
+		s_subs[s_count++] = (subscriber_t){.task = self, .topics = topics};
+		err = ESP_OK;
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return err;
+}
+
+void data_bus_publish(uint32_t topics) {
+	// Copy the list so notifying (which may switch tasks) runs unlocked
+	subscriber_t subs[DATA_BUS_MAX_SUBSCRIBERS];
+	int n;
+
+	portENTER_CRITICAL(&s_lock);
+	n = s_count;
+	for (int i = 0; i < n; i++) {
+		subs[i] = s_subs[i];
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	for (int i = 0; i < n; i++) {
+		uint32_t hit = subs[i].topics & topics;
+		if (hit) {
+			xTaskNotify(subs[i].task, hit, eSetBits);
+		}
+	}
+}
+
+uint32_t data_bus_wait(TickType_t timeout) {
+	uint32_t topics = 0;
+	if (xTaskNotifyWait(0, UINT32_MAX, &topics, timeout) != pdTRUE) {
+		return 0;
+	}
+	return topics;
+}
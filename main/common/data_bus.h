@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Topics, one bit each, so several can be published or awaited at
+ * once.
+ */
+typedef enum {
+	DATA_TOPIC_READINGS = 1u << 0, ///< readings_update_*() stored a sample
+	DATA_TOPIC_WEATHER = 1u << 1,  ///< weather snapshot changed
+	DATA_TOPIC_STOCKS = 1u << 2,   ///< stocks snapshot changed
+	DATA_TOPIC_VIEW = 1u << 3,	   ///< UI setting changed (unit, page, ...)
+	DATA_TOPIC_CLOCK = 1u << 4,	   ///< Wall-clock second boundary passed
+} data_topic_t;
+
+/** Most tasks that can subscribe. */
+#define DATA_BUS_MAX_SUBSCRIBERS 8
+
+/**
+ * @brief Subscribe the calling task to a set of topics.
+ *
+ * Events are delivered as bits of the task's notification value (index
+ * 0), so a subscriber must not use its notification for anything else.
+ * Publishing ORs the topic bits in: any number of publishes between two
+ * waits coalesce into one wakeup. Calling it again widens the set.
+ *
+ * @param topics Mask of data_topic_t bits.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_NO_MEM when
+ *         DATA_BUS_MAX_SUBSCRIBERS tasks already subscribed.
+ */
+esp_err_t data_bus_subscribe(uint32_t topics);
+
+/**
+ * @brief Tell every subscriber of the given topics that new data is ready.
+ *
+ * Call after the data was published (e.g. after seqlock_write_end()), so
+ * a woken subscriber reads the new version. Never blocks; not ISR-safe.
+ */
+void data_bus_publish(uint32_t topics);
+
+/**
+ * @brief Sleep until a subscribed topic is published.
+ *
+ * @param timeout Ticks to wait (portMAX_DELAY = forever).
+ *
+ * @return Topics published since the last call (0 on timeout).
+ */
+uint32_t data_bus_wait(TickType_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
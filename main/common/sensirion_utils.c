@@ -1,18 +1,136 @@
 #include "sensirion_utils.h"
 
+/*
+ * CRC-8 lookup table for polynomial 0x31: s_crc_table[i] is the CRC register
+ * after shifting byte i through it. One lookup replaces the 8-step bit loop.
+ */
+static const uint8_t s_crc_table[256] = {
+	0x00, 0x31, 0x62, 0x53, 0xc4, 0xf5, 0xa6, 0x97, 0xb9, 0x88, 0xdb, 0xea,
+	0x7d, 0x4c, 0x1f, 0x2e, 0x43, 0x72, 0x21, 0x10, 0x87, 0xb6, 0xe5, 0xd4,
+	0xfa, 0xcb, 0x98, 0xa9, 0x3e, 0x0f, 0x5c, 0x6d, 0x86, 0xb7, 0xe4, 0xd5,
+	0x42, 0x73, 0x20, 0x11, 0x3f, 0x0e, 0x5d, 0x6c, 0xfb, 0xca, 0x99, 0xa8,
+	0xc5, 0xf4, 0xa7, 0x96, 0x01, 0x30, 0x63, 0x52, 0x7c, 0x4d, 0x1e, 0x2f,
+	0xb8, 0x89, 0xda, 0xeb, 0x3d, 0x0c, 0x5f, 0x6e, 0xf9, 0xc8, 0x9b, 0xaa,
+	0x84, 0xb5, 0xe6, 0xd7, 0x40, 0x71, 0x22, 0x13, 0x7e, 0x4f, 0x1c, 0x2d,
+	0xba, 0x8b, 0xd8, 0xe9, 0xc7, 0xf6, 0xa5, 0x94, 0x03, 0x32, 0x61, 0x50,
+	0xbb, 0x8a, 0xd9, 0xe8, 0x7f, 0x4e, 0x1d, 0x2c, 0x02, 0x33, 0x60, 0x51,
+	0xc6, 0xf7, 0xa4, 0x95, 0xf8, 0xc9, 0x9a, 0xab, 0x3c, 0x0d, 0x5e, 0x6f,
+	0x41, 0x70, 0x23, 0x12, 0x85, 0xb4, 0xe7, 0xd6, 0x7a, 0x4b, 0x18, 0x29,
+	0xbe, 0x8f, 0xdc, 0xed, 0xc3, 0xf2, 0xa1, 0x90, 0x07, 0x36, 0x65, 0x54,
+	0x39, 0x08, 0x5b, 0x6a, 0xfd, 0xcc, 0x9f, 0xae, 0x80, 0xb1, 0xe2, 0xd3,
+	0x44, 0x75, 0x26, 0x17, 0xfc, 0xcd, 0x9e, 0xaf, 0x38, 0x09, 0x5a, 0x6b,
+	0x45, 0x74, 0x27, 0x16, 0x81, 0xb0, 0xe3, 0xd2, 0xbf, 0x8e, 0xdd, 0xec,
+	0x7b, 0x4a, 0x19, 0x28, 0x06, 0x37, 0x64, 0x55, 0xc2, 0xf3, 0xa0, 0x91,
+	0x47, 0x76, 0x25, 0x14, 0x83, 0xb2, 0xe1, 0xd0, 0xfe, 0xcf, 0x9c, 0xad,
+	0x3a, 0x0b, 0x58, 0x69, 0x04, 0x35, 0x66, 0x57, 0xc0, 0xf1, 0xa2, 0x93,
+	0xbd, 0x8c, 0xdf, 0xee, 0x79, 0x48, 0x1b, 0x2a, 0xc1, 0xf0, 0xa3, 0x92,
+	0x05, 0x34, 0x67, 0x56, 0x78, 0x49, 0x1a, 0x2b, 0xbc, 0x8d, 0xde, 0xef,
+	0x82, 0xb3, 0xe0, 0xd1, 0x46, 0x77, 0x24, 0x15, 0x3b, 0x0a, 0x59, 0x68,
+	0xff, 0xce, 0x9d, 0xac,
+};
+
 uint8_t sensirion_crc8(const uint8_t *data, int len) {
 	uint8_t crc = 0xFF;
 
-	for (int i = 0; i < len; i++) {
-		crc ^= data[i];
+	for (int i = 0; i < len; i++)
+		crc = s_crc_table[crc ^ data[i]];
+
+	return crc;
+}
+
+/** CRC of one big-endian word (the only length Sensirion frames use). */
+static inline uint8_t word_crc(uint8_t msb, uint8_t lsb) {
+	return s_crc_table[s_crc_table[0xFF ^ msb] ^ lsb];
+}
+
+esp_err_t sensirion_decode_words(const uint8_t *frame, size_t len,
+								 uint16_t *words, int n, int *bad_word) {
+	if (bad_word)
+		*bad_word = -1;
+	if (!frame || n <= 0)
+		return ESP_ERR_INVALID_ARG;
+	if (len < (size_t)n * SENSIRION_WORD_SIZE)
+		return ESP_ERR_INVALID_SIZE;
 
-		for (int bit = 0; bit < 8; bit++) {
-			if (crc & 0x80)
-				crc = (uint8_t)((crc << 1) ^ 0x31);
-			else
-				crc <<= 1;
+	for (int i = 0; i < n; i++) {
+		const uint8_t *w = &frame[i * SENSIRION_WORD_SIZE];
+		if (word_crc(w[0], w[1]) != w[2]) {
+			if (bad_word)
+				*bad_word = i;
+			return ESP_ERR_INVALID_CRC;
 		}
+		if (words)
+			words[i] = (uint16_t)((w[0] << 8) | w[1]);
 	}
 
-	return crc;
+	return ESP_OK;
+}
+
+size_t sensirion_encode_words(const uint16_t *words, int n, uint8_t *out,
+							  size_t out_len) {
+	if (!words || !out || n < 0 || out_len < (size_t)n * SENSIRION_WORD_SIZE)
+		return 0;
+
+	for (int i = 0; i < n; i++) {
+		uint8_t *w = &out[i * SENSIRION_WORD_SIZE];
+		w[0] = (uint8_t)(words[i] >> 8);
+		w[1] = (uint8_t)(words[i] & 0xFF);
+		w[2] = word_crc(w[0], w[1]);
+	}
+
+	return (size_t)n * SENSIRION_WORD_SIZE;
+}
+
+size_t sensirion_build_cmd(uint16_t cmd, uint8_t cmd_len, const uint16_t *args,
+						   int n_args, uint8_t *out, size_t out_len) {
+	if (!out || (cmd_len != 1 && cmd_len != 2) || n_args < 0 ||
+		(n_args > 0 && !args))
+		return 0;
+
+	size_t total = cmd_len + (size_t)n_args * SENSIRION_WORD_SIZE;
+	if (out_len < total)
+		return 0;
+
+	if (cmd_len == 2) {
+		out[0] = (uint8_t)(cmd >> 8);
+		out[1] = (uint8_t)(cmd & 0xFF);
+	} else {
+		out[0] = (uint8_t)(cmd & 0xFF);
+	}
+
+	if (n_args > 0)
+		(void)sensirion_encode_words(args, n_args, out + cmd_len,
+									 out_len - cmd_len);
+	return total;
+}
+
+/*
+ * Water vapour density at 100 %RH in mg/m^3, every 5 degC from -20 to
+ * 70 degC (Magnus formula). Linear interpolation stays within 2 % of the
+ * formula over the whole range.
+ */
+#define AH_T_LO_MC (-20000)
+#define AH_T_STEP_MC 5000
+static const uint32_t s_ah_sat_mg_m3[] = {
+	1078,  1611,  2364,  3412,  4849,  6792,   9383,   12797,  17243,  22968,
+	30264, 39471, 50983, 65250, 82785, 104168, 130048, 161150, 198277,
+};
+#define AH_LUT_LEN (sizeof(s_ah_sat_mg_m3) / sizeof(s_ah_sat_mg_m3[0]))
+
+uint32_t sensirion_abs_humidity_mg_m3(int32_t temp_mc, int32_t rh_mpct) {
+	if (rh_mpct <= 0)
+		return 0;
+
+	uint32_t t = temp_mc > AH_T_LO_MC ? (uint32_t)(temp_mc - AH_T_LO_MC) : 0;
+	uint32_t i = t / AH_T_STEP_MC;
+	uint32_t sat;
+	if (i >= AH_LUT_LEN - 1) {
+		sat = s_ah_sat_mg_m3[AH_LUT_LEN - 1];
+	} else {
+		uint32_t rem = t % AH_T_STEP_MC;
+		sat = s_ah_sat_mg_m3[i] +
+			  (s_ah_sat_mg_m3[i + 1] - s_ah_sat_mg_m3[i]) * rem / AH_T_STEP_MC;
+	}
+
+	return (uint32_t)((uint64_t)sat * (uint32_t)rh_mpct / 100000);
 }
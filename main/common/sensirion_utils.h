@@ -1,20 +1,80 @@
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 
+#include "esp_err.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Bytes per word on the wire: MSB, LSB, CRC-8. */
+#define SENSIRION_WORD_SIZE 3
+
 /**
  * @brief Compute Sensirion CRC-8.
  *
  * Polynomial: 0x31
  * Init value: 0xFF
  *
- * Used by SHT40, SGP30, and other Sensirion sensors.
+ * Used by SHT40, SGP30, and other Sensirion sensors. Table-driven: one
+ * lookup per byte.
  */
 uint8_t sensirion_crc8(const uint8_t *data, int len);
 
+/**
+ * @brief Verify and decode the first n words of a response frame.
+ *
+ * Every word's CRC is checked; decoding stops at the first mismatch.
+ *
+ * @param[in]  frame    Raw frame (n * SENSIRION_WORD_SIZE bytes or more).
+ * @param[in]  len      Bytes available in frame.
+ * @param[out] words    Decoded host-endian words (may be NULL to only
+ *                      verify). Words after a bad one are left untouched.
+ * @param[in]  n        Number of words to decode.
+ * @param[out] bad_word Optional: index of the first word with a bad CRC,
+ *                      or -1.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_SIZE if the frame is
+ *         too short, or ESP_ERR_INVALID_CRC.
+ */
+esp_err_t sensirion_decode_words(const uint8_t *frame, size_t len,
+								 uint16_t *words, int n, int *bad_word);
+
+/**
+ * @brief Encode n words as MSB, LSB, CRC triples.
+ *
+ * @return Bytes written (n * SENSIRION_WORD_SIZE), or 0 if out is too small
+ *         or an argument is invalid.
+ */
+size_t sensirion_encode_words(const uint16_t *words, int n, uint8_t *out,
+							  size_t out_len);
+
+/**
+ * @brief Build a command frame: the command (big-endian, 1 or 2 bytes)
+ * followed by n_args CRC-protected argument words.
+ *
+ * E.g. SGP30 set baseline is sensirion_build_cmd(0x201E, 2, {tvoc, eco2},
+ * 2, ...), 8 bytes.
+ *
+ * @return Frame length, or 0 if out is too small or an argument is invalid.
+ */
+size_t sensirion_build_cmd(uint16_t cmd, uint8_t cmd_len, const uint16_t *args,
+						   int n_args, uint8_t *out, size_t out_len);
+
+/**
+ * @brief Absolute humidity from temperature and relative humidity.
+ *
+ * Integer-only (table + linear interpolation), for feeding humidity
+ * compensation to gas sensors such as the SGP30.
+ *
+ * @param temp_mc  Temperature in milli-degC (clamped to -20..70 degC).
+ * @param rh_mpct  Relative humidity in milli-%RH.
+ *
+ * @return Absolute humidity in mg/m^3 (0 if rh_mpct <= 0).
+ */
+uint32_t sensirion_abs_humidity_mg_m3(int32_t temp_mc, int32_t rh_mpct);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,38 @@
+#include "seqlock.h"
+
+#include <string.h>
+
+void seqlock_write_begin(seqlock_t *sl) {
+	portENTER_CRITICAL(&sl->writer);
+	sl->seq = sl->seq + 1;
+	// Odd counter must be visible before any of the data stores
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void seqlock_write_end(seqlock_t *sl) {
+	// Data stores must be visible before the counter turns even
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	sl->seq = sl->seq + 1;
+	portEXIT_CRITICAL(&sl->writer);
+}
+
+uint32_t seqlock_read(seqlock_t *sl, void *dst, const void *src, size_t len) {
+	for (;;) {
+		uint32_t start = __atomic_load_n(&sl->seq, __ATOMIC_ACQUIRE);
+		if (start & 1) {
+			continue; // writer mid-update on the other core
+		}
+
+		memcpy(dst, src, len);
+
+		// The copy's loads must complete before the counter is re-checked
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&sl->seq, __ATOMIC_RELAXED) == start) {
+			return start >> 1;
+		}
+	}
+}
+
+uint32_t seqlock_generation(const seqlock_t *sl) {
+	return __atomic_load_n(&sl->seq, __ATOMIC_ACQUIRE) >> 1;
+}
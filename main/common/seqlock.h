@@ -0,0 +1,72 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Sequence lock guarding one shared snapshot struct.
+ *
+ * A writer updates the struct between seqlock_write_begin() and
+ * seqlock_write_end(); any number of readers copy it out with
+ * seqlock_read() without ever blocking. The counter is odd while a write is
+ * in progress, and a reader whose copy overlapped a write simply copies
+ * again.
+ *
+ * The writer runs its update inside a spinlock critical section, so it can
+ * neither be preempted by a reader on its own core nor stall one on the
+ * other core for longer than the update itself. The spinlock also
+ * serialises writers, though each store normally has just one. Keep updates
+ * to plain field assignments and struct copies: no logging, no blocking
+ * calls.
+ *
+ * Progress: lock-free for writers, retrying readers. A writer never waits
+ * for a reader; a reader may retry for as long as writes keep overlapping
+ * its copy.
+ */
+typedef struct {
+	volatile uint32_t seq; ///< Completed writes * 2, +1 while writing
+	portMUX_TYPE writer;   ///< Writer critical section
+} seqlock_t;
+
+/** Static initializer for a seqlock_t. */
+#define SEQLOCK_INIT {.seq = 0, .writer = portMUX_INITIALIZER_UNLOCKED}
+
+/**
+ * @brief Start an update of the guarded data (enters a critical section).
+ */
+void seqlock_write_begin(seqlock_t *sl);
+
+/**
+ * @brief Publish the update and leave the critical section.
+ */
+void seqlock_write_end(seqlock_t *sl);
+
+/**
+ * @brief Copy out a consistent version of the guarded data.
+ *
+ * Never blocks; retries only while the writer is mid-update.
+ *
+ * @param[in]  sl  Lock guarding src.
+ * @param[out] dst Destination buffer of len bytes.
+ * @param[in]  src Guarded data.
+ * @param[in]  len Bytes to copy.
+ *
+ * @return Generation of the copy (number of writes published before it).
+ */
+uint32_t seqlock_read(seqlock_t *sl, void *dst, const void *src, size_t len);
+
+/**
+ * @brief Generation of the latest published write.
+ *
+ * Lets a reader skip the copy when nothing changed since its last read.
+ */
+uint32_t seqlock_generation(const seqlock_t *sl);
+
+#ifdef __cplusplus
+}
+#endif
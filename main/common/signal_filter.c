@@ -0,0 +1,99 @@
+#include "signal_filter.h"
+
+#include <string.h>
+
+void signal_filter_init(signal_filter_t *f, const signal_filter_cfg_t *cfg) {
+	memset(f, 0, sizeof(*f));
+	f->cfg = *cfg;
+
+	if (f->cfg.median_len < 1) {
+		f->cfg.median_len = 1;
+	}
+	if (f->cfg.median_len > SIGNAL_FILTER_MEDIAN_MAX) {
+		f->cfg.median_len = SIGNAL_FILTER_MEDIAN_MAX;
+	}
+	if (f->cfg.median_len % 2 == 0) {
+		f->cfg.median_len++; // odd, so there is a middle sample
+	}
+	// Beyond this, the truncated steps leave the average stuck more than
+	// half a unit away from a constant input
+	if (f->cfg.ema_shift > SIGNAL_FILTER_FRAC - 1) {
+		f->cfg.ema_shift = SIGNAL_FILTER_FRAC - 1;
+	}
+	if (f->cfg.n_thresholds > SIGNAL_FILTER_BANDS_MAX - 1) {
+		f->cfg.n_thresholds = SIGNAL_FILTER_BANDS_MAX - 1;
+	}
+	if (f->cfg.hysteresis < 0) {
+		f->cfg.hysteresis = 0;
+	}
+}
+
+static int32_t median(const signal_filter_t *f) {
+	int32_t v[SIGNAL_FILTER_MEDIAN_MAX];
+	int n = f->fill;
+
+	// Insertion sort: at most 7 elements
+	for (int i = 0; i < n; i++) {
+		int32_t x = f->window[i];
+		int j = i;
+		while (j > 0 && v[j - 1] > x) {
+			v[j] = v[j - 1];
+			j--;
+		}
+		v[j] = x;
+	}
+	return v[(n - 1) / 2];
+}
+
+static uint8_t band_of(const signal_filter_cfg_t *cfg, int32_t v) {
+	uint8_t b = 0;
+	while (b < cfg->n_thresholds && v >= cfg->thresholds[b]) {
+		b++;
+	}
+	return b;
+}
+
+int32_t signal_filter_update(signal_filter_t *f, int32_t raw) {
+	const signal_filter_cfg_t *cfg = &f->cfg;
+	int32_t x = raw;
+
+	if (cfg->median_len > 1) {
+		f->window[f->pos] = raw;
+		f->pos = (f->pos + 1) % cfg->median_len;
+		if (f->fill < cfg->median_len) {
+			f->fill++;
+		}
+		x = median(f);
+	}
+
+	if (cfg->ema_shift) {
+		int32_t xq = x * (1 << SIGNAL_FILTER_FRAC);
+		if (!f->primed) {
+			f->ema = xq;
+		} else {
+			f->ema += (xq - f->ema) / (1 << cfg->ema_shift);
+		}
+		// Round to nearest, halves away from zero
+		int32_t half = 1 << (SIGNAL_FILTER_FRAC - 1);
+		x = (f->ema >= 0 ? f->ema + half : f->ema - half) /
+			(1 << SIGNAL_FILTER_FRAC);
+	}
+
+	if (!f->primed) {
+		f->band = band_of(cfg, x);
+	} else {
+		while (f->band < cfg->n_thresholds &&
+			   x >= cfg->thresholds[f->band] + cfg->hysteresis) {
+			f->band++;
+		}
+		while (f->band > 0 &&
+			   x < cfg->thresholds[f->band - 1] - cfg->hysteresis) {
+			f->band--;
+		}
+	}
+
+	f->primed = true;
+	return x;
+}
+
+uint8_t signal_filter_band(const signal_filter_t *f) { return f->band; }
@@ -0,0 +1,73 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Longest median window. */
+#define SIGNAL_FILTER_MEDIAN_MAX 7
+
+/** Most bands a filter can sort its output into. */
+#define SIGNAL_FILTER_BANDS_MAX 4
+
+/** Fractional bits of the EMA accumulator. */
+#define SIGNAL_FILTER_FRAC 8
+
+/**
+ * @brief Filter settings for one channel.
+ */
+typedef struct {
+	uint8_t median_len; ///< Spike rejection window (odd; 1 = off)
+	uint8_t ema_shift;	///< New sample weighs 1/2^shift (0 = off, max 7)
+	uint8_t n_thresholds;
+	int32_t thresholds[SIGNAL_FILTER_BANDS_MAX - 1]; ///< Band edges, ascending
+	int32_t hysteresis; ///< Overshoot past an edge needed to change band
+} signal_filter_cfg_t;
+
+/**
+ * @brief Per-channel state of an ingest filter.
+ *
+ * Each sample runs through three integer-only stages:
+ *  1. Median of the last median_len raw samples, which drops isolated
+ *     spikes without lagging a real step by more than median_len / 2.
+ *  2. Exponential moving average in SIGNAL_FILTER_FRAC fixed point.
+ *  3. Banding: the output is sorted into thresholds, but only leaves its
+ *     current band once it is hysteresis past the edge, so a value
+ *     hovering at an edge does not make the band flap.
+ *
+ * Values must stay within +/-2^22 (e.g. ppm, or 0.01 degC).
+ */
+typedef struct {
+	signal_filter_cfg_t cfg;
+	int32_t window[SIGNAL_FILTER_MEDIAN_MAX];
+	uint8_t fill; ///< Samples in window (< median_len while warming up)
+	uint8_t pos;  ///< Next window slot
+	bool primed;  ///< Set by the first sample
+	uint8_t band; ///< Current band, 0..n_thresholds
+	int32_t ema;  ///< Average in SIGNAL_FILTER_FRAC fixed point
+} signal_filter_t;
+
+/**
+ * @brief Reset a filter; out-of-range settings are clamped.
+ */
+void signal_filter_init(signal_filter_t *f, const signal_filter_cfg_t *cfg);
+
+/**
+ * @brief Feed one raw sample.
+ *
+ * The first sample passes through unchanged and sets the band directly.
+ *
+ * @return Filtered value, in the unit of raw.
+ */
+int32_t signal_filter_update(signal_filter_t *f, int32_t raw);
+
+/**
+ * @brief Band of the latest filtered value (0 below the first threshold).
+ */
+uint8_t signal_filter_band(const signal_filter_t *f);
+
+#ifdef __cplusplus
+}
+#endif
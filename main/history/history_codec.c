@@ -0,0 +1,199 @@
+#include "history_codec.h"
+
+#include <string.h>
+
+/* Payload width per length class; class 0 means "no change". */
+#define CLASS_COUNT 5
+static const uint8_t s_dt_width[CLASS_COUNT] = {0, 7, 9, 12, 32};
+static const uint8_t s_v_width[CLASS_COUNT] = {0, 4, 8, 16, 32};
+
+static uint32_t zigzag(uint32_t d) { return (d << 1) ^ (0u - (d >> 31)); }
+
+static uint32_t unzigzag(uint32_t z) { return (z >> 1) ^ (0u - (z & 1)); }
+
+/** Write the low n bits of v, MSB first, into a zeroed buffer. */
+static void put_bits(uint8_t *buf, uint32_t *pos, uint32_t v, int n) {
+	while (n > 0) {
+		int room = 8 - (int)(*pos % 8);
+		int take = n < room ? n : room;
+		uint32_t chunk = (v >> (n - take)) & ((1u << take) - 1);
+		buf[*pos / 8] |= (uint8_t)(chunk << (room - take));
+		*pos += take;
+		n -= take;
+	}
+}
+
+static bool get_bits(history_dec_t *d, int n, uint32_t *out) {
+	if (d->len_bits - d->pos < (uint32_t)n) {
+		return false;
+	}
+	uint32_t v = 0;
+	while (n > 0) {
+		int room = 8 - (int)(d->pos % 8);
+		int take = n < room ? n : room;
+		v = (v << take) |
+			((d->buf[d->pos / 8] >> (room - take)) & ((1u << take) - 1));
+		d->pos += take;
+		n -= take;
+	}
+	*out = v;
+	return true;
+}
+
+static int class_of(uint32_t z, const uint8_t *width) {
+	if (z == 0) {
+		return 0;
+	}
+	for (int k = 1; k < CLASS_COUNT - 1; k++) {
+		if (z < (1u << width[k])) {
+			return k;
+		}
+	}
+	return CLASS_COUNT - 1;
+}
+
+/* Prefix: k ones, then a zero unless k is the last class. */
+static int prefix_bits(int k) { return k < CLASS_COUNT - 1 ? k + 1 : k; }
+
+static void put_class(history_enc_t *e, int k, uint32_t z,
+					  const uint8_t *width) {
+	uint32_t ones = (1u << k) - 1;
+	put_bits(e->buf, &e->bits, k < CLASS_COUNT - 1 ? ones << 1 : ones,
+			 prefix_bits(k));
+	put_bits(e->buf, &e->bits, z, width[k]);
+}
+
+static bool get_class(history_dec_t *d, const uint8_t *width, uint32_t *z) {
+	int k = 0;
+	uint32_t bit = 1;
+	while (k < CLASS_COUNT - 1) {
+		if (!get_bits(d, 1, &bit)) {
+			return false;
+		}
+		if (!bit) {
+			break;
+		}
+		k++;
+	}
+	*z = 0;
+	return width[k] == 0 || get_bits(d, width[k], z);
+}
+
+void history_enc_init(history_enc_t *e, uint8_t *buf, size_t cap) {
+	memset(buf, 0, cap);
+	*e = (history_enc_t){.buf = buf, .cap_bits = (uint32_t)cap * 8};
+}
+
+bool history_enc_add(history_enc_t *e, uint32_t t_s, int32_t value) {
+	uint32_t v = (uint32_t)value;
+
+	if (e->count == 0) {
+		if (e->cap_bits - e->bits < 64) {
+			return false;
+		}
+		put_bits(e->buf, &e->bits, t_s, 32);
+		put_bits(e->buf, &e->bits, v, 32);
+		e->prev_dt = 0;
+	} else {
+		uint32_t dt = t_s - e->prev_t;
+		uint32_t zt = zigzag(dt - e->prev_dt);
+		uint32_t zv = zigzag(v - e->prev_v);
+		int kt = class_of(zt, s_dt_width);
+		int kv = class_of(zv, s_v_width);
+		uint32_t need = prefix_bits(kt) + s_dt_width[kt] + prefix_bits(kv) +
+						s_v_width[kv];
+		if (e->cap_bits - e->bits < need) {
+			return false;
+		}
+		put_class(e, kt, zt, s_dt_width);
+		put_class(e, kv, zv, s_v_width);
+		e->prev_dt = dt;
+	}
+
+	e->prev_t = t_s;
+	e->prev_v = v;
+	e->count++;
+	return true;
+}
+
+size_t history_enc_bytes(const history_enc_t *e) { return (e->bits + 7) / 8; }
+
+void history_dec_init(history_dec_t *d, const uint8_t *buf, size_t len,
+					  uint32_t count) {
+	*d = (history_dec_t){
+		.buf = buf, .len_bits = (uint32_t)len * 8, .left = count};
+}
+
+bool history_dec_next(history_dec_t *d, uint32_t *t_s, int32_t *value) {
+	if (d->left == 0) {
+		return false;
+	}
+
+	uint32_t t, v;
+	if (d->pos == 0) {
+		if (!get_bits(d, 32, &t) || !get_bits(d, 32, &v)) {
+			d->left = 0;
+			return false;
+		}
+		d->prev_dt = 0;
+	} else {
+		uint32_t zt, zv;
+		if (!get_class(d, s_dt_width, &zt) || !get_class(d, s_v_width, &zv)) {
+			d->left = 0;
+			return false;
+		}
+		d->prev_dt += unzigzag(zt);
+		t = d->prev_t + d->prev_dt;
+		v = d->prev_v + unzigzag(zv);
+	}
+
+	d->prev_t = t;
+	d->prev_v = v;
+	d->left--;
+	*t_s = t;
+	*value = (int32_t)v;
+	return true;
+}
+
+size_t history_block_encode(const uint32_t *t_s, const int32_t *values,
+							uint32_t n, uint8_t *out, size_t cap,
+							uint32_t *taken) {
+	if (taken) {
+		*taken = 0;
+	}
+	if (!t_s || !values || !out || cap <= HISTORY_BLOCK_HDR) {
+		return 0;
+	}
+
+	history_enc_t e;
+	history_enc_init(&e, out + HISTORY_BLOCK_HDR, cap - HISTORY_BLOCK_HDR);
+	while (e.count < n && e.count < UINT16_MAX &&
+		   history_enc_add(&e, t_s[e.count], values[e.count])) {
+	}
+	if (e.count == 0) {
+		return 0;
+	}
+
+	out[0] = (uint8_t)e.count;
+	out[1] = (uint8_t)(e.count >> 8);
+	if (taken) {
+		*taken = e.count;
+	}
+	return HISTORY_BLOCK_HDR + history_enc_bytes(&e);
+}
+
+uint32_t history_block_decode(const uint8_t *in, size_t len, uint32_t *t_s,
+							  int32_t *values, uint32_t max) {
+	if (!in || !t_s || !values || len < HISTORY_BLOCK_HDR) {
+		return 0;
+	}
+
+	history_dec_t d;
+	history_dec_init(&d, in + HISTORY_BLOCK_HDR, len - HISTORY_BLOCK_HDR,
+					 in[0] | (uint32_t)in[1] << 8);
+	uint32_t n = 0;
+	while (n < max && history_dec_next(&d, &t_s[n], &values[n])) {
+		n++;
+	}
+	return n;
+}
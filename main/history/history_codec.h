@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Gorilla-style bit stream for (timestamp, fixed-point value) series.
+ *
+ * The first sample is stored as two raw 32-bit words. After that each
+ * timestamp is coded as its delta-of-delta and each value as its delta
+ * from the previous one, both zig-zag mapped and written in one of five
+ * length classes:
+ *
+ *   prefix   timestamp payload   value payload
+ *   0        -                   -               (unchanged)
+ *   10       7 bits              4 bits
+ *   110      9 bits              8 bits
+ *   1110     12 bits             16 bits
+ *   1111     32 bits             32 bits
+ *
+ * A sensor sampled at a fixed period with a slowly moving reading costs
+ * 2 to 7 bits per sample; the worst case is HISTORY_CODEC_MAX_BITS.
+ * Arithmetic wraps modulo 2^32, so any int32 series round-trips exactly.
+ *
+ * The block API serves the RAM raw tier (history_store.c). The flash log
+ * (history_log.c) does not use it: it appends one CRC-checked record per
+ * minute so that each minute is durable on its own, and a block holding a
+ * single minute would only add a header. Its partition already holds more
+ * than the 31 days replayed at boot.
+ */
+
+/** Largest encoding of one sample, in bits (the first sample is 64). */
+#define HISTORY_CODEC_MAX_BITS 72
+
+/**
+ * @brief Streaming encoder writing into a caller-owned buffer.
+ */
+typedef struct {
+	uint8_t *buf;
+	uint32_t cap_bits;
+	uint32_t bits;	///< Bits written so far
+	uint32_t count; ///< Samples written so far
+	uint32_t prev_t;
+	uint32_t prev_dt;
+	uint32_t prev_v;
+} history_enc_t;
+
+/**
+ * @brief Streaming decoder over an encoded buffer.
+ */
+typedef struct {
+	const uint8_t *buf;
+	uint32_t len_bits;
+	uint32_t pos;  ///< Next bit to read
+	uint32_t left; ///< Samples still to decode
+	uint32_t prev_t;
+	uint32_t prev_dt;
+	uint32_t prev_v;
+} history_dec_t;
+
+/**
+ * @brief Start a new stream in buf (zeroed here).
+ */
+void history_enc_init(history_enc_t *e, uint8_t *buf, size_t cap);
+
+/**
+ * @brief Append one sample.
+ *
+ * @return true if it was written, false if it does not fit; the stream is
+ *         left unchanged and stays decodable.
+ */
+bool history_enc_add(history_enc_t *e, uint32_t t_s, int32_t value);
+
+/** Bytes of buf used so far. */
+size_t history_enc_bytes(const history_enc_t *e);
+
+/**
+ * @brief Start decoding count samples from buf.
+ */
+void history_dec_init(history_dec_t *d, const uint8_t *buf, size_t len,
+					  uint32_t count);
+
+/**
+ * @brief Decode the next sample.
+ *
+ * @return false once count samples were read or the buffer ends early.
+ */
+bool history_dec_next(history_dec_t *d, uint32_t *t_s, int32_t *value);
+
+/** Header of a self-describing block: sample count, little-endian. */
+#define HISTORY_BLOCK_HDR 2
+
+/**
+ * @brief Encode as many samples as fit into a self-describing block.
+ *
+ * @param[in]  t_s     Timestamps.
+ * @param[in]  values  Values.
+ * @param[in]  n       Samples available (at most UINT16_MAX are taken).
+ * @param[out] out     Block buffer.
+ * @param[in]  cap     Size of out.
+ * @param[out] taken   Optional: samples encoded, 0..n.
+ *
+ * @return Block length in bytes, or 0 if not even one sample fits.
+ */
+size_t history_block_encode(const uint32_t *t_s, const int32_t *values,
+							uint32_t n, uint8_t *out, size_t cap,
+							uint32_t *taken);
+
+/**
+ * @brief Decode a block written by history_block_encode().
+ *
+ * @return Samples written to t_s/values (at most max).
+ */
+uint32_t history_block_decode(const uint8_t *in, size_t len, uint32_t *t_s,
+							  int32_t *values, uint32_t max);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,425 @@
+#include "history_log.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#include "history_store.h"
+#include "sntp.h" // sntp_service_time_is_set()
+
+#define TAG "history_log"
+
+/* Custom data subtype of the "history" partition (see partitions.csv). */
+#define HISTORY_LOG_SUBTYPE 0x40
+#define HISTORY_LOG_LABEL "history"
+
+#define LOG_SECTOR_SIZE 4096
+#define LOG_SLOT_SIZE 64
+/* Slot 0 of every sector holds its header; the rest hold records. */
+#define LOG_SLOTS (LOG_SECTOR_SIZE / LOG_SLOT_SIZE)
+
+#define LOG_SECTOR_MAGIC 0x474f4c48 // "HLOG"
+
+/* Replay window at boot: what the 15-minute tier can hold. */
+#define LOG_RESTORE_S (31u * 24 * 3600)
+
+/* Most minutes per query and flash write (bounds the task's buffers). */
+#define LOG_BATCH_MAX 16
+
+/**
+ * @brief Sector header, written right after the sector is erased.
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t seq; ///< Increments by one per sector written, never reused
+	uint8_t reserved[LOG_SLOT_SIZE - 12];
+	uint32_t crc; ///< CRC32 of the bytes before it
+} log_header_t;
+
+/**
+ * @brief One minute of rollups for every channel.
+ *
+ * min and max are stored as unsigned distances from the mean, which keeps
+ * the record at one slot while covering each channel's full range.
+ */
+typedef struct {
+	uint32_t unix_s;					   ///< Minute start (Unix time)
+	int32_t mean[HISTORY_CHANNEL_COUNT];   ///< Mean per channel
+	uint16_t below[HISTORY_CHANNEL_COUNT]; ///< mean - min
+	uint16_t above[HISTORY_CHANNEL_COUNT]; ///< max - mean
+	uint8_t count[HISTORY_CHANNEL_COUNT];  ///< Samples (saturates at 255)
+	uint8_t mask;						   ///< Channels present (bit = channel)
+	uint8_t reserved[LOG_SLOT_SIZE - 45];
+	uint32_t crc; ///< CRC32 of the bytes before it
+} log_record_t;
+
+_Static_assert(sizeof(log_header_t) == LOG_SLOT_SIZE, "header size");
+_Static_assert(sizeof(log_record_t) == LOG_SLOT_SIZE, "record size");
+
+static const esp_partition_t *s_part;
+static uint32_t s_sectors;
+
+/* Write position (history_log task only after start). */
+static uint32_t s_head;		///< Sector being filled
+static uint32_t s_head_seq; ///< Its sequence number
+static uint32_t s_slot;		///< Next free slot in it; 0 = no sector open
+
+/* Newest minute already in flash, on the history clock. */
+static uint32_t s_last_t_s;
+
+static uint32_t slot_crc(const void *slot) {
+	return esp_rom_crc32_le(0, slot, LOG_SLOT_SIZE - sizeof(uint32_t));
+}
+
+static bool slot_erased(const uint8_t *slot) {
+	for (int i = 0; i < LOG_SLOT_SIZE; i++) {
+		if (slot[i] != 0xFF) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool header_valid(const log_header_t *h) {
+	return h->magic == LOG_SECTOR_MAGIC && h->crc == slot_crc(h);
+}
+
+/**
+ * @brief Find the newest valid sector and the first free slot in it.
+ *
+ * @return Number of valid sectors in the partition (0 = empty log).
+ */
+static uint32_t scan_headers(uint8_t *sector_buf) {
+	uint32_t valid = 0;
+	bool found = false;
+
+	for (uint32_t i = 0; i < s_sectors; i++) {
+		log_header_t h;
+		if (esp_partition_read(s_part, i * LOG_SECTOR_SIZE, &h, sizeof(h)) !=
+				ESP_OK ||
+			!header_valid(&h)) {
+			continue;
+		}
+		valid++;
+		if (!found || (int32_t)(h.seq - s_head_seq) > 0) {
+			found = true;
+			s_head = i;
+			s_head_seq = h.seq;
+		}
+	}
+	if (!found) {
+		s_slot = 0;
+		return 0;
+	}
+
+	// Resume after the last slot that was written, torn or not
+	s_slot = LOG_SLOTS;
+	if (esp_partition_read(s_part, s_head * LOG_SECTOR_SIZE, sector_buf,
+						   LOG_SECTOR_SIZE) == ESP_OK) {
+		uint32_t next = 1;
+		for (uint32_t k = LOG_SLOTS - 1; k >= 1; k--) {
+			if (!slot_erased(sector_buf + k * LOG_SLOT_SIZE)) {
+				next = k + 1;
+				break;
+			}
+		}
+		s_slot = next;
+	}
+	return valid;
+}
+
+/**
+ * @brief Replay one record into the history store.
+ *
+ * @return 1 if any channel was restored, else 0.
+ */
+static int restore_record(const log_record_t *rec, uint32_t now_unix,
+						  uint32_t now_t_s) {
+	uint32_t age = now_unix - rec->unix_s;
+	if (rec->unix_s > now_unix || age > LOG_RESTORE_S || age >= now_t_s) {
+		return 0;
+	}
+
+	int restored = 0;
+	for (int ch = 0; ch < HISTORY_CHANNEL_COUNT; ch++) {
+		if (!(rec->mask & (1u << ch)) || rec->count[ch] == 0) {
+			continue;
+		}
+		history_point_t pt = {
+			.t_s = now_t_s - age,
+			.min = rec->mean[ch] - rec->below[ch],
+			.max = rec->mean[ch] + rec->above[ch],
+			.mean = rec->mean[ch],
+			.count = rec->count[ch],
+		};
+		if (history_restore((history_channel_t)ch, &pt) == ESP_OK) {
+			restored = 1;
+		}
+	}
+	if (restored) {
+		s_last_t_s = now_t_s - age;
+	}
+	return restored;
+}
+
+/**
+ * @brief Length of the run of sectors with consecutive sequence numbers
+ * that ends at the head. Older leftovers past a gap are not part of the log.
+ */
+static uint32_t log_length(void) {
+	uint32_t len = 1;
+	while (len < s_sectors) {
+		uint32_t sector = (s_head + s_sectors - len) % s_sectors;
+		log_header_t h;
+		if (esp_partition_read(s_part, sector * LOG_SECTOR_SIZE, &h,
+							   sizeof(h)) != ESP_OK ||
+			!header_valid(&h) || h.seq != s_head_seq - len) {
+			break;
+		}
+		len++;
+	}
+	return len;
+}
+
+/**
+ * @brief Replay the log from its oldest sector to the head.
+ */
+static void restore(uint8_t *sector_buf) {
+	if (!sntp_service_time_is_set()) {
+		ESP_LOGW(TAG, "Clock not set, stored history not restored");
+		return;
+	}
+
+	int64_t start_us = esp_timer_get_time();
+	uint32_t now_unix = (uint32_t)time(NULL);
+	uint32_t now_t_s = history_now_s();
+	uint32_t records = 0;
+
+	for (uint32_t n = log_length(); n-- > 0;) {
+		uint32_t sector = (s_head + s_sectors - n) % s_sectors;
+		if (esp_partition_read(s_part, sector * LOG_SECTOR_SIZE, sector_buf,
+							   LOG_SECTOR_SIZE) != ESP_OK) {
+			continue;
+		}
+		for (uint32_t k = 1; k < LOG_SLOTS; k++) {
+			const log_record_t *rec =
+				(const log_record_t *)(sector_buf + k * LOG_SLOT_SIZE);
+			if (rec->crc == slot_crc(rec)) {
+				records += restore_record(rec, now_unix, now_t_s);
+			}
+		}
+	}
+
+	ESP_LOGI(TAG, "Restored %" PRIu32 " minutes in %" PRId64 " ms", records,
+			 (esp_timer_get_time() - start_us) / 1000);
+}
+
+/**
+ * @brief Erase the next sector and write its header.
+ */
+static esp_err_t open_next_sector(void) {
+	uint32_t sector = s_slot == 0 ? 0 : (s_head + 1) % s_sectors;
+	uint32_t seq = s_head_seq + 1;
+
+	esp_err_t err = esp_partition_erase_range(
+		s_part, sector * LOG_SECTOR_SIZE, LOG_SECTOR_SIZE);
+	if (err != ESP_OK) {
+		return err;
+	}
+
+	log_header_t h = {.magic = LOG_SECTOR_MAGIC, .seq = seq};
+	memset(h.reserved, 0xFF, sizeof(h.reserved));
+	h.crc = slot_crc(&h);
+	err = esp_partition_write(s_part, sector * LOG_SECTOR_SIZE, &h, sizeof(h));
+	if (err != ESP_OK) {
+		return err;
+	}
+
+	s_head = sector;
+	s_head_seq = seq;
+	s_slot = 1;
+	return ESP_OK;
+}
+
+/**
+ * @brief Append records, one flash write per sector touched.
+ */
+static esp_err_t append(const log_record_t *recs, int n) {
+	while (n > 0) {
+		if (s_slot == 0 || s_slot >= LOG_SLOTS) {
+			esp_err_t err = open_next_sector();
+			if (err != ESP_OK) {
+				return err;
+			}
+		}
+		int fit = (int)(LOG_SLOTS - s_slot);
+		int k = n < fit ? n : fit;
+		esp_err_t err = esp_partition_write(
+			s_part, s_head * LOG_SECTOR_SIZE + s_slot * LOG_SLOT_SIZE, recs,
+			(size_t)k * LOG_SLOT_SIZE);
+		// Skip the slots even on failure: they may be partly written
+		s_slot += k;
+		if (err != ESP_OK) {
+			return err;
+		}
+		recs += k;
+		n -= k;
+	}
+	return ESP_OK;
+}
+
+static uint16_t clamp_u16(int64_t v) {
+	return v < 0 ? 0 : v > UINT16_MAX ? UINT16_MAX : (uint16_t)v;
+}
+
+/**
+ * @brief Turn the minutes in [from_s, to_s] into records.
+ *
+ * The window spans at most LOG_BATCH_MAX minutes, so the queries return all
+ * of its points rather than only the newest.
+ *
+ * @return Number of records built.
+ */
+static int collect(log_record_t *recs, uint32_t from_s, uint32_t to_s,
+				   uint32_t now_t_s, uint32_t now_unix) {
+	history_point_t pts[HISTORY_CHANNEL_COUNT][LOG_BATCH_MAX];
+	int n[HISTORY_CHANNEL_COUNT];
+	int pos[HISTORY_CHANNEL_COUNT] = {0};
+	for (int ch = 0; ch < HISTORY_CHANNEL_COUNT; ch++) {
+		n[ch] = history_query((history_channel_t)ch, HISTORY_TIER_1MIN, from_s,
+							  to_s, pts[ch], LOG_BATCH_MAX);
+	}
+
+	// Merge the channels' minutes in time order, one record per minute
+	int out = 0;
+	while (out < LOG_BATCH_MAX) {
+		uint32_t t = UINT32_MAX;
+		for (int ch = 0; ch < HISTORY_CHANNEL_COUNT; ch++) {
+			if (pos[ch] < n[ch] && pts[ch][pos[ch]].t_s < t) {
+				t = pts[ch][pos[ch]].t_s;
+			}
+		}
+		if (t == UINT32_MAX) {
+			break;
+		}
+
+		log_record_t *rec = &recs[out++];
+		memset(rec, 0, sizeof(*rec));
+		memset(rec->reserved, 0xFF, sizeof(rec->reserved));
+		rec->unix_s = now_unix - (now_t_s - t);
+		for (int ch = 0; ch < HISTORY_CHANNEL_COUNT; ch++) {
+			if (pos[ch] >= n[ch] || pts[ch][pos[ch]].t_s != t) {
+				continue;
+			}
+			const history_point_t *pt = &pts[ch][pos[ch]++];
+			rec->mask |= 1u << ch;
+			rec->mean[ch] = pt->mean;
+			rec->below[ch] = clamp_u16((int64_t)pt->mean - pt->min);
+			rec->above[ch] = clamp_u16((int64_t)pt->max - pt->mean);
+			rec->count[ch] = pt->count > UINT8_MAX ? UINT8_MAX : pt->count;
+		}
+		rec->crc = slot_crc(rec);
+	}
+	return out;
+}
+
+/**
+ * @brief Write every closed minute after s_last_t_s, oldest first.
+ *
+ * s_last_t_s only moves past minutes that reached flash, so a failed write
+ * is retried on the next flush.
+ */
+static void flush(log_record_t *recs) {
+	uint32_t now_t_s = history_now_s();
+	uint32_t now_unix = (uint32_t)time(NULL);
+
+	// Minutes are complete once the clock has moved past them
+	uint32_t to = now_t_s - now_t_s % 60 - 1;
+	// Anything older has already left the 1-minute tier
+	uint32_t from = to + 1 - HISTORY_1MIN_LEN * 60;
+	if (s_last_t_s >= from) {
+		from = s_last_t_s + 1;
+	}
+
+	int total = 0;
+	while (from <= to) {
+		uint32_t end = to - from < LOG_BATCH_MAX * 60
+						   ? to
+						   : from + LOG_BATCH_MAX * 60 - 1;
+		int n = collect(recs, from, end, now_t_s, now_unix);
+		if (n > 0) {
+			esp_err_t err = append(recs, n);
+			if (err != ESP_OK) {
+				ESP_LOGW(TAG, "Write failed: %s", esp_err_to_name(err));
+				break;
+			}
+			total += n;
+		}
+		s_last_t_s = end;
+		from = end + 1;
+	}
+	if (total > 0) {
+		ESP_LOGD(TAG, "Logged %d minute(s), sector %" PRIu32, total, s_head);
+	}
+}
+
+static void history_log_task(void *arg) {
+	(void)arg;
+	static log_record_t recs[LOG_BATCH_MAX];
+	const TickType_t period =
+		pdMS_TO_TICKS(CONFIG_HISTORY_LOG_FLUSH_MIN * 60 * 1000);
+	TickType_t last = xTaskGetTickCount();
+
+	for (;;) {
+		vTaskDelayUntil(&last, period);
+		if (!sntp_service_time_is_set()) {
+			continue; // records need Unix time; the minutes stay in RAM
+		}
+		flush(recs);
+	}
+}
+
+esp_err_t history_log_start(void) {
+	if (s_part) {
+		return ESP_OK;
+	}
+
+	const esp_partition_t *part = esp_partition_find_first(
+		ESP_PARTITION_TYPE_DATA, HISTORY_LOG_SUBTYPE, HISTORY_LOG_LABEL);
+	if (!part) {
+		ESP_LOGW(TAG, "No '%s' partition, history not persisted",
+				 HISTORY_LOG_LABEL);
+		return ESP_ERR_NOT_FOUND;
+	}
+	s_part = part;
+	s_sectors = part->size / LOG_SECTOR_SIZE;
+
+	uint8_t *buf = heap_caps_malloc(LOG_SECTOR_SIZE, MALLOC_CAP_8BIT);
+	if (!buf) {
+		s_part = NULL;
+		return ESP_ERR_NO_MEM;
+	}
+	uint32_t valid = scan_headers(buf);
+	ESP_LOGI(TAG, "%" PRIu32 " of %" PRIu32 " sectors in use, head %" PRIu32,
+			 valid, s_sectors, s_head);
+	if (valid) {
+		restore(buf);
+	}
+	heap_caps_free(buf);
+
+	if (xTaskCreatePinnedToCore(history_log_task, "history_log", 4096, NULL,
+								3, NULL, 0) != pdPASS) {
+		return ESP_ERR_NO_MEM;
+	}
+	return ESP_OK;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Restore persisted history, then start logging new minutes.
+ *
+ * The "history" data partition holds an append-only log of 64-byte
+ * records, one per minute, each carrying that minute's rollup for every
+ * channel. It is written in 4 KB sectors used round-robin: a sector is
+ * erased only when the log wraps onto it, so wear is spread evenly over
+ * the whole partition.
+ *
+ * At start the sector headers are scanned to find the newest sector, and
+ * the records of the last 31 days are replayed into the history store
+ * with history_restore(). This needs a valid wall clock (records are
+ * stamped in Unix time), so call it after SNTP had its chance to sync and
+ * before sensors start sampling.
+ *
+ * A "history_log" task then appends the closed 1-minute rollups every
+ * CONFIG_HISTORY_LOG_FLUSH_MIN minutes, in one flash write per batch.
+ *
+ * Crash safety: every record and sector header carries a CRC32. A record
+ * torn by a reset fails its CRC and is skipped; a sector whose erase or
+ * header write was interrupted is not part of the log and is erased again
+ * on next use.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND if the partition table has no history partition
+ *      - ESP_ERR_NO_MEM if the task cannot be created
+ */
+esp_err_t history_log_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,522 @@
+#include "history_store.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "history_codec.h"
+
+#define TAG "history"
+
+/**
+ * @brief Fixed-capacity ring of points, oldest overwritten first.
+ */
+typedef struct {
+	history_point_t *buf;
+	uint32_t cap;
+	uint32_t head;	///< Next slot to write
+	uint32_t count; ///< Valid points (<= cap)
+} ring_t;
+
+/**
+ * @brief Raw samples, compressed with history_codec.
+ */
+typedef struct {
+	uint32_t first_t_s; ///< Time of the block's first sample
+	uint32_t count;		///< Samples encoded in data
+	uint8_t data[HISTORY_RAW_BLOCK_BYTES];
+} raw_block_t;
+
+/**
+ * @brief Ring of raw blocks; the newest is still being appended to and the
+ * oldest is dropped whole when a new one is needed.
+ */
+typedef struct {
+	raw_block_t *blocks;
+	uint32_t head;	   ///< Next block to open
+	uint32_t count;	   ///< Blocks in use (<= HISTORY_RAW_BLOCKS)
+	history_enc_t enc; ///< Encoder of the newest block
+} raw_ring_t;
+
+/**
+ * @brief Walks the raw samples of a channel in time order.
+ */
+typedef struct {
+	const raw_ring_t *r;
+	uint32_t block;
+	history_dec_t dec;
+} raw_iter_t;
+
+/**
+ * @brief Rollup bucket still receiving samples.
+ */
+typedef struct {
+	uint32_t t_s; ///< Bucket start
+	int32_t min;
+	int32_t max;
+	int64_t sum;
+	uint32_t count; ///< 0 = no bucket open
+} bucket_t;
+
+typedef struct {
+	raw_ring_t raw;
+	ring_t rings[HISTORY_TIER_COUNT];  ///< Unused for the raw tier
+	bucket_t open[HISTORY_TIER_COUNT]; ///< Unused for the raw tier
+	uint32_t first_t_s;				   ///< Oldest data ever recorded/restored
+	uint32_t last_t_s;
+	bool has_last;
+} channel_t;
+
+/* Bucket length per tier in seconds (raw points have none). */
+static const uint32_t s_bucket_s[HISTORY_TIER_COUNT] = {0, 60, 15 * 60};
+
+static const uint32_t s_ring_len[HISTORY_TIER_COUNT] = {
+	0,
+	HISTORY_1MIN_LEN,
+	HISTORY_15MIN_LEN,
+};
+
+static channel_t s_channels[HISTORY_CHANNEL_COUNT];
+
+/*
+ * Appends come from the sampler task and take microseconds; queries copy at
+ * most one ring. A mutex keeps a query from disabling interrupts for that
+ * long, at the cost of the sampler occasionally waiting on the UI.
+ */
+static SemaphoreHandle_t s_mu;
+
+static history_point_t *ring_at(const ring_t *r, uint32_t i) {
+	return &r->buf[(r->head + r->cap - r->count + i) % r->cap];
+}
+
+static void ring_push(ring_t *r, const history_point_t *pt) {
+	r->buf[r->head] = *pt;
+	r->head = (r->head + 1) % r->cap;
+	if (r->count < r->cap) {
+		r->count++;
+	}
+}
+
+/** Index of the first point starting at or after t_s (count if none). */
+static uint32_t ring_lower_bound(const ring_t *r, uint32_t t_s) {
+	uint32_t lo = 0, hi = r->count;
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (ring_at(r, mid)->t_s < t_s) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+static raw_block_t *raw_block_at(const raw_ring_t *r, uint32_t i) {
+	return &r->blocks[(r->head + HISTORY_RAW_BLOCKS - r->count + i) %
+					  HISTORY_RAW_BLOCKS];
+}
+
+static void raw_push(raw_ring_t *r, uint32_t t_s, int32_t value) {
+	if (r->count && history_enc_add(&r->enc, t_s, value)) {
+		raw_block_at(r, r->count - 1)->count = r->enc.count;
+		return;
+	}
+
+	// Newest block is full: open the next one, dropping the oldest
+	raw_block_t *b = &r->blocks[r->head];
+	r->head = (r->head + 1) % HISTORY_RAW_BLOCKS;
+	if (r->count < HISTORY_RAW_BLOCKS) {
+		r->count++;
+	}
+	history_enc_init(&r->enc, b->data, sizeof(b->data));
+	history_enc_add(&r->enc, t_s, value); // always fits an empty block
+	b->first_t_s = t_s;
+	b->count = 1;
+}
+
+static void raw_iter_open(raw_iter_t *it) {
+	const raw_block_t *b = raw_block_at(it->r, it->block);
+	history_dec_init(&it->dec, b->data, sizeof(b->data), b->count);
+}
+
+/** Position before the first sample at or after t_s (may be earlier). */
+static void raw_iter_init(raw_iter_t *it, const raw_ring_t *r, uint32_t t_s) {
+	// Last block starting at or before t_s; later ones start after it
+	uint32_t lo = 0, hi = r->count;
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (raw_block_at(r, mid)->first_t_s <= t_s) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	*it = (raw_iter_t){.r = r, .block = lo ? lo - 1 : 0};
+	if (r->count) {
+		raw_iter_open(it);
+	}
+}
+
+static bool raw_iter_next(raw_iter_t *it, uint32_t *t_s, int32_t *value) {
+	if (it->r->count == 0) {
+		return false;
+	}
+	while (!history_dec_next(&it->dec, t_s, value)) {
+		if (++it->block >= it->r->count) {
+			return false;
+		}
+		raw_iter_open(it);
+	}
+	return true;
+}
+
+/** Next raw sample within [from_s, to_s], as a point. */
+static bool raw_iter_next_in(raw_iter_t *it, uint32_t from_s, uint32_t to_s,
+							 history_point_t *pt) {
+	uint32_t t;
+	int32_t v;
+	while (raw_iter_next(it, &t, &v)) {
+		if (t > to_s) {
+			return false;
+		}
+		if (t >= from_s) {
+			*pt = (history_point_t){
+				.t_s = t, .min = v, .max = v, .mean = v, .count = 1};
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Start of the oldest point a tier still holds. */
+static bool tier_oldest(const channel_t *c, history_tier_t tier,
+						uint32_t *t_s) {
+	if (tier == HISTORY_TIER_RAW) {
+		if (c->raw.count == 0) {
+			return false;
+		}
+		*t_s = raw_block_at(&c->raw, 0)->first_t_s;
+		return true;
+	}
+	const ring_t *r = &c->rings[tier];
+	if (r->count == 0) {
+		return false;
+	}
+	*t_s = ring_at(r, 0)->t_s;
+	return true;
+}
+
+static int32_t rounded_mean(int64_t sum, uint32_t count) {
+	int64_t half = count / 2;
+	return (int32_t)(sum >= 0 ? (sum + half) / count : (sum - half) / count);
+}
+
+static history_point_t bucket_point(const bucket_t *b) {
+	return (history_point_t){
+		.t_s = b->t_s,
+		.min = b->min,
+		.max = b->max,
+		.mean = rounded_mean(b->sum, b->count),
+		.count = b->count,
+	};
+}
+
+/** Fold one raw sample into a tier's open bucket, closing the old one. */
+static void bucket_add(channel_t *c, history_tier_t tier, uint32_t t_s,
+					   int32_t value) {
+	bucket_t *b = &c->open[tier];
+	uint32_t start = t_s - t_s % s_bucket_s[tier];
+
+	if (b->count && b->t_s != start) {
+		history_point_t pt = bucket_point(b);
+		ring_push(&c->rings[tier], &pt);
+		b->count = 0;
+	}
+	if (b->count == 0) {
+		*b = (bucket_t){.t_s = start, .min = value, .max = value};
+	}
+	if (value < b->min) {
+		b->min = value;
+	}
+	if (value > b->max) {
+		b->max = value;
+	}
+	b->sum += value;
+	b->count++;
+}
+
+esp_err_t history_store_init(void) {
+	if (s_mu) {
+		return ESP_OK;
+	}
+
+	size_t per_channel = HISTORY_RAW_BLOCKS * sizeof(raw_block_t);
+	for (int t = 0; t < HISTORY_TIER_COUNT; t++) {
+		per_channel += s_ring_len[t] * sizeof(history_point_t);
+	}
+	size_t bytes = per_channel * HISTORY_CHANNEL_COUNT;
+
+	uint8_t *pool = heap_caps_calloc(1, bytes, MALLOC_CAP_SPIRAM);
+	if (!pool) {
+		ESP_LOGE(TAG, "No PSRAM for %u bytes of history", (unsigned)bytes);
+		return ESP_ERR_NO_MEM;
+	}
+
+	for (int ch = 0; ch < HISTORY_CHANNEL_COUNT; ch++) {
+		s_channels[ch].raw = (raw_ring_t){.blocks = (raw_block_t *)pool};
+		pool += HISTORY_RAW_BLOCKS * sizeof(raw_block_t);
+		for (int t = HISTORY_TIER_1MIN; t < HISTORY_TIER_COUNT; t++) {
+			s_channels[ch].rings[t] = (ring_t){
+				.buf = (history_point_t *)pool, .cap = s_ring_len[t]};
+			pool += s_ring_len[t] * sizeof(history_point_t);
+		}
+	}
+
+	SemaphoreHandle_t mu = xSemaphoreCreateMutex();
+	if (!mu) {
+		heap_caps_free(s_channels[0].raw.blocks);
+		memset(s_channels, 0, sizeof(s_channels));
+		return ESP_ERR_NO_MEM;
+	}
+	s_mu = mu;
+
+	ESP_LOGI(TAG, "%u KB of PSRAM for %d channels", (unsigned)(bytes / 1024),
+			 HISTORY_CHANNEL_COUNT);
+	return ESP_OK;
+}
+
+uint32_t history_now_s(void) {
+	return HISTORY_BOOT_T_S + (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+void history_record(history_channel_t ch, uint32_t t_s, int32_t value) {
+	if (!s_mu || (int)ch < 0 || ch >= HISTORY_CHANNEL_COUNT) {
+		return;
+	}
+
+	xSemaphoreTake(s_mu, portMAX_DELAY);
+
+	channel_t *c = &s_channels[ch];
+	if (!c->has_last || t_s >= c->last_t_s) {
+		if (!c->has_last) {
+			c->first_t_s = t_s;
+		}
+		c->has_last = true;
+		c->last_t_s = t_s;
+
+		raw_push(&c->raw, t_s, value);
+		for (int t = HISTORY_TIER_1MIN; t < HISTORY_TIER_COUNT; t++) {
+			bucket_add(c, (history_tier_t)t, t_s, value);
+		}
+	}
+
+	xSemaphoreGive(s_mu);
+}
+
+esp_err_t history_restore(history_channel_t ch, const history_point_t *minute) {
+	if (!minute || minute->count == 0 || (int)ch < 0 ||
+		ch >= HISTORY_CHANNEL_COUNT) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	if (!s_mu) {
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	esp_err_t err = ESP_OK;
+	xSemaphoreTake(s_mu, portMAX_DELAY);
+
+	channel_t *c = &s_channels[ch];
+	if (c->has_last && minute->t_s <= c->last_t_s) {
+		err = ESP_ERR_INVALID_STATE;
+	} else {
+		if (!c->has_last) {
+			c->first_t_s = minute->t_s;
+		}
+		c->has_last = true;
+		c->last_t_s = minute->t_s;
+		ring_push(&c->rings[HISTORY_TIER_1MIN], minute);
+
+		// Same as bucket_add(), but merging a whole minute at once
+		bucket_t *b = &c->open[HISTORY_TIER_15MIN];
+		uint32_t start =
+			minute->t_s - minute->t_s % s_bucket_s[HISTORY_TIER_15MIN];
+		if (b->count && b->t_s != start) {
+			history_point_t pt = bucket_point(b);
+			ring_push(&c->rings[HISTORY_TIER_15MIN], &pt);
+			b->count = 0;
+		}
+		if (b->count == 0) {
+			*b = (bucket_t){
+				.t_s = start, .min = minute->min, .max = minute->max};
+		}
+		if (minute->min < b->min) {
+			b->min = minute->min;
+		}
+		if (minute->max > b->max) {
+			b->max = minute->max;
+		}
+		b->sum += (int64_t)minute->mean * minute->count;
+		b->count += minute->count;
+	}
+
+	xSemaphoreGive(s_mu);
+	return err;
+}
+
+/** history_query() on the raw tier: two passes, to keep the newest max. */
+static int raw_query(const raw_ring_t *r, uint32_t from_s, uint32_t to_s,
+					 history_point_t *out, int max) {
+	raw_iter_t it;
+	history_point_t pt;
+	uint32_t total = 0;
+	raw_iter_init(&it, r, from_s);
+	while (raw_iter_next_in(&it, from_s, to_s, &pt)) {
+		total++;
+	}
+
+	uint32_t skip = total > (uint32_t)max ? total - (uint32_t)max : 0;
+	int n = 0;
+	raw_iter_init(&it, r, from_s);
+	while (n < max && raw_iter_next_in(&it, from_s, to_s, &pt)) {
+		if (skip) {
+			skip--;
+		} else {
+			out[n++] = pt;
+		}
+	}
+	return n;
+}
+
+int history_query(history_channel_t ch, history_tier_t tier, uint32_t from_s,
+				  uint32_t to_s, history_point_t *out, int max) {
+	if (!s_mu || !out || max <= 0 || (int)ch < 0 ||
+		ch >= HISTORY_CHANNEL_COUNT || (int)tier < 0 ||
+		tier >= HISTORY_TIER_COUNT || from_s > to_s) {
+		return 0;
+	}
+
+	xSemaphoreTake(s_mu, portMAX_DELAY);
+
+	const channel_t *c = &s_channels[ch];
+	if (tier == HISTORY_TIER_RAW) {
+		int n = raw_query(&c->raw, from_s, to_s, out, max);
+		xSemaphoreGive(s_mu);
+		return n;
+	}
+
+	const ring_t *r = &c->rings[tier];
+	const bucket_t *open = &c->open[tier];
+	bool open_in = open->count && open->t_s >= from_s && open->t_s <= to_s;
+
+	uint32_t lo = ring_lower_bound(r, from_s);
+	uint32_t hi = to_s == UINT32_MAX ? r->count : ring_lower_bound(r, to_s + 1);
+	uint32_t room = (uint32_t)max - (open_in ? 1 : 0);
+	if (hi - lo > room) {
+		lo = hi - room; // keep the newest
+	}
+
+	int n = 0;
+	for (uint32_t i = lo; i < hi; i++) {
+		out[n++] = *ring_at(r, i);
+	}
+	if (open_in) {
+		out[n++] = bucket_point(open);
+	}
+
+	xSemaphoreGive(s_mu);
+	return n;
+}
+
+/** Fold a point into a running aggregate (sum carried in *sum). */
+static void summary_add(history_point_t *acc, int64_t *sum,
+						const history_point_t *pt) {
+	if (acc->count == 0) {
+		acc->t_s = pt->t_s;
+		acc->min = pt->min;
+		acc->max = pt->max;
+	}
+	if (pt->min < acc->min) {
+		acc->min = pt->min;
+	}
+	if (pt->max > acc->max) {
+		acc->max = pt->max;
+	}
+	*sum += (int64_t)pt->mean * pt->count;
+	acc->count += pt->count;
+}
+
+static esp_err_t summary_finish(history_point_t *acc, int64_t sum,
+								history_point_t *out) {
+	if (acc->count == 0) {
+		return ESP_ERR_NOT_FOUND;
+	}
+	acc->mean = rounded_mean(sum, acc->count);
+	*out = *acc;
+	return ESP_OK;
+}
+
+esp_err_t history_summary(history_channel_t ch, uint32_t from_s,
+						  uint32_t to_s, history_point_t *out) {
+	if (!out || (int)ch < 0 || ch >= HISTORY_CHANNEL_COUNT || from_s > to_s) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	if (!s_mu) {
+		return ESP_ERR_NOT_FOUND;
+	}
+
+	xSemaphoreTake(s_mu, portMAX_DELAY);
+
+	const channel_t *c = &s_channels[ch];
+
+	// Finest tier that reaches back to from_s, or to the channel's oldest
+	// data (the raw ring lacks restored minutes, so it can fall short)
+	uint32_t need = from_s > c->first_t_s ? from_s : c->first_t_s;
+	history_tier_t tier = HISTORY_TIER_COUNT - 1;
+	for (int t = 0; t < HISTORY_TIER_COUNT; t++) {
+		uint32_t oldest;
+		if (tier_oldest(c, (history_tier_t)t, &oldest) && oldest <= need) {
+			tier = (history_tier_t)t;
+			break;
+		}
+	}
+
+	history_point_t acc = {0};
+	int64_t sum = 0;
+	if (tier == HISTORY_TIER_RAW) {
+		raw_iter_t it;
+		history_point_t pt;
+		raw_iter_init(&it, &c->raw, from_s);
+		while (raw_iter_next_in(&it, from_s, to_s, &pt)) {
+			summary_add(&acc, &sum, &pt);
+		}
+		xSemaphoreGive(s_mu);
+		return summary_finish(&acc, sum, out);
+	}
+
+	const ring_t *r = &c->rings[tier];
+	uint32_t from = from_s;
+	if (s_bucket_s[tier]) {
+		from -= from % s_bucket_s[tier]; // include the bucket holding from_s
+	}
+
+	for (uint32_t i = ring_lower_bound(r, from); i < r->count; i++) {
+		const history_point_t *pt = ring_at(r, i);
+		if (pt->t_s > to_s) {
+			break;
+		}
+		summary_add(&acc, &sum, pt);
+	}
+	const bucket_t *open = &c->open[tier];
+	if (open->count && open->t_s >= from && open->t_s <= to_s) {
+		history_point_t pt = bucket_point(open);
+		summary_add(&acc, &sum, &pt);
+	}
+
+	xSemaphoreGive(s_mu);
+	return summary_finish(&acc, sum, out);
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Sensor channels kept in the history store.
+ *
+ * Values are fixed-point integers: temperature in 0.01 degC, humidity in
+ * 0.01 %RH, eCO2 in ppm and TVOC in ppb.
+ */
+typedef enum {
+	HISTORY_TEMP = 0, ///< SHT40 temperature (0.01 degC)
+	HISTORY_RH,		  ///< SHT40 relative humidity (0.01 %RH)
+	HISTORY_ECO2,	  ///< SGP30 eCO2 (ppm)
+	HISTORY_TVOC,	  ///< SGP30 TVOC (ppb)
+	HISTORY_CHANNEL_COUNT,
+} history_channel_t;
+
+/** Scale of the temperature and humidity channels (units per degC / %RH). */
+#define HISTORY_CENTI 100
+
+/**
+ * @brief Resolution tiers, finest first.
+ */
+typedef enum {
+	HISTORY_TIER_RAW = 0, ///< Every sample, for at least the last hour
+	HISTORY_TIER_1MIN,	  ///< 1-minute rollups for the last day
+	HISTORY_TIER_15MIN,	  ///< 15-minute rollups for the last month
+	HISTORY_TIER_COUNT,
+} history_tier_t;
+
+/**
+ * History clock value at boot, in seconds. Starting well above zero leaves
+ * room for points restored from before the boot (see history_restore()).
+ */
+#define HISTORY_BOOT_T_S (32u * 24 * 3600)
+
+/**
+ * Raw samples are stored history_codec-compressed, in a ring of blocks per
+ * channel. A block holds at least 56 samples even if every value jumps, so
+ * 72 blocks cover an hour at 1 Hz in the worst case; slowly moving readings
+ * take about 7 bits each, stretching that to roughly 10 hours.
+ */
+#define HISTORY_RAW_BLOCKS 72
+#define HISTORY_RAW_BLOCK_BYTES 512
+
+/** Rollup ring capacities per channel. */
+#define HISTORY_1MIN_LEN (24 * 60)
+#define HISTORY_15MIN_LEN (31 * 24 * 4)
+
+/**
+ * @brief One point of a series.
+ *
+ * Raw samples have min == max == mean and count 1. Rollups cover
+ * [t_s, t_s + bucket length) and only exist for buckets that had samples.
+ */
+typedef struct {
+	uint32_t t_s;	///< Start time on the history clock
+	int32_t min;	///< Smallest sample
+	int32_t max;	///< Largest sample
+	int32_t mean;	///< Mean, rounded to the channel's fixed-point unit
+	uint32_t count; ///< Samples folded into this point
+} history_point_t;
+
+/**
+ * @brief Allocate the rings in PSRAM.
+ *
+ * Must be called once at startup, before readings_store_init() starts
+ * feeding samples. Until then, and if allocation fails, samples are
+ * dropped and queries return nothing.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if PSRAM is unavailable.
+ */
+esp_err_t history_store_init(void);
+
+/**
+ * @brief Append one sample to a channel.
+ *
+ * O(1): the sample goes into the raw ring and is folded into the open
+ * 1-minute and 15-minute buckets, which are closed into their rings when a
+ * later sample falls into a new bucket. Rollups never rescan raw data.
+ *
+ * Thread-safe. Timestamps must not go backwards per channel; older samples
+ * are dropped.
+ *
+ * @param ch    Channel.
+ * @param t_s   Sample time on the history clock (history_now_s()).
+ * @param value Sample in the channel's fixed-point unit.
+ */
+void history_record(history_channel_t ch, uint32_t t_s, int32_t value);
+
+/**
+ * @brief Copy the points of one tier that start within [from_s, to_s].
+ *
+ * Cost is a binary search plus the points copied, so O(window). Rollup
+ * tiers include the still-open bucket as their last point.
+ *
+ * Thread-safe.
+ *
+ * @param[in]  ch     Channel.
+ * @param[in]  tier   Resolution to read.
+ * @param[in]  from_s Window start on the history clock (inclusive).
+ * @param[in]  to_s   Window end on the history clock (inclusive).
+ * @param[out] out    Destination array.
+ * @param[in]  max    Capacity of out; the newest points are kept if the
+ *                    window holds more.
+ *
+ * @return Number of points written to out.
+ */
+int history_query(history_channel_t ch, history_tier_t tier, uint32_t from_s,
+				  uint32_t to_s, history_point_t *out, int max);
+
+/**
+ * @brief Min/max/mean of a channel over [from_s, to_s].
+ *
+ * Reads the finest tier whose retention still reaches back to from_s (raw
+ * for the last hour, 1-minute for the last day, 15-minute beyond), so e.g.
+ * an 8-hour window folds 480 rollups instead of 28800 samples. Windows
+ * reaching past a rollup tier are aligned to its bucket boundaries.
+ *
+ * Thread-safe.
+ *
+ * @param[in]  ch     Channel.
+ * @param[in]  from_s Window start on the history clock.
+ * @param[in]  to_s   Window end on the history clock.
+ * @param[out] out    Aggregate; t_s is the first covered point's start.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the window holds no data, or
+ *         ESP_ERR_INVALID_ARG.
+ */
+esp_err_t history_summary(history_channel_t ch, uint32_t from_s,
+						  uint32_t to_s, history_point_t *out);
+
+/**
+ * @brief Replay a persisted 1-minute rollup into a channel.
+ *
+ * The point goes into the 1-minute ring and is merged into the open
+ * 15-minute bucket, exactly as if its samples had been recorded. Used at
+ * boot, before the first live sample; points must come in time order.
+ *
+ * Thread-safe.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_INVALID_STATE if the
+ *         store is not initialised or the point is older than the channel's
+ *         latest data.
+ */
+esp_err_t history_restore(history_channel_t ch, const history_point_t *minute);
+
+/**
+ * @brief History clock: seconds since boot plus HISTORY_BOOT_T_S.
+ */
+uint32_t history_now_s(void);
+
+#ifdef __cplusplus
+}
+#endif
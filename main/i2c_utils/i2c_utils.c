@@ -13,22 +13,7 @@ esp_err_t i2c_read_u8(i2c_master_dev_handle_t dev, uint8_t reg, uint8_t *out,
 
 esp_err_t i2c_probe_addr(i2c_master_bus_handle_t bus, uint8_t addr,
 						 int timeout_ms) {
-	// Create a temporary device handle just to probe
-	i2c_master_dev_handle_t dev = NULL;
-	i2c_device_config_t cfg = {
-		.dev_addr_length = I2C_ADDR_BIT_LEN_7,
-		.device_address = addr,
-		.scl_speed_hz = 100000, // probe slow & safe
-	};
-
-	esp_err_t err = i2c_master_bus_add_device(bus, &cfg, &dev);
-	if (err != ESP_OK)
-		return err;
-
-	uint8_t dummy = 0;
-	err = i2c_master_transmit(
-		dev, &dummy, 0, timeout_ms); // 0-byte write acts like address probe
-
-	i2c_master_bus_rm_device(dev);
-	return err;
+	// Address-only transaction: no temporary device handle, and it works on
+	// buses running the driver's async transaction queue too
+	return i2c_master_probe(bus, addr, timeout_ms);
 }
@@ -11,6 +11,13 @@ esp_err_t i2c_write_u8(i2c_master_dev_handle_t dev, uint8_t reg, uint8_t val,
 					   int timeout_ms);
 esp_err_t i2c_read_u8(i2c_master_dev_handle_t dev, uint8_t reg, uint8_t *out,
 					  int timeout_ms);
+
+/**
+ * @brief Check whether a device ACKs its address.
+ *
+ * @return ESP_OK if the address was ACKed, ESP_ERR_NOT_FOUND if not, or
+ *         ESP_ERR_TIMEOUT if the bus is stuck.
+ */
 esp_err_t i2c_probe_addr(i2c_master_bus_handle_t bus, uint8_t addr,
 						 int timeout_ms);
 
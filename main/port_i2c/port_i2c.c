@@ -3,6 +3,9 @@
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "i2c_utils.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
 #include <string.h>
 
 // -----------------------------------------------------------------------------
@@ -33,7 +36,12 @@ esp_err_t port_i2c_get_default_bus_config(port_i2c_port_t port,
 		.clk_source = I2C_CLK_SRC_DEFAULT,
 		.glitch_ignore_cnt = 7,
 		.intr_priority = 0,
+#if CONFIG_PORT_I2C_ASYNC
+		// Driver-side transaction queue: enables async completion callbacks
+		.trans_queue_depth = CONFIG_PORT_I2C_ASYNC_QUEUE_DEPTH,
+#else
 		.trans_queue_depth = 0,
+#endif
 		.enable_internal_pullup = false,
 	};
 
@@ -120,74 +128,218 @@ esp_err_t port_i2c_rm_device(i2c_master_dev_handle_t dev) {
 /* Transaction helpers                                                        */
 /* -------------------------------------------------------------------------- */
 
-static TickType_t rx_backoff_ticks(int attempt) {
-	switch (attempt) {
-	case 0:
-		return pdMS_TO_TICKS(2);
-	case 1:
-		return pdMS_TO_TICKS(5);
-	case 2:
-		return pdMS_TO_TICKS(10);
-	case 3:
-		return pdMS_TO_TICKS(20);
-	case 4:
-		return pdMS_TO_TICKS(30);
-	default:
-		return pdMS_TO_TICKS(50);
-	}
+/* Sync transport: the driver blocks the calling task until done. */
+
+static esp_err_t sync_transmit(const port_i2c_io_t *io,
+							   i2c_master_dev_handle_t dev, const uint8_t *tx,
+							   size_t tx_len, int timeout_ms) {
+	(void)io;
+	return i2c_master_transmit(dev, tx, tx_len, timeout_ms);
+}
+
+static esp_err_t sync_receive(const port_i2c_io_t *io,
+							  i2c_master_dev_handle_t dev, uint8_t *rx,
+							  size_t rx_len, int timeout_ms) {
+	(void)io;
+	return i2c_master_receive(dev, rx, rx_len, timeout_ms);
+}
+
+static esp_err_t sync_transmit_receive(const port_i2c_io_t *io,
+									   i2c_master_dev_handle_t dev,
+									   const uint8_t *tx, size_t tx_len,
+									   uint8_t *rx, size_t rx_len,
+									   int timeout_ms) {
+	(void)io;
+	return i2c_master_transmit_receive(dev, tx, tx_len, rx, rx_len,
+									   timeout_ms);
+}
+
+static esp_err_t sync_probe(const port_i2c_io_t *io,
+							i2c_master_bus_handle_t bus, uint8_t addr,
+							int timeout_ms) {
+	(void)io;
+	return i2c_probe_addr(bus, addr, timeout_ms);
+}
+
+const port_i2c_io_t port_i2c_io_sync = {
+	.transmit = sync_transmit,
+	.receive = sync_receive,
+	.transmit_receive = sync_transmit_receive,
+	.probe = sync_probe,
+	.ctx = NULL,
+};
+
+bool port_i2c_is_nack(esp_err_t err) {
+	return err == ESP_ERR_INVALID_STATE || err == ESP_ERR_INVALID_RESPONSE;
 }
 
-esp_err_t port_i2c_xfer(const port_i2c_req_t *req, port_i2c_resp_t *out) {
-	if (!req || !out)
+static void count_nack(port_i2c_resp_t *out) {
+	if (port_i2c_is_nack(out->err) && out->nacks < UINT8_MAX)
+		out->nacks++;
+}
+
+/**
+ * @brief Validate a plain request and reset the response.
+ */
+static esp_err_t xfer_begin(const port_i2c_io_t *io, const port_i2c_req_t *req,
+							port_i2c_resp_t *out) {
+	if (!io || !req || !out)
 		return ESP_ERR_INVALID_ARG;
 	if (!req->dev)
 		return ESP_ERR_INVALID_ARG;
-	if (req->rx_len > sizeof(out->data))
+	if (req->rx_len > 0 && !req->rx)
+		return ESP_ERR_INVALID_ARG;
+	if (req->cmd_len > 2)
 		return ESP_ERR_INVALID_ARG;
 
 	out->request_id = req->request_id;
 	out->err = ESP_OK;
-	memset(out->data, 0, sizeof(out->data));
-
-	// Build command bytes explicitly (endianness-safe)
-	uint8_t cmd_buf[2];
+	out->rx_len = 0;
+	out->retries = 0;
+	out->nacks = 0;
+	return ESP_OK;
+}
 
-	if (req->cmd_len == 0) {
-		// no write phase
-	} else if (req->cmd_len == 1) {
+/**
+ * @brief Build command bytes explicitly (endianness-safe).
+ *
+ * 16-bit commands are big-endian on the wire.
+ */
+static void encode_cmd(const port_i2c_req_t *req, uint8_t cmd_buf[2]) {
+	if (req->cmd_len == 1) {
 		cmd_buf[0] = (uint8_t)(req->cmd & 0xFF);
 	} else if (req->cmd_len == 2) {
-		// 16-bit command, big-endian on the wire
 		cmd_buf[0] = (uint8_t)((req->cmd >> 8) & 0xFF);
 		cmd_buf[1] = (uint8_t)(req->cmd & 0xFF);
-	} else {
-		out->err = ESP_ERR_INVALID_ARG;
-		return out->err;
 	}
+}
 
-	// Write phase
-	if (req->cmd_len > 0) {
-		out->err = i2c_master_transmit(req->dev, cmd_buf, req->cmd_len, 200);
-		if (out->err != ESP_OK)
-			return out->err;
+esp_err_t port_i2c_xfer_cmd(const port_i2c_io_t *io, const port_i2c_req_t *req,
+							port_i2c_resp_t *out, int timeout_ms) {
+	esp_err_t err = xfer_begin(io, req, out);
+	if (err != ESP_OK) {
+		if (out)
+			out->err = err;
+		return err;
 	}
 
-	// Optional conversion delay
-	if (req->post_cmd_delay_ticks > 0) {
-		vTaskDelay(req->post_cmd_delay_ticks);
+	// Write phase (no-op for cmd_len == 0)
+	if (req->cmd_len > 0) {
+		uint8_t cmd_buf[2];
+		encode_cmd(req, cmd_buf);
+		out->err =
+			io->transmit(io, req->dev, cmd_buf, req->cmd_len, timeout_ms);
+		count_nack(out);
 	}
 
-	// Read phase with retry/backoff
+	return out->err;
+}
+
+void port_i2c_xfer_read_done(const port_i2c_req_t *req, port_i2c_resp_t *out,
+							 esp_err_t err) {
+	out->request_id = req->request_id;
+	out->err = err;
+	out->rx_len = err == ESP_OK ? req->rx_len : 0;
+	count_nack(out);
+}
+
+esp_err_t port_i2c_xfer_read(const port_i2c_io_t *io,
+							 const port_i2c_req_t *req, port_i2c_resp_t *out,
+							 int timeout_ms) {
+	if (!io || !req || !out)
+		return ESP_ERR_INVALID_ARG;
+	if (!req->dev)
+		return ESP_ERR_INVALID_ARG;
+	if (req->rx_len > 0 && !req->rx)
+		return ESP_ERR_INVALID_ARG;
+
+	// Single read attempt straight into the caller's buffer. Retrying is the
+	// caller's policy (the owner re-polls without holding the bus).
+	esp_err_t err = ESP_OK;
 	if (req->rx_len > 0) {
-		for (int i = 0; i < 8; i++) {
+		err = io->receive(io, req->dev, req->rx, req->rx_len, timeout_ms);
+	}
+	port_i2c_xfer_read_done(req, out, err);
+
+	return out->err;
+}
+
+esp_err_t port_i2c_xfer_write_read(const port_i2c_io_t *io,
+								   const port_i2c_req_t *req,
+								   port_i2c_resp_t *out, int timeout_ms) {
+	esp_err_t err = xfer_begin(io, req, out);
+	if (err == ESP_OK && (req->cmd_len == 0 || req->rx_len == 0))
+		err = ESP_ERR_INVALID_ARG;
+	if (err != ESP_OK) {
+		if (out)
+			out->err = err;
+		return err;
+	}
+
+	uint8_t cmd_buf[2];
+	encode_cmd(req, cmd_buf);
+	out->err = io->transmit_receive(io, req->dev, cmd_buf, req->cmd_len,
+									req->rx, req->rx_len, timeout_ms);
+	if (out->err == ESP_OK)
+		out->rx_len = req->rx_len;
+	count_nack(out);
+
+	return out->err;
+}
+
+esp_err_t port_i2c_xfer_batch(const port_i2c_io_t *io,
+							  const port_i2c_req_t *req, port_i2c_resp_t *out,
+							  int timeout_ms) {
+	if (!io || !req || !out)
+		return ESP_ERR_INVALID_ARG;
+	if (!req->dev || !req->ops || req->n_ops == 0)
+		return ESP_ERR_INVALID_ARG;
+
+	out->request_id = req->request_id;
+	out->err = ESP_OK;
+	out->rx_len = 0;
+	out->retries = 0;
+	out->nacks = 0;
+
+	for (uint8_t i = 0; i < req->n_ops && out->err == ESP_OK; i++) {
+		const port_i2c_op_t *op = &req->ops[i];
+
+		switch (op->type) {
+		case PORT_I2C_OP_WRITE:
 			out->err =
-				i2c_master_receive(req->dev, out->data, req->rx_len, 200);
-			if (out->err == ESP_OK)
-				return ESP_OK;
-			vTaskDelay(rx_backoff_ticks(i));
+				io->transmit(io, req->dev, op->tx, op->tx_len, timeout_ms);
+			break;
+		case PORT_I2C_OP_READ:
+			out->err =
+				io->receive(io, req->dev, op->rx, op->rx_len, timeout_ms);
+			break;
+		case PORT_I2C_OP_WRITE_READ:
+			out->err = io->transmit_receive(io, req->dev, op->tx, op->tx_len,
+											op->rx, op->rx_len, timeout_ms);
+			break;
+		case PORT_I2C_OP_DELAY:
+			vTaskDelay(op->delay_ticks);
+			break;
+		default:
+			out->err = ESP_ERR_INVALID_ARG;
+			break;
 		}
-		return out->err;
+		count_nack(out);
 	}
 
-	return ESP_OK;
-}
\ No newline at end of file
+	return out->err;
+}
+
+esp_err_t port_i2c_xfer(const port_i2c_io_t *io, const port_i2c_req_t *req,
+						port_i2c_resp_t *out, int timeout_ms) {
+	esp_err_t err = port_i2c_xfer_cmd(io, req, out, timeout_ms);
+	if (err != ESP_OK)
+		return err;
+
+	// Optional conversion delay
+	if (req->post_cmd_delay_ticks > 0) {
+		vTaskDelay(req->post_cmd_delay_ticks);
+	}
+
+	return port_i2c_xfer_read(io, req, out, timeout_ms);
+}
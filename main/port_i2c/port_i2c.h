@@ -3,6 +3,8 @@
 #include "driver/i2c_master.h"
 #include "esp_err.h"
 #include "port_i2c_types.h"
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -18,6 +20,7 @@ typedef enum {
 	PORT_I2C_PORT_A = 0,
 	PORT_I2C_PORT_B = 1,
 	PORT_I2C_PORT_C = 2,
+	PORT_I2C_PORT_COUNT, ///< Number of ports (not a valid selector)
 } port_i2c_port_t;
 
 /**
@@ -38,6 +41,51 @@ typedef struct {
 								 ///< false on Grove)
 } port_i2c_bus_config_t;
 
+/**
+ * @brief Transport used by the port_i2c_xfer*() helpers.
+ *
+ * Decouples request sequencing from how bytes reach the bus. The sync
+ * transport (port_i2c_io_sync) calls the blocking driver API directly; the
+ * async transport (port_i2c_async_io()) queues each transfer in the driver
+ * and sleeps until its completion interrupt; the simulated transport
+ * (port_i2c_sim_io()) answers from device models without any hardware.
+ * Every function returns only once the transfer has finished, so buffers
+ * may live on the stack.
+ */
+typedef struct port_i2c_io {
+	/** Write tx[0..tx_len). */
+	esp_err_t (*transmit)(const struct port_i2c_io *io,
+						  i2c_master_dev_handle_t dev, const uint8_t *tx,
+						  size_t tx_len, int timeout_ms);
+	/** Read rx_len bytes into rx. */
+	esp_err_t (*receive)(const struct port_i2c_io *io,
+						 i2c_master_dev_handle_t dev, uint8_t *rx,
+						 size_t rx_len, int timeout_ms);
+	/** Write tx, repeated start, read rx (no stop in between). */
+	esp_err_t (*transmit_receive)(const struct port_i2c_io *io,
+								  i2c_master_dev_handle_t dev,
+								  const uint8_t *tx, size_t tx_len,
+								  uint8_t *rx, size_t rx_len, int timeout_ms);
+	/** Address-only probe: ESP_OK if addr ACKs, else ESP_ERR_NOT_FOUND. */
+	esp_err_t (*probe)(const struct port_i2c_io *io,
+					   i2c_master_bus_handle_t bus, uint8_t addr,
+					   int timeout_ms);
+	/** Transport-private state. */
+	void *ctx;
+} port_i2c_io_t;
+
+/** Blocking transport: direct i2c_master_* calls. */
+extern const port_i2c_io_t port_i2c_io_sync;
+
+/**
+ * @brief True for errors that mean the device NACKed.
+ *
+ * The IDF master driver returns ESP_ERR_INVALID_STATE before v5.3 and
+ * ESP_ERR_INVALID_RESPONSE since; the async transport maps its NACK event
+ * to ESP_ERR_INVALID_RESPONSE.
+ */
+bool port_i2c_is_nack(esp_err_t err);
+
 /**
  * @brief Fill a bus config from a known board port mapping (A/B/C).
  *
@@ -110,16 +158,103 @@ esp_err_t port_i2c_add_device(i2c_master_bus_handle_t bus, uint8_t addr,
 esp_err_t port_i2c_rm_device(i2c_master_dev_handle_t dev);
 
 /**
- * @brief Execute a command + optional delay + optional read transaction.
+ * @brief Execute a command + optional delay + one read attempt.
+ *
+ * This is generic (works for any I2C device handle). It does not retry: a
+ * device still busy converting NACKs the read and the error is returned.
+ * Retrying is left to the caller (the bus owner re-polls without holding
+ * the bus, see port_i2c_service_set_retry_policy()).
+ *
+ * @param[in]  io         Transport to use.
+ * @param[in]  req        Request descriptor (dev, cmd, rx/rx_len, delays)
+ * @param[out] out        Response (err + bytes read into req->rx)
+ * @param[in]  timeout_ms Driver timeout for each bus operation.
+ *
+ * @return ESP_OK on success, otherwise error code.
+ */
+esp_err_t port_i2c_xfer(const port_i2c_io_t *io, const port_i2c_req_t *req,
+						port_i2c_resp_t *out, int timeout_ms);
+
+/**
+ * @brief Execute the command and read as one write-read transaction.
+ *
+ * Uses a repeated start between the command and the read, saving a
+ * stop/start and a second address phase. Only valid for devices that can
+ * answer immediately (req->post_cmd_delay_ticks == 0), e.g. register
+ * reads; sensors that need conversion time must use the split phases.
+ *
+ * @param[in]  io         Transport to use.
+ * @param[in]  req        Request with cmd_len > 0 and rx_len > 0.
+ * @param[out] out        Response (err + bytes read into req->rx)
+ * @param[in]  timeout_ms Driver timeout for the transaction.
+ *
+ * @return ESP_OK on success, otherwise error code.
+ */
+esp_err_t port_i2c_xfer_write_read(const port_i2c_io_t *io,
+								   const port_i2c_req_t *req,
+								   port_i2c_resp_t *out, int timeout_ms);
+
+/**
+ * @brief Execute a batched request (req->ops) back to back.
+ *
+ * Operations run in order on req->dev with nothing else interleaved on the
+ * bus; DELAY steps hold the bus. Execution stops at the first failing step.
+ *
+ * @param[in]  io         Transport to use.
+ * @param[in]  req        Request with ops/n_ops set.
+ * @param[out] out        Response (err only; read data goes to each op's rx).
+ * @param[in]  timeout_ms Driver timeout for each bus operation.
+ *
+ * @return ESP_OK if every step succeeded, otherwise the first error.
+ */
+esp_err_t port_i2c_xfer_batch(const port_i2c_io_t *io,
+							  const port_i2c_req_t *req, port_i2c_resp_t *out,
+							  int timeout_ms);
+
+/**
+ * @brief Execute only the command (write) phase of a request.
+ *
+ * Validates the request, initializes the response and transmits the
+ * command bytes. Does not wait for post_cmd_delay_ticks; the caller is
+ * expected to schedule port_i2c_xfer_read() once the delay has elapsed.
+ *
+ * @param[in]  io         Transport to use.
+ * @param[in]  req        Request descriptor.
+ * @param[out] out        Response (err; rx_len, retries, nacks reset).
+ * @param[in]  timeout_ms Driver timeout for the write.
+ *
+ * @return ESP_OK on success, otherwise error code.
+ */
+esp_err_t port_i2c_xfer_cmd(const port_i2c_io_t *io, const port_i2c_req_t *req,
+							port_i2c_resp_t *out, int timeout_ms);
+
+/**
+ * @brief Execute one read attempt of a request.
  *
- * This is generic (works for any I2C device handle).
+ * Reads directly into req->rx. No-op returning ESP_OK when req->rx_len
+ * is 0. nacks accumulate onto the value left by port_i2c_xfer_cmd() (and
+ * earlier attempts), so pass the same response to every phase.
  *
- * @param[in]  req  Request descriptor (dev, cmd_len, cmd, rx_len, delays, etc.)
- * @param[out] out  Response (err + data)
+ * @param[in]  io         Transport to use.
+ * @param[in]  req        Request descriptor (same one passed to the command
+ *                        phase).
+ * @param[out] out        Response (err + bytes read).
+ * @param[in]  timeout_ms Driver timeout for the read.
  *
  * @return ESP_OK on success, otherwise error code.
  */
-esp_err_t port_i2c_xfer(const port_i2c_req_t *req, port_i2c_resp_t *out);
+esp_err_t port_i2c_xfer_read(const port_i2c_io_t *io,
+							 const port_i2c_req_t *req, port_i2c_resp_t *out,
+							 int timeout_ms);
+
+/**
+ * @brief Record the outcome of a read phase completed outside
+ * port_i2c_xfer_read() (e.g. a pipelined async read).
+ *
+ * Sets out->err, counts a NACK and sets rx_len on success.
+ */
+void port_i2c_xfer_read_done(const port_i2c_req_t *req, port_i2c_resp_t *out,
+							 esp_err_t err);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,308 @@
+#include "port_i2c_async.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "i2c_utils.h"
+
+/* Extra wait beyond the driver timeout before giving up on a completion. */
+#define ASYNC_WAIT_SLACK_TICKS 2
+
+typedef struct {
+	bool used;		///< Claimed by a transfer that has not been collected
+	bool pending;	///< Queued in the driver, completion not seen yet
+	bool abandoned; ///< Waiter gave up; free the slot on completion
+	uint32_t seq;	///< Submission order (oldest completes first)
+	i2c_master_dev_handle_t dev;
+	esp_err_t err;
+	int64_t done_us;
+	uint8_t *dst;	///< Caller's rx, filled from rx on collection (or NULL)
+	size_t rx_len;
+	uint8_t tx[PORT_I2C_ASYNC_MAX_FRAME]; ///< What the driver transmits
+	uint8_t rx[PORT_I2C_ASYNC_MAX_FRAME]; ///< What the driver receives into
+} async_slot_t;
+
+struct port_i2c_async {
+	portMUX_TYPE lock; ///< Shared with the completion ISR
+	TaskHandle_t owner;
+	uint32_t seq;
+	async_slot_t slots[PORT_I2C_ASYNC_MAX_INFLIGHT];
+	port_i2c_io_t io;
+};
+
+/**
+ * @brief Driver completion callback (ISR context).
+ *
+ * The driver runs a bus's transactions in submission order, so the
+ * completion belongs to the oldest pending slot for this device.
+ */
+static bool IRAM_ATTR on_trans_done(i2c_master_dev_handle_t dev,
+									const i2c_master_event_data_t *evt,
+									void *arg) {
+	port_i2c_async_t *a = (port_i2c_async_t *)arg;
+	esp_err_t err;
+
+	switch (evt->event) {
+	case I2C_EVENT_ALIVE:
+		return false; // not a completion
+	case I2C_EVENT_DONE:
+		err = ESP_OK;
+		break;
+	case I2C_EVENT_NACK:
+		err = ESP_ERR_INVALID_RESPONSE;
+		break;
+	default:
+		err = ESP_ERR_TIMEOUT;
+		break;
+	}
+
+	int64_t now = esp_timer_get_time();
+	async_slot_t *hit = NULL;
+
+	portENTER_CRITICAL_ISR(&a->lock);
+	for (int i = 0; i < PORT_I2C_ASYNC_MAX_INFLIGHT; i++) {
+		async_slot_t *s = &a->slots[i];
+		if (!s->pending || s->dev != dev)
+			continue;
+		if (!hit || (int32_t)(s->seq - hit->seq) < 0)
+			hit = s;
+	}
+	if (hit) {
+		hit->pending = false;
+		hit->err = err;
+		hit->done_us = now;
+		if (hit->abandoned)
+			hit->used = false;
+	}
+	TaskHandle_t owner = a->owner;
+	portEXIT_CRITICAL_ISR(&a->lock);
+
+	BaseType_t woken = pdFALSE;
+	if (hit && owner)
+		vTaskNotifyGiveFromISR(owner, &woken);
+	return woken == pdTRUE;
+}
+
+/**
+ * @brief Claim a slot before submitting (owner task).
+ *
+ * The driver keeps pointers to a queued transfer's buffers until it
+ * completes, which can be after the waiter gave up and the caller's
+ * buffers are gone. So the driver only ever sees the slot's own tx and rx:
+ * tx is copied in here, rx is copied out to the caller on collection.
+ *
+ * @return The ticket, -1 if every slot is taken.
+ */
+static int claim(port_i2c_async_t *a, i2c_master_dev_handle_t dev,
+				 const uint8_t *tx, size_t tx_len, uint8_t *rx,
+				 size_t rx_len) {
+	if (!a->owner)
+		a->owner = xTaskGetCurrentTaskHandle();
+
+	int ticket = -1;
+	portENTER_CRITICAL(&a->lock);
+	for (int i = 0; i < PORT_I2C_ASYNC_MAX_INFLIGHT; i++) {
+		async_slot_t *s = &a->slots[i];
+		if (s->used)
+			continue;
+		s->used = true;
+		s->pending = true;
+		s->abandoned = false;
+		s->seq = a->seq++;
+		s->dev = dev;
+		s->err = ESP_FAIL;
+		s->dst = rx;
+		s->rx_len = rx_len;
+		ticket = i;
+		break;
+	}
+	portEXIT_CRITICAL(&a->lock);
+
+	if (ticket >= 0 && tx_len > 0)
+		memcpy(a->slots[ticket].tx, tx, tx_len);
+	return ticket;
+}
+
+/** Release a slot whose submit failed (nothing queued in the driver). */
+static void release(port_i2c_async_t *a, int ticket) {
+	portENTER_CRITICAL(&a->lock);
+	a->slots[ticket].pending = false;
+	a->slots[ticket].used = false;
+	portEXIT_CRITICAL(&a->lock);
+}
+
+esp_err_t port_i2c_async_wait(port_i2c_async_t *a, int ticket, int timeout_ms,
+							  int64_t *done_us) {
+	if (!a || ticket < 0 || ticket >= PORT_I2C_ASYNC_MAX_INFLIGHT)
+		return ESP_ERR_INVALID_ARG;
+
+	async_slot_t *s = &a->slots[ticket];
+	TickType_t start = xTaskGetTickCount();
+	TickType_t limit = pdMS_TO_TICKS(timeout_ms) + ASYNC_WAIT_SLACK_TICKS;
+
+	for (;;) {
+		portENTER_CRITICAL(&a->lock);
+		bool pending = s->pending;
+		portEXIT_CRITICAL(&a->lock);
+
+		if (!pending) {
+			// The driver is done with the slot; only this task touches it
+			esp_err_t err = s->err;
+			if (err == ESP_OK && s->dst)
+				memcpy(s->dst, s->rx, s->rx_len);
+			if (done_us)
+				*done_us = s->done_us;
+			portENTER_CRITICAL(&a->lock);
+			s->used = false;
+			portEXIT_CRITICAL(&a->lock);
+			return err;
+		}
+
+		TickType_t waited = xTaskGetTickCount() - start;
+		if (waited >= limit) {
+			// Leave the slot claimed until the driver reports completion;
+			// the late data lands in the slot, never in the caller's rx
+			portENTER_CRITICAL(&a->lock);
+			s->dst = NULL;
+			if (s->pending)
+				s->abandoned = true;
+			else
+				s->used = false;
+			portEXIT_CRITICAL(&a->lock);
+			return ESP_ERR_TIMEOUT;
+		}
+
+		// Any completion wakes us; re-check our own slot
+		(void)ulTaskNotifyTake(pdTRUE, limit - waited);
+	}
+}
+
+esp_err_t port_i2c_async_receive_start(port_i2c_async_t *a,
+									   i2c_master_dev_handle_t dev,
+									   uint8_t *rx, size_t rx_len,
+									   int timeout_ms, int *ticket) {
+	if (!a || !dev || !rx || !ticket)
+		return ESP_ERR_INVALID_ARG;
+	if (rx_len > PORT_I2C_ASYNC_MAX_FRAME)
+		return ESP_ERR_INVALID_SIZE;
+
+	int t = claim(a, dev, NULL, 0, rx, rx_len);
+	if (t < 0)
+		return ESP_ERR_NO_MEM;
+
+	esp_err_t err =
+		i2c_master_receive(dev, a->slots[t].rx, rx_len, timeout_ms);
+	if (err != ESP_OK) {
+		release(a, t);
+		return err;
+	}
+
+	*ticket = t;
+	return ESP_OK;
+}
+
+/* Transport: queue, then sleep until the completion interrupt. */
+
+static esp_err_t async_transmit(const port_i2c_io_t *io,
+								i2c_master_dev_handle_t dev, const uint8_t *tx,
+								size_t tx_len, int timeout_ms) {
+	port_i2c_async_t *a = (port_i2c_async_t *)io->ctx;
+	if (tx_len > PORT_I2C_ASYNC_MAX_FRAME)
+		return ESP_ERR_INVALID_SIZE;
+	int t = claim(a, dev, tx, tx_len, NULL, 0);
+	if (t < 0)
+		return ESP_ERR_NO_MEM;
+
+	esp_err_t err =
+		i2c_master_transmit(dev, a->slots[t].tx, tx_len, timeout_ms);
+	if (err != ESP_OK) {
+		release(a, t);
+		return err;
+	}
+	return port_i2c_async_wait(a, t, timeout_ms, NULL);
+}
+
+static esp_err_t async_receive(const port_i2c_io_t *io,
+							   i2c_master_dev_handle_t dev, uint8_t *rx,
+							   size_t rx_len, int timeout_ms) {
+	port_i2c_async_t *a = (port_i2c_async_t *)io->ctx;
+	int t;
+	esp_err_t err =
+		port_i2c_async_receive_start(a, dev, rx, rx_len, timeout_ms, &t);
+	if (err != ESP_OK)
+		return err;
+	return port_i2c_async_wait(a, t, timeout_ms, NULL);
+}
+
+static esp_err_t async_transmit_receive(const port_i2c_io_t *io,
+										i2c_master_dev_handle_t dev,
+										const uint8_t *tx, size_t tx_len,
+										uint8_t *rx, size_t rx_len,
+										int timeout_ms) {
+	port_i2c_async_t *a = (port_i2c_async_t *)io->ctx;
+	if (tx_len > PORT_I2C_ASYNC_MAX_FRAME || rx_len > PORT_I2C_ASYNC_MAX_FRAME)
+		return ESP_ERR_INVALID_SIZE;
+	int t = claim(a, dev, tx, tx_len, rx, rx_len);
+	if (t < 0)
+		return ESP_ERR_NO_MEM;
+
+	async_slot_t *s = &a->slots[t];
+	esp_err_t err = i2c_master_transmit_receive(dev, s->tx, tx_len, s->rx,
+												rx_len, timeout_ms);
+	if (err != ESP_OK) {
+		release(a, t);
+		return err;
+	}
+	return port_i2c_async_wait(a, t, timeout_ms, NULL);
+}
+
+/* Probes bypass the transaction queue: the driver runs them directly. */
+static esp_err_t async_probe(const port_i2c_io_t *io,
+							 i2c_master_bus_handle_t bus, uint8_t addr,
+							 int timeout_ms) {
+	(void)io;
+	return i2c_probe_addr(bus, addr, timeout_ms);
+}
+
+esp_err_t port_i2c_async_create(port_i2c_async_t **out) {
+	if (!out)
+		return ESP_ERR_INVALID_ARG;
+
+	port_i2c_async_t *a = calloc(1, sizeof(*a));
+	if (!a)
+		return ESP_ERR_NO_MEM;
+
+	portMUX_INITIALIZE(&a->lock);
+	a->io.transmit = async_transmit;
+	a->io.receive = async_receive;
+	a->io.transmit_receive = async_transmit_receive;
+	a->io.probe = async_probe;
+	a->io.ctx = a;
+
+	*out = a;
+	return ESP_OK;
+}
+
+void port_i2c_async_destroy(port_i2c_async_t *a) {
+	free(a);
+}
+
+esp_err_t port_i2c_async_attach(port_i2c_async_t *a,
+								i2c_master_dev_handle_t dev) {
+	if (!a || !dev)
+		return ESP_ERR_INVALID_ARG;
+
+	const i2c_master_event_callbacks_t cbs = {
+		.on_trans_done = on_trans_done,
+	};
+	return i2c_master_register_event_callbacks(dev, &cbs, a);
+}
+
+const port_i2c_io_t *port_i2c_async_io(port_i2c_async_t *a) {
+	return a ? &a->io : NULL;
+}
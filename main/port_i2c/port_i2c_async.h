@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "port_i2c.h" // port_i2c_io_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Max transfers one bus may have queued in the driver at once. */
+#define PORT_I2C_ASYNC_MAX_INFLIGHT 8
+
+/**
+ * Longest write or read one async transfer carries (the longest Sensirion
+ * frame is 9 bytes). Transfers go through buffers owned by the tracker, so
+ * a completion arriving after its waiter timed out cannot write into memory
+ * the caller has already released.
+ */
+#define PORT_I2C_ASYNC_MAX_FRAME 32
+
+/**
+ * @brief Completion tracker for one bus running the driver's async mode.
+ *
+ * The bus must have been created with trans_queue_depth > 0. Transfers are
+ * queued in the driver and complete from its on_trans_done interrupt, which
+ * records the result and wakes the issuing (owner) task with a task
+ * notification. All functions except the callback must be called from that
+ * one owner task.
+ */
+typedef struct port_i2c_async port_i2c_async_t;
+
+/**
+ * @brief Allocate a tracker for one bus.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG or ESP_ERR_NO_MEM.
+ */
+esp_err_t port_i2c_async_create(port_i2c_async_t **out);
+
+/**
+ * @brief Free a tracker that has no transfer in flight (NULL is a no-op).
+ */
+void port_i2c_async_destroy(port_i2c_async_t *a);
+
+/**
+ * @brief Register the completion callback for a device on the bus.
+ *
+ * Every device on an async bus must be attached, otherwise its transfers
+ * never report completion.
+ */
+esp_err_t port_i2c_async_attach(port_i2c_async_t *a,
+								i2c_master_dev_handle_t dev);
+
+/**
+ * @brief Transport that queues each transfer and sleeps until it is done.
+ *
+ * Each call returns once its transfer completed, so it is a drop-in for
+ * port_i2c_io_sync with the owner task sleeping instead of blocking in the
+ * driver. Transfers longer than PORT_I2C_ASYNC_MAX_FRAME fail with
+ * ESP_ERR_INVALID_SIZE.
+ */
+const port_i2c_io_t *port_i2c_async_io(port_i2c_async_t *a);
+
+/**
+ * @brief Queue a read without waiting for it.
+ *
+ * Lets the owner keep the reads of several devices in flight at once;
+ * collect each with port_i2c_async_wait(). The data is copied into rx when
+ * it is collected, so rx must stay valid until then; after a timeout it is
+ * never written.
+ *
+ * @param[out] ticket Handle for port_i2c_async_wait().
+ *
+ * @return ESP_OK once queued, ESP_ERR_INVALID_SIZE if rx_len exceeds
+ *         PORT_I2C_ASYNC_MAX_FRAME, ESP_ERR_NO_MEM if every in-flight slot
+ *         is taken, or the driver's submit error.
+ */
+esp_err_t port_i2c_async_receive_start(port_i2c_async_t *a,
+									   i2c_master_dev_handle_t dev,
+									   uint8_t *rx, size_t rx_len,
+									   int timeout_ms, int *ticket);
+
+/**
+ * @brief Sleep until a queued transfer completes.
+ *
+ * @param[in]  ticket     Handle from port_i2c_async_receive_start().
+ * @param[in]  timeout_ms Give up after this long (the slot is released
+ *                        when the late completion arrives).
+ * @param[out] done_us    Optional esp_timer time of completion.
+ *
+ * @return Transfer result (NACK -> ESP_ERR_INVALID_RESPONSE), or
+ *         ESP_ERR_TIMEOUT if no completion arrived in time.
+ */
+esp_err_t port_i2c_async_wait(port_i2c_async_t *a, int ticket, int timeout_ms,
+							  int64_t *done_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,86 +1,141 @@
 #include "port_i2c_readings.h"
-#include "esp_check.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
 
-// Internal mutex protecting shared state
-static SemaphoreHandle_t s_mu = NULL;
+#include <math.h>
+#include <string.h>
+
+#include "data_bus.h"
+#include "history_store.h"
+#include "sdkconfig.h"
+#include "seqlock.h"
+#include "signal_filter.h"
+
+// Written by the sampler task, read by the UI and the SGP30 driver
+static seqlock_t s_sl = SEQLOCK_INIT;
 
 // Internal storage of latest readings
 static readings_snapshot_t s_latest;
 
+// Ingest filters, indexed by history_channel_t; sampler task only
+static signal_filter_t s_filters[HISTORY_CHANNEL_COUNT];
+
+static void filters_init(void) {
+	signal_filter_init(
+		&s_filters[HISTORY_ECO2],
+		&(signal_filter_cfg_t){
+			.median_len = CONFIG_READINGS_SGP30_MEDIAN,
+			.ema_shift = CONFIG_READINGS_SGP30_EMA_SHIFT,
+			.n_thresholds = 2,
+			.thresholds = {READINGS_ECO2_FAIR_PPM, READINGS_ECO2_POOR_PPM},
+			.hysteresis = CONFIG_READINGS_ECO2_HYSTERESIS_PPM,
+		});
+	signal_filter_init(
+		&s_filters[HISTORY_TVOC],
+		&(signal_filter_cfg_t){
+			.median_len = CONFIG_READINGS_SGP30_MEDIAN,
+			.ema_shift = CONFIG_READINGS_SGP30_EMA_SHIFT,
+			.n_thresholds = 2,
+			.thresholds = {READINGS_TVOC_FAIR_PPB, READINGS_TVOC_POOR_PPB},
+			.hysteresis = CONFIG_READINGS_TVOC_HYSTERESIS_PPB,
+		});
+
+	const signal_filter_cfg_t sht40 = {
+		.median_len = CONFIG_READINGS_SHT40_MEDIAN,
+		.ema_shift = CONFIG_READINGS_SHT40_EMA_SHIFT,
+	};
+	signal_filter_init(&s_filters[HISTORY_TEMP], &sht40);
+	signal_filter_init(&s_filters[HISTORY_RH], &sht40);
+}
+
 /**
  * @brief Initialize readings storage module.
  */
 void readings_store_init(void) {
-	// Create mutex used to protect shared snapshot
-	s_mu = xSemaphoreCreateMutex();
-
-	// Optional: could assert here if allocation fails
-	// configASSERT(s_mu);
-
 	// Ensure storage starts zeroed (valid flags false)
 	// Static globals are zeroed automatically (.bss),
 	// but this keeps intent explicit.
+	filters_init();
+	seqlock_write_begin(&s_sl);
 	memset(&s_latest, 0, sizeof(s_latest));
+	seqlock_write_end(&s_sl);
 }
 
 /**
  * @brief Update SGP30 fields in shared snapshot.
  *
- * Critical section is kept intentionally short:
+ * The write section is kept intentionally short:
  *  - Only simple assignments
  *  - No logging
  *  - No dynamic allocation
  */
 void readings_update_sgp30(uint16_t eco2_ppm, uint16_t tvoc_ppb,
 						   uint32_t ts_ms) {
-	if (!s_mu) {
-		return; // module not initialized
-	}
+	// Filter outputs stay within the range of their inputs
+	uint16_t eco2 =
+		(uint16_t)signal_filter_update(&s_filters[HISTORY_ECO2], eco2_ppm);
+	uint16_t tvoc =
+		(uint16_t)signal_filter_update(&s_filters[HISTORY_TVOC], tvoc_ppb);
 
-	xSemaphoreTake(s_mu, portMAX_DELAY);
+	seqlock_write_begin(&s_sl);
 
 	s_latest.sgp30_valid = true;
-	s_latest.eco2_ppm = eco2_ppm;
-	s_latest.tvoc_ppb = tvoc_ppb;
+	s_latest.eco2_ppm = eco2;
+	s_latest.tvoc_ppb = tvoc;
+	s_latest.eco2_raw_ppm = eco2_ppm;
+	s_latest.tvoc_raw_ppb = tvoc_ppb;
+	s_latest.eco2_band = signal_filter_band(&s_filters[HISTORY_ECO2]);
+	s_latest.tvoc_band = signal_filter_band(&s_filters[HISTORY_TVOC]);
 	s_latest.sgp30_ts_ms = ts_ms;
 
-	xSemaphoreGive(s_mu);
+	seqlock_write_end(&s_sl);
+	data_bus_publish(DATA_TOPIC_READINGS);
+
+	uint32_t t_s = history_now_s();
+	history_record(HISTORY_ECO2, t_s, eco2_ppm);
+	history_record(HISTORY_TVOC, t_s, tvoc_ppb);
 }
 
 /**
  * @brief Update SHT40 fields in shared snapshot.
  */
 void readings_update_sht40(float temp_c, float rh_percent, uint32_t ts_ms) {
-	if (!s_mu) {
-		return;
-	}
+	// Filtered in 0.01 units, the history store's fixed point
+	int32_t temp_cc = (int32_t)lroundf(temp_c * HISTORY_CENTI);
+	int32_t rh_cpct = (int32_t)lroundf(rh_percent * HISTORY_CENTI);
+	float temp_f = (float)signal_filter_update(&s_filters[HISTORY_TEMP],
+											   temp_cc) /
+				   HISTORY_CENTI;
+	float rh_f = (float)signal_filter_update(&s_filters[HISTORY_RH], rh_cpct) /
+				 HISTORY_CENTI;
 
-	xSemaphoreTake(s_mu, portMAX_DELAY);
+	seqlock_write_begin(&s_sl);
 
 	s_latest.sht40_valid = true;
-	s_latest.temp_c = temp_c;
-	s_latest.rh_percent = rh_percent;
+	s_latest.temp_c = temp_f;
+	s_latest.rh_percent = rh_f;
+	s_latest.temp_raw_c = temp_c;
+	s_latest.rh_raw_percent = rh_percent;
 	s_latest.sht40_ts_ms = ts_ms;
 
-	xSemaphoreGive(s_mu);
+	seqlock_write_end(&s_sl);
+	data_bus_publish(DATA_TOPIC_READINGS);
+
+	uint32_t t_s = history_now_s();
+	history_record(HISTORY_TEMP, t_s, temp_cc);
+	history_record(HISTORY_RH, t_s, rh_cpct);
 }
 
 /**
  * @brief Copy latest readings into caller-provided struct.
  *
- * The entire struct is copied while holding the mutex
- * to guarantee a consistent snapshot.
+ * The copy is retried if it overlapped an update, so the caller always
+ * gets a consistent snapshot without taking a lock.
  */
 void readings_get_snapshot(readings_snapshot_t *out) {
-	if (!s_mu || !out) {
+	if (!out) {
 		return;
 	}
 
-	xSemaphoreTake(s_mu, portMAX_DELAY);
-
-	*out = s_latest; // struct copy
-
-	xSemaphoreGive(s_mu);
+	out->generation = seqlock_read(&s_sl, out, &s_latest, sizeof(*out));
 }
+
+uint32_t readings_generation(void) { return seqlock_generation(&s_sl); }
@@ -3,6 +3,21 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/**
+ * @brief Air quality band of a filtered eCO2 or TVOC value.
+ */
+typedef enum {
+	READINGS_BAND_GOOD = 0,
+	READINGS_BAND_FAIR,
+	READINGS_BAND_POOR,
+} readings_band_t;
+
+/** Band edges: fair from the first value, poor from the second. */
+#define READINGS_ECO2_FAIR_PPM 800
+#define READINGS_ECO2_POOR_PPM 1500
+#define READINGS_TVOC_FAIR_PPB 200
+#define READINGS_TVOC_POOR_PPB 500
+
 /**
  * @brief Snapshot of all latest sensor readings.
  *
@@ -14,9 +29,15 @@
  *
  * Each sensor group includes:
  *  - A validity flag (true once first successful reading arrives)
- *  - Latest decoded values in engineering units
+ *  - Latest values in engineering units, filtered (median spike rejection,
+ *    then EMA; see signal_filter.h) and as measured
+ *  - For eCO2 and TVOC, the air quality band of the filtered value, with
+ *    hysteresis so it does not flap around the edges
  *  - Timestamp (ms since boot) of when the reading was stored
  *
+ * `generation` counts the updates published before the copy was taken, so a
+ * reader can tell whether anything changed since its previous snapshot.
+ *
  * Notes:
  *  - All fields are owned and updated by readings_store.c
  *  - External modules must treat this struct as read-only
@@ -27,20 +48,28 @@ typedef struct {
 	// SGP30 (Air Quality)
 	// -------------------------------------------------------------------------
 
-	bool sgp30_valid;	  ///< True after first successful IAQ measurement
-	uint16_t eco2_ppm;	  ///< Equivalent CO2 concentration (ppm)
-	uint16_t tvoc_ppb;	  ///< Total Volatile Organic Compounds (ppb)
-	uint32_t sgp30_ts_ms; ///< Timestamp of last SGP30 update (ms since boot)
+	bool sgp30_valid;	   ///< True after first successful IAQ measurement
+	uint16_t eco2_ppm;	   ///< Equivalent CO2 concentration (ppm), filtered
+	uint16_t tvoc_ppb;	   ///< Total Volatile Organic Compounds (ppb), filtered
+	uint16_t eco2_raw_ppm; ///< eCO2 as measured
+	uint16_t tvoc_raw_ppb; ///< TVOC as measured
+	uint8_t eco2_band;	   ///< readings_band_t of eco2_ppm
+	uint8_t tvoc_band;	   ///< readings_band_t of tvoc_ppb
+	uint32_t sgp30_ts_ms;  ///< Timestamp of last SGP30 update (ms since boot)
 
 	// -------------------------------------------------------------------------
 	// SHT40 (Temperature + Humidity)
 	// -------------------------------------------------------------------------
 
 	bool sht40_valid;	  ///< True after first successful reading
-	float temp_c;		  ///< Temperature in Celsius
-	float rh_percent;	  ///< Relative humidity (%)
+	float temp_c;		  ///< Temperature in Celsius, filtered
+	float rh_percent;	  ///< Relative humidity (%), filtered
+	float temp_raw_c;	  ///< Temperature as measured
+	float rh_raw_percent; ///< Relative humidity as measured
 	uint32_t sht40_ts_ms; ///< Timestamp of last SHT40 update (ms since boot)
 
+	uint32_t generation; ///< Set by readings_get_snapshot()
+
 } readings_snapshot_t;
 
 /**
@@ -49,8 +78,8 @@ typedef struct {
  * Must be called once at startup before any update or get calls.
  *
  * Responsibilities:
- *  - Create internal synchronization primitives (mutex)
  *  - Zero-initialize internal storage
+ *  - Reset the per-channel filters from the READINGS_* Kconfig options
  *
  * This function is typically called from app_main() or
  * from your system initialization sequence.
@@ -65,7 +94,10 @@ void readings_store_init(void);
  *  - CRC validation
  *  - Proper decoding into engineering units
  *
- * Thread-safe.
+ * Thread-safe. Filtering keeps per-channel state, so updates for one
+ * sensor must come from one task (the sampler).
+ *
+ * Also appends both raw values to the history store.
  *
  * @param eco2_ppm  Equivalent CO2 concentration (ppm)
  * @param tvoc_ppb  Total VOC concentration (ppb)
@@ -82,7 +114,10 @@ void readings_update_sgp30(uint16_t eco2_ppm, uint16_t tvoc_ppb,
  *  - CRC validation
  *  - Conversion to float units
  *
- * Thread-safe.
+ * Thread-safe. Filtering keeps per-channel state, so updates for one
+ * sensor must come from one task (the sampler).
+ *
+ * Also appends both raw values to the history store (in 0.01 units).
  *
  * @param temp_c     Temperature in Celsius
  * @param rh_percent Relative humidity in %
@@ -93,15 +128,19 @@ void readings_update_sht40(float temp_c, float rh_percent, uint32_t ts_ms);
 /**
  * @brief Obtain a coherent snapshot of all sensor readings.
  *
- * This function:
- *  - Acquires internal mutex
- *  - Copies entire snapshot struct
- *  - Releases mutex
- *
- * The returned snapshot is safe to use without further locking.
+ * The store is guarded by a seqlock: the copy never blocks and is retried
+ * if it overlapped an update, so the returned snapshot is always coherent.
  *
- * Thread-safe.
+ * Thread-safe; lock-free for writers, retrying readers.
  *
  * @param out Pointer to struct that receives snapshot copy.
  */
 void readings_get_snapshot(readings_snapshot_t *out);
+
+/**
+ * @brief Number of updates published so far.
+ *
+ * Cheaper than a snapshot when the caller only needs to know whether
+ * anything changed since its last readings_get_snapshot().
+ */
+uint32_t readings_generation(void);
@@ -1,74 +1,844 @@
 #include "port_i2c_service.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "port_i2c.h"
+#include "port_i2c_async.h"
+#include "port_i2c_sim.h"
+#include "port_i2c_stats.h"
+#include "sdkconfig.h"
 #include <stdio.h>
 #include <string.h>
 
 #include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define TAG "port_i2c_service"
+
+/* Max requests waiting for a conversion deadline at the same time. */
+#define PORT_I2C_MAX_PARKED 8
+
+/* Max requests held back because their device is still converting. */
+#define PORT_I2C_MAX_DEFERRED 8
+
+/* Max devices registered across all buses. */
+#define PORT_I2C_MAX_DEVICES 8
+
+/* A scan probe only runs if no parked read is due within this many ticks. */
+#define PORT_I2C_SCAN_GUARD_TICKS pdMS_TO_TICKS(10)
+
+/* Driver timeout for one scan probe (an absent device NACKs at once). */
+#define PORT_I2C_SCAN_PROBE_TIMEOUT_MS 10
+
+/* Longest the owner sleeps, so scans configured at runtime are picked up. */
+#define PORT_I2C_OWNER_MAX_WAIT pdMS_TO_TICKS(1000)
+
+/**
+ * @brief A request whose command phase is done and whose read phase is
+ * waiting for the device's conversion time (or next re-poll) to elapse.
+ */
+typedef struct {
+	bool used;
+	TickType_t ready_at;   ///< Tick at which the next read poll may start
+	TickType_t poll_ticks; ///< Wait before the poll after this one
+	uint8_t polls;		   ///< Read attempts made so far
+	int64_t busy_us;	   ///< Bus time spent on this request so far
+	port_i2c_retry_policy_t policy;
+	port_i2c_req_t req;
+	port_i2c_resp_t resp;
+} port_i2c_parked_t;
+
+/**
+ * @brief Per-bus service state: one queue + one owner task per Grove port.
+ *
+ * Everything except `bus` and `q` is touched only by that bus's owner task,
+ * so no locking is needed for the scheduling state.
+ */
+typedef struct {
+	port_i2c_port_t port;
+	i2c_master_bus_handle_t bus;
+	QueueHandle_t q;
+
+	/* Transport: sync driver calls, or the async tracker's transport. */
+	const port_i2c_io_t *io;
+	port_i2c_async_t *async; ///< NULL unless CONFIG_PORT_I2C_ASYNC
+
+	port_i2c_parked_t parked[PORT_I2C_MAX_PARKED];
+
+	/* FIFO of requests for devices that are busy converting. */
+	port_i2c_req_t deferred[PORT_I2C_MAX_DEFERRED];
+	int deferred_count;
+
+	/* Background address scan (guarded by s_devices_lock). */
+	struct {
+		uint8_t addrs[PORT_I2C_SCAN_MAX_ADDRS];
+		int n;				///< 0 = scanning disabled
+		int cursor;			///< Next entry of addrs to probe
+		TickType_t spacing; ///< Minimum time between two probes
+		TickType_t next_at; ///< Earliest tick for the next probe
+		port_i2c_scan_cb_t cb;
+		void *arg;
+	} scan;
+} port_i2c_bus_ctx_t;
 
 /* -------------------------------------------------------------------------- */
 /* Static State                                                               */
 /* -------------------------------------------------------------------------- */
 
-/* Port A service request queue (created on first start). */
-static QueueHandle_t port_q; // static queue for port A
+/* One context per Grove port; bus/q are NULL until the first device. */
+static port_i2c_bus_ctx_t s_buses[PORT_I2C_PORT_COUNT];
+
+/* Device -> bus routing table + retry policy (append-only). */
+static struct {
+	i2c_master_dev_handle_t dev;
+	port_i2c_bus_ctx_t *ctx;
+	uint8_t addr;
+	port_i2c_retry_policy_t policy;
+} s_devices[PORT_I2C_MAX_DEVICES];
+static int s_device_count;
+
+/* Guards s_devices / s_device_count and the scan configs. */
+static portMUX_TYPE s_devices_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* -------------------------------------------------------------------------- */
+/* Scheduling helpers                                                         */
+/* -------------------------------------------------------------------------- */
+
+/** True once `now` has reached `at` (wrap-safe tick comparison). */
+static bool deadline_reached(TickType_t now, TickType_t at) {
+	return (TickType_t)(now - at) < (portMAX_DELAY / 2);
+}
+
+/** Copy a device's retry policy (default policy if not registered). */
+static void device_policy(i2c_master_dev_handle_t dev,
+						  port_i2c_retry_policy_t *out) {
+	const port_i2c_retry_policy_t def = PORT_I2C_RETRY_POLICY_DEFAULT;
+	*out = def;
+
+	portENTER_CRITICAL(&s_devices_lock);
+	for (int i = 0; i < s_device_count; i++) {
+		if (s_devices[i].dev == dev) {
+			*out = s_devices[i].policy;
+			break;
+		}
+	}
+	portEXIT_CRITICAL(&s_devices_lock);
+}
+
+/** Send the response if the requester provided a reply queue. */
+static void reply(const port_i2c_req_t *req, const port_i2c_resp_t *resp) {
+	if (req->reply_queue) {
+		(void)xQueueSend(req->reply_queue, resp, pdMS_TO_TICKS(50));
+	}
+}
+
+/**
+ * @brief Account a completed request in the device's statistics and reply.
+ *
+ * req->submit_us is always set by the time a request gets here (see
+ * dispatch_request()), so latency covers queueing, deferral and parking.
+ */
+static void finish(const port_i2c_req_t *req, const port_i2c_resp_t *resp,
+				   int64_t busy_us) {
+	port_i2c_stats_sample_t sample = {
+		.err = resp->err,
+		.retries = resp->retries,
+		.nacks = resp->nacks,
+		.latency_us = esp_timer_get_time() - req->submit_us,
+		.busy_us = busy_us,
+	};
+	port_i2c_stats_record(req->dev, &sample);
+	reply(req, resp);
+}
+
+/** True if a parked request is currently converting on `dev`. */
+static bool device_busy(const port_i2c_bus_ctx_t *ctx,
+						i2c_master_dev_handle_t dev) {
+	for (int i = 0; i < PORT_I2C_MAX_PARKED; i++) {
+		if (ctx->parked[i].used && ctx->parked[i].req.dev == dev)
+			return true;
+	}
+	return false;
+}
+
+/** Ticks until the earliest parked deadline (portMAX_DELAY if none). */
+static TickType_t next_wait_ticks(const port_i2c_bus_ctx_t *ctx) {
+	TickType_t now = xTaskGetTickCount();
+	TickType_t wait = portMAX_DELAY;
+
+	for (int i = 0; i < PORT_I2C_MAX_PARKED; i++) {
+		if (!ctx->parked[i].used)
+			continue;
+		if (deadline_reached(now, ctx->parked[i].ready_at))
+			return 0;
+		TickType_t left = ctx->parked[i].ready_at - now;
+		if (left < wait)
+			wait = left;
+	}
+	return wait;
+}
+
+/**
+ * @brief Run the command phase of a request and park it for its read.
+ *
+ * Write-only requests without a post-command delay complete immediately,
+ * and reads without one use a single write-read (repeated start).
+ * Requests already past their deadline fail without touching the bus. If
+ * every parking slot is taken, the request falls back to a single blocking
+ * attempt so it is never dropped.
+ */
+static void start_request(port_i2c_bus_ctx_t *ctx, const port_i2c_req_t *req) {
+	port_i2c_resp_t resp = {
+		.request_id = req->request_id,
+		.err = ESP_FAIL,
+	};
+
+	if (deadline_reached(xTaskGetTickCount(), req->deadline)) {
+		resp.err = ESP_ERR_TIMEOUT;
+		finish(req, &resp, 0);
+		return;
+	}
+
+	port_i2c_retry_policy_t policy;
+	device_policy(req->dev, &policy);
+	int64_t t0 = esp_timer_get_time();
+
+	/* Batches are atomic: run every step now, one reply at the end */
+	if (req->ops) {
+		resp.err = port_i2c_xfer_batch(ctx->io, req, &resp,
+									   policy.op_timeout_ms);
+		finish(req, &resp, esp_timer_get_time() - t0);
+		return;
+	}
+
+	if (req->post_cmd_delay_ticks == 0 && req->rx_len == 0) {
+		resp.err =
+			port_i2c_xfer_cmd(ctx->io, req, &resp, policy.op_timeout_ms);
+		finish(req, &resp, esp_timer_get_time() - t0);
+		return;
+	}
+
+	/* No conversion time: command + repeated start + read in one go */
+	if (req->post_cmd_delay_ticks == 0 && req->cmd_len > 0) {
+		resp.err =
+			port_i2c_xfer_write_read(ctx->io, req, &resp, policy.op_timeout_ms);
+		finish(req, &resp, esp_timer_get_time() - t0);
+		return;
+	}
+
+	int slot = -1;
+	for (int i = 0; i < PORT_I2C_MAX_PARKED; i++) {
+		if (!ctx->parked[i].used) {
+			slot = i;
+			break;
+		}
+	}
+	if (slot < 0) {
+		/* Blocking fallback holds the bus through the conversion */
+		resp.err = port_i2c_xfer(ctx->io, req, &resp, policy.op_timeout_ms);
+		finish(req, &resp, esp_timer_get_time() - t0);
+		return;
+	}
+
+	resp.err = port_i2c_xfer_cmd(ctx->io, req, &resp, policy.op_timeout_ms);
+	if (resp.err != ESP_OK) {
+		finish(req, &resp, esp_timer_get_time() - t0);
+		return;
+	}
+
+	/* Device is now converting: the bus is free for other requests. */
+	port_i2c_parked_t *p = &ctx->parked[slot];
+	memcpy(&p->req, req, sizeof(p->req));
+	p->resp = resp;
+	p->policy = policy;
+	p->polls = 0;
+	p->poll_ticks = policy.poll_ticks > 0 ? policy.poll_ticks : 1;
+	p->busy_us = esp_timer_get_time() - t0;
+	p->ready_at = xTaskGetTickCount() + req->post_cmd_delay_ticks;
+	p->used = true;
+}
+
+/**
+ * @brief Accept a new request from the queue.
+ *
+ * A device cannot take a new command while it is converting, so requests
+ * for a busy device are deferred until its parked request completes.
+ *
+ * Records the time the request spent in the queue; requests sent without a
+ * submit timestamp are stamped here so latency is measured from dequeue.
+ * Requests without a deadline get one from the device's retry budget.
+ */
+static void dispatch_request(port_i2c_bus_ctx_t *ctx, port_i2c_req_t *req) {
+	int64_t now = esp_timer_get_time();
+	if (req->submit_us > 0) {
+		port_i2c_stats_record_wait(req->dev, now - req->submit_us);
+	} else {
+		req->submit_us = now;
+	}
+
+	if (req->deadline == 0) {
+		port_i2c_retry_policy_t policy;
+		device_policy(req->dev, &policy);
+		req->deadline = xTaskGetTickCount() + policy.budget_ticks;
+		if (req->deadline == 0)
+			req->deadline = 1; /* 0 means "unset" */
+	}
+
+	if (!device_busy(ctx, req->dev)) {
+		start_request(ctx, req);
+		return;
+	}
+
+	if (ctx->deferred_count < PORT_I2C_MAX_DEFERRED) {
+		memcpy(&ctx->deferred[ctx->deferred_count++], req, sizeof(*req));
+		return;
+	}
+
+	port_i2c_resp_t resp = {
+		.request_id = req->request_id,
+		.err = ESP_ERR_INVALID_STATE,
+	};
+	finish(req, &resp, 0);
+}
+
+/**
+ * @brief Start the deferred requests for `dev`, oldest first, until one
+ * parks or none are left.
+ *
+ * Most requests (writes, write-reads, batches, late ones) complete inside
+ * start_request(); stopping after the first would strand the rest, as
+ * nothing else restarts them while the device is idle.
+ */
+static void start_deferred_for(port_i2c_bus_ctx_t *ctx,
+							   i2c_master_dev_handle_t dev) {
+	int i = 0;
+	while (i < ctx->deferred_count && !device_busy(ctx, dev)) {
+		if (ctx->deferred[i].dev != dev) {
+			i++;
+			continue;
+		}
+
+		port_i2c_req_t req;
+		memcpy(&req, &ctx->deferred[i], sizeof(req));
+		memmove(&ctx->deferred[i], &ctx->deferred[i + 1],
+				(size_t)(ctx->deferred_count - i - 1) *
+					sizeof(ctx->deferred[0]));
+		ctx->deferred_count--;
+
+		start_request(ctx, &req);
+	}
+}
+
+/**
+ * @brief Complete or re-park a request after one read poll.
+ *
+ * A NACKed read (device still converting) is re-parked with a doubling
+ * poll interval rather than retried in place, so the bus stays free for
+ * other devices between polls. The request completes on the first good
+ * read, or fails once its deadline or the policy's poll limit is reached.
+ */
+static void read_polled(port_i2c_bus_ctx_t *ctx, port_i2c_parked_t *p) {
+	p->polls++;
+
+	TickType_t now = xTaskGetTickCount();
+	bool more_polls =
+		p->policy.max_polls == 0 || p->polls < p->policy.max_polls;
+	if (p->resp.err != ESP_OK && more_polls &&
+		!deadline_reached(now, p->req.deadline)) {
+		/* Poll again later, but never past the deadline */
+		TickType_t next = now + p->poll_ticks;
+		if (deadline_reached(next, p->req.deadline))
+			next = p->req.deadline;
+		p->ready_at = next;
+		p->resp.retries++;
+
+		TickType_t doubled = p->poll_ticks * 2;
+		p->poll_ticks = doubled < p->policy.poll_max_ticks
+							? doubled
+							: p->policy.poll_max_ticks;
+		if (p->poll_ticks == 0)
+			p->poll_ticks = 1;
+		return;
+	}
+
+	finish(&p->req, &p->resp, p->busy_us);
+	p->used = false;
+
+	start_deferred_for(ctx, p->req.dev);
+}
+
+/**
+ * @brief Collect the parked requests whose read poll is due.
+ *
+ * @return Number of slot indices written to `due`.
+ */
+static int collect_due(const port_i2c_bus_ctx_t *ctx,
+					   int due[PORT_I2C_MAX_PARKED]) {
+	TickType_t now = xTaskGetTickCount();
+	int n = 0;
+	for (int i = 0; i < PORT_I2C_MAX_PARKED; i++) {
+		const port_i2c_parked_t *p = &ctx->parked[i];
+		if (p->used && deadline_reached(now, p->ready_at))
+			due[n++] = i;
+	}
+	return n;
+}
+
+/**
+ * @brief Poll every due read, one at a time (sync transport).
+ */
+static void service_due_sync(port_i2c_bus_ctx_t *ctx) {
+	int due[PORT_I2C_MAX_PARKED];
+	int n = collect_due(ctx, due);
+
+	for (int k = 0; k < n; k++) {
+		port_i2c_parked_t *p = &ctx->parked[due[k]];
+
+		int64_t t0 = esp_timer_get_time();
+		p->resp.err = port_i2c_xfer_read(ctx->io, &p->req, &p->resp,
+										 p->policy.op_timeout_ms);
+		p->busy_us += esp_timer_get_time() - t0;
+
+		read_polled(ctx, p);
+	}
+}
+
+/**
+ * @brief Poll every due read with all of them in flight at once (async).
+ *
+ * Every due read is queued in the driver first, then the owner sleeps on
+ * each completion in turn. The driver runs them back to back from its
+ * interrupt, so the owner is woken once per completion instead of blocking
+ * through each transfer.
+ */
+static void service_due_async(port_i2c_bus_ctx_t *ctx) {
+	int due[PORT_I2C_MAX_PARKED];
+	int n = collect_due(ctx, due);
+	int ticket[PORT_I2C_MAX_PARKED];
+	int64_t start_us[PORT_I2C_MAX_PARKED];
+
+	for (int k = 0; k < n; k++) {
+		port_i2c_parked_t *p = &ctx->parked[due[k]];
+		start_us[k] = esp_timer_get_time();
+		ticket[k] = -1;
+
+		if (p->req.rx_len == 0) {
+			continue; /* write-only: nothing to read */
+		}
+		esp_err_t err = port_i2c_async_receive_start(
+			ctx->async, p->req.dev, p->req.rx, p->req.rx_len,
+			p->policy.op_timeout_ms, &ticket[k]);
+		if (err != ESP_OK) {
+			ticket[k] = -1;
+			port_i2c_xfer_read_done(&p->req, &p->resp, err);
+		}
+	}
+
+	int64_t prev_done = 0;
+	for (int k = 0; k < n; k++) {
+		port_i2c_parked_t *p = &ctx->parked[due[k]];
+
+		if (ticket[k] >= 0) {
+			int64_t done = 0;
+			esp_err_t err = port_i2c_async_wait(ctx->async, ticket[k],
+												p->policy.op_timeout_ms, &done);
+			port_i2c_xfer_read_done(&p->req, &p->resp, err);
+
+			/* Transfers run back to back: count only this one's bus time */
+			if (done > 0) {
+				int64_t from =
+					start_us[k] > prev_done ? start_us[k] : prev_done;
+				p->busy_us += done - from;
+				prev_done = done;
+			}
+		} else if (p->req.rx_len == 0) {
+			port_i2c_xfer_read_done(&p->req, &p->resp, ESP_OK);
+		}
+
+		read_polled(ctx, p);
+	}
+}
+
+/** Poll every parked request whose conversion time has elapsed. */
+static void service_due(port_i2c_bus_ctx_t *ctx) {
+	if (ctx->async) {
+		service_due_async(ctx);
+	} else {
+		service_due_sync(ctx);
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+/* Background scan                                                            */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief True if nothing needs the bus soon: no queued or deferred requests
+ * and no parked read due within PORT_I2C_SCAN_GUARD_TICKS.
+ */
+static bool bus_idle(const port_i2c_bus_ctx_t *ctx) {
+	return uxQueueMessagesWaiting(ctx->q) == 0 && ctx->deferred_count == 0 &&
+		   next_wait_ticks(ctx) > PORT_I2C_SCAN_GUARD_TICKS;
+}
+
+/** True if a registered device at `addr` has a parked request. */
+static bool addr_busy(const port_i2c_bus_ctx_t *ctx, uint8_t addr) {
+	bool busy = false;
+
+	portENTER_CRITICAL(&s_devices_lock);
+	for (int i = 0; i < s_device_count && !busy; i++) {
+		if (s_devices[i].ctx == ctx && s_devices[i].addr == addr)
+			busy = device_busy(ctx, s_devices[i].dev);
+	}
+	portEXIT_CRITICAL(&s_devices_lock);
+
+	return busy;
+}
+
+/**
+ * @brief Ticks until the owner should wake for the next scan probe.
+ *
+ * A due probe that has to wait for an idle gap does not shorten the sleep:
+ * whatever keeps the bus busy wakes the owner anyway, and the probe is
+ * retried after it has been handled.
+ */
+static TickType_t scan_wait_ticks(const port_i2c_bus_ctx_t *ctx) {
+	portENTER_CRITICAL(&s_devices_lock);
+	int n = ctx->scan.n;
+	TickType_t at = ctx->scan.next_at;
+	portEXIT_CRITICAL(&s_devices_lock);
+
+	if (n == 0)
+		return portMAX_DELAY;
+
+	TickType_t now = xTaskGetTickCount();
+	if (!deadline_reached(now, at))
+		return at - now;
+	return bus_idle(ctx) ? 0 : portMAX_DELAY;
+}
+
+/**
+ * @brief Probe the next scan address if one is due and the bus is idle.
+ *
+ * At most one address is probed per call, and probes are at least
+ * scan.spacing apart, so a scan costs one address phase per gap and never
+ * holds up a queued request or a due read. Addresses of devices that are
+ * converting are skipped (they NACK until the conversion ends).
+ */
+static void scan_step(port_i2c_bus_ctx_t *ctx) {
+	if (!bus_idle(ctx))
+		return;
+
+	TickType_t now = xTaskGetTickCount();
+	uint8_t addr = 0;
+	port_i2c_scan_cb_t cb = NULL;
+	void *arg = NULL;
+
+	portENTER_CRITICAL(&s_devices_lock);
+	if (ctx->scan.n > 0 && deadline_reached(now, ctx->scan.next_at)) {
+		if (ctx->scan.cursor >= ctx->scan.n)
+			ctx->scan.cursor = 0;
+		addr = ctx->scan.addrs[ctx->scan.cursor++];
+		cb = ctx->scan.cb;
+		arg = ctx->scan.arg;
+		ctx->scan.next_at = now + ctx->scan.spacing;
+	}
+	portEXIT_CRITICAL(&s_devices_lock);
+
+	if (!cb || addr_busy(ctx, addr))
+		return;
+
+	esp_err_t err = ctx->io->probe(ctx->io, ctx->bus, addr,
+								   PORT_I2C_SCAN_PROBE_TIMEOUT_MS);
+	cb(ctx->port, addr, err, arg);
+}
 
 /* -------------------------------------------------------------------------- */
 /* Internal Owner Task                                                        */
 /* -------------------------------------------------------------------------- */
 
 /**
- * @brief Port A I2C owner task.
+ * @brief Per-bus I2C owner task.
+ *
+ * One instance runs for every Grove port that has at least one registered
+ * device. Each serializes access to its own bus while overlapping device
+ * conversion times:
+ *  - Runs a request's command phase, then parks it until
+ *    post_cmd_delay_ticks has elapsed instead of sleeping on the bus
+ *  - Services other devices' requests while conversions are in progress
+ *  - Runs the read phase once a parked request's conversion time is up,
+ *    re-polling NACKed reads (per the device's retry policy) until the
+ *    request's deadline instead of blocking the bus on retries
+ *  - Replies (optionally) to the requester's reply queue
+ *  - Probes the scan addresses (port_i2c_service_set_scan()) one at a time
+ *    in idle gaps
  *
- * Serializes access to the Port A I2C bus by:
- *  - Blocking on the request queue
- *  - Executing the I2C operation for each request
- *  - Replying (optionally) to the requester's reply queue
+ * With CONFIG_PORT_I2C_ASYNC, transfers go through the driver's
+ * transaction queue: the owner queues them and sleeps until their
+ * completion interrupt, and due reads of several devices are queued
+ * together.
+ *
+ * Bus idle time during conversions is therefore shared: N devices with a
+ * 25-30 ms conversion each no longer cost N x 30 ms of serialized waiting.
+ * Separate buses run fully in parallel.
  *
  * Notes:
- *  - This task must be the only code path that touches Port A I2C devices
+ *  - This task must be the only code path that touches devices on its bus
  *    if you want strict single-owner arbitration.
+ *  - Requests for the same device are still executed in order, one at a
+ *    time; a device never receives a command while converting.
+ *  - Batched requests (req.ops) run to completion with nothing interleaved,
+ *    including any DELAY steps, and get a single reply.
  *  - If reply_queue is NULL, the response is effectively fire-and-forget.
+ *
+ * @param arg The bus context (port_i2c_bus_ctx_t *).
  */
 static void port_i2c_owner_task(void *arg) {
+	port_i2c_bus_ctx_t *ctx = (port_i2c_bus_ctx_t *)arg;
+
+	/* Outranks its creator: wait until bus_start() has published ctx->q */
+	(void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-	/* arg currently unused (common FreeRTOS pattern) */
 	port_i2c_req_t req;
 	for (;;) {
-		/* Block indefinitely until a request arrives */
-		if (xQueueReceive(port_q, &req, portMAX_DELAY) == pdTRUE) {
+		/* Sleep until a request arrives or a parked read or probe is due */
+		TickType_t wait = next_wait_ticks(ctx);
+		TickType_t scan_wait = scan_wait_ticks(ctx);
+		if (scan_wait < wait)
+			wait = scan_wait;
+		if (wait > PORT_I2C_OWNER_MAX_WAIT)
+			wait = PORT_I2C_OWNER_MAX_WAIT;
 
-			/* Populate response with correlation ID and pessimistic default */
-			port_i2c_resp_t resp = {
-				.request_id = req.request_id,
-				.err = ESP_FAIL,
-			};
+		if (xQueueReceive(ctx->q, &req, wait) == pdTRUE) {
+			dispatch_request(ctx, &req);
+		}
 
-			/* Execute transaction: command -> delay -> read bytes */
-			resp.err = port_i2c_xfer(&req, &resp);
+		service_due(ctx);
+		scan_step(ctx);
+	}
+}
 
-			/* Return response if the requester provided a reply queue */
-			if (req.reply_queue) {
-				(void)xQueueSend(req.reply_queue, &resp, pdMS_TO_TICKS(50));
-			}
-		}
+/** Undo a bus_start() that failed part way. */
+static void bus_release(port_i2c_bus_ctx_t *ctx) {
+	port_i2c_async_destroy(ctx->async);
+	ctx->async = NULL;
+	port_i2c_bus_deinit(ctx->bus);
+	ctx->bus = NULL;
+}
+
+/**
+ * @brief Bring up the bus, queue and owner task for a port (first use).
+ */
+static esp_err_t bus_start(port_i2c_bus_ctx_t *ctx, port_i2c_port_t port) {
+	if (ctx->q)
+		return ESP_OK;
+
+#if CONFIG_PORT_I2C_SIM
+	/* Device models answer through the transport; no bus is created */
+	ctx->io = port_i2c_sim_io(port);
+	const char *mode = "sim";
+#else
+	port_i2c_bus_config_t cfg;
+	esp_err_t err = port_i2c_get_default_bus_config(port, &cfg);
+	if (err != ESP_OK)
+		return err;
+
+	err = port_i2c_bus_init(&cfg, &ctx->bus);
+	if (err != ESP_OK) {
+		ESP_LOGE(TAG, "port %d: bus init failed: %s", (int)port,
+				 esp_err_to_name(err));
+		return err;
+	}
+
+	ctx->io = &port_i2c_io_sync;
+	const char *mode = "sync";
+#if CONFIG_PORT_I2C_ASYNC
+	err = port_i2c_async_create(&ctx->async);
+	if (err != ESP_OK) {
+		bus_release(ctx);
+		return err;
+	}
+	ctx->io = port_i2c_async_io(ctx->async);
+	mode = "async";
+#endif
+#endif
+
+	/* Depth chosen for expected request burst; tune as needed */
+	QueueHandle_t q = xQueueCreate(8, sizeof(port_i2c_req_t));
+	if (!q) {
+		bus_release(ctx);
+		return ESP_ERR_NO_MEM;
+	}
+	ctx->port = port;
+
+	/* Dedicated owner task pinned to core 0 (tune stack/priority as needed) */
+	static const char *const names[PORT_I2C_PORT_COUNT] = {
+		"port_i2c_a",
+		"port_i2c_b",
+		"port_i2c_c",
+	};
+	TaskHandle_t task = NULL;
+	if (xTaskCreatePinnedToCore(port_i2c_owner_task, names[port], 4096, ctx,
+								6, &task, 0) != pdPASS) {
+		vQueueDelete(q);
+		bus_release(ctx);
+		return ESP_ERR_NO_MEM;
 	}
+
+	port_i2c_stats_set_owner(port, task);
+
+	/* Publish the queue last: non-NULL q means the bus is ready */
+	ctx->q = q;
+	(void)xTaskNotifyGive(task);
+	ESP_LOGI(TAG, "port %d: owner started (%s)", (int)port, mode);
+	return ESP_OK;
 }
 
 /* -------------------------------------------------------------------------- */
 /* Public Service API                                                         */
 /* -------------------------------------------------------------------------- */
 
-void port_i2c_service_start(void) {
-	/* Lazy-create request queue on first start */
-	if (!port_q) {
-		/* Depth chosen for expected request burst; tune as needed */
-		port_q = xQueueCreate(8, sizeof(port_i2c_req_t));
+esp_err_t port_i2c_service_add_device(port_i2c_port_t port, uint8_t addr,
+									  uint32_t scl_hz,
+									  i2c_master_dev_handle_t *out_dev) {
+	if (!out_dev || (int)port < 0 || port >= PORT_I2C_PORT_COUNT)
+		return ESP_ERR_INVALID_ARG;
+	if (s_device_count >= PORT_I2C_MAX_DEVICES)
+		return ESP_ERR_NO_MEM;
+
+	port_i2c_bus_ctx_t *ctx = &s_buses[port];
+	esp_err_t err = bus_start(ctx, port);
+	if (err != ESP_OK)
+		return err;
+
+#if CONFIG_PORT_I2C_SIM
+	err = port_i2c_sim_add_device(port, addr, scl_hz, out_dev);
+#else
+	err = port_i2c_add_device(ctx->bus, addr, scl_hz, out_dev);
+#endif
+	if (err != ESP_OK)
+		return err;
+
+	if (ctx->async) {
+		err = port_i2c_async_attach(ctx->async, *out_dev);
+		if (err != ESP_OK) {
+			port_i2c_rm_device(*out_dev);
+			*out_dev = NULL;
+			return err;
+		}
 	}
 
-	/* Dedicated owner task pinned to core 0 (tune stack/priority as needed) */
-	xTaskCreatePinnedToCore(port_i2c_owner_task, "port_i2c_service", 4096, NULL,
-							6, NULL, 0);
+	/* Table sizes match, so this only fails if the device table would too */
+	(void)port_i2c_stats_add_device(*out_dev, port, addr);
+
+	const port_i2c_retry_policy_t def = PORT_I2C_RETRY_POLICY_DEFAULT;
+	portENTER_CRITICAL(&s_devices_lock);
+	s_devices[s_device_count].dev = *out_dev;
+	s_devices[s_device_count].ctx = ctx;
+	s_devices[s_device_count].addr = addr;
+	s_devices[s_device_count].policy = def;
+	s_device_count++;
+	portEXIT_CRITICAL(&s_devices_lock);
+
+	return ESP_OK;
 }
 
-QueueHandle_t port_i2c_service_queue(void) { return port_q; }
+esp_err_t port_i2c_service_start_bus(port_i2c_port_t port) {
+	if ((int)port < 0 || port >= PORT_I2C_PORT_COUNT)
+		return ESP_ERR_INVALID_ARG;
+	return bus_start(&s_buses[port], port);
+}
+
+esp_err_t port_i2c_service_set_scan(port_i2c_port_t port, const uint8_t *addrs,
+									int n, TickType_t period,
+									port_i2c_scan_cb_t cb, void *arg) {
+	if ((int)port < 0 || port >= PORT_I2C_PORT_COUNT || n < 0 ||
+		n > PORT_I2C_SCAN_MAX_ADDRS || (n > 0 && (!addrs || !cb)))
+		return ESP_ERR_INVALID_ARG;
+
+	port_i2c_bus_ctx_t *ctx = &s_buses[port];
+	if (!ctx->q)
+		return ESP_ERR_INVALID_STATE;
+
+	TickType_t spacing = n > 0 ? period / (TickType_t)n : 0;
+	if (spacing == 0)
+		spacing = 1;
+
+	portENTER_CRITICAL(&s_devices_lock);
+	if (n > 0)
+		memcpy(ctx->scan.addrs, addrs, (size_t)n);
+	ctx->scan.n = n;
+	ctx->scan.cursor = 0;
+	ctx->scan.spacing = spacing;
+	ctx->scan.next_at = xTaskGetTickCount();
+	ctx->scan.cb = cb;
+	ctx->scan.arg = arg;
+	portEXIT_CRITICAL(&s_devices_lock);
+
+	return ESP_OK;
+}
+
+esp_err_t
+port_i2c_service_set_retry_policy(i2c_master_dev_handle_t dev,
+								  const port_i2c_retry_policy_t *policy) {
+	if (!dev || !policy || policy->op_timeout_ms == 0 ||
+		policy->budget_ticks == 0)
+		return ESP_ERR_INVALID_ARG;
+
+	esp_err_t err = ESP_ERR_NOT_FOUND;
+	portENTER_CRITICAL(&s_devices_lock);
+	for (int i = 0; i < s_device_count; i++) {
+		if (s_devices[i].dev == dev) {
+			s_devices[i].policy = *policy;
+			err = ESP_OK;
+			break;
+		}
+	}
+	portEXIT_CRITICAL(&s_devices_lock);
+
+	return err;
+}
+
+esp_err_t port_i2c_service_submit(const port_i2c_req_t *req,
+								  TickType_t timeout) {
+	if (!req)
+		return ESP_ERR_INVALID_ARG;
+
+	QueueHandle_t q = port_i2c_service_queue_for(req->dev);
+	if (!q)
+		return ESP_ERR_INVALID_STATE;
+
+	port_i2c_req_t stamped;
+	memcpy(&stamped, req, sizeof(stamped));
+	stamped.submit_us = esp_timer_get_time();
+
+	return xQueueSend(q, &stamped, timeout) == pdTRUE ? ESP_OK
+													 : ESP_ERR_TIMEOUT;
+}
+
+QueueHandle_t port_i2c_service_queue(port_i2c_port_t port) {
+	if ((int)port < 0 || port >= PORT_I2C_PORT_COUNT)
+		return NULL;
+	return s_buses[port].q;
+}
+
+QueueHandle_t port_i2c_service_queue_for(i2c_master_dev_handle_t dev) {
+	QueueHandle_t q = NULL;
+
+	portENTER_CRITICAL(&s_devices_lock);
+	for (int i = 0; i < s_device_count; i++) {
+		if (s_devices[i].dev == dev) {
+			q = s_devices[i].ctx->q;
+			break;
+		}
+	}
+	portEXIT_CRITICAL(&s_devices_lock);
+
+	return q;
+}
+
+i2c_master_bus_handle_t port_i2c_service_bus(port_i2c_port_t port) {
+	if ((int)port < 0 || port >= PORT_I2C_PORT_COUNT)
+		return NULL;
+	return s_buses[port].q ? s_buses[port].bus : NULL;
+}
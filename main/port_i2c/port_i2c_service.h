@@ -4,28 +4,187 @@
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "port_i2c.h" // port_i2c_port_t
+#include "port_i2c_types.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /**
- * @brief Start the Port A I2C service.
+ * @brief How the bus owner retries reads for one device.
  *
- * Creates the service request queue (if needed) and starts the owner task.
- * Must be called before using port_i2c_service_queue().
+ * A read that NACKs (device still converting) is re-polled after
+ * poll_ticks, doubling up to poll_max_ticks, until it succeeds, max_polls
+ * attempts have been made, or the request's deadline passes. The bus is
+ * released between polls, so a failing device cannot stall healthy ones
+ * for longer than one op_timeout_ms per poll.
  */
-void port_i2c_service_start(void);
+typedef struct {
+	TickType_t budget_ticks;   ///< Deadline for requests that set none
+	TickType_t poll_ticks;	   ///< Wait before the first re-poll
+	TickType_t poll_max_ticks; ///< Cap for the doubling re-poll interval
+	uint8_t max_polls;		   ///< Max read attempts (0 = until deadline)
+	uint16_t op_timeout_ms;	   ///< Driver timeout per bus operation
+} port_i2c_retry_policy_t;
+
+/** Policy applied to newly added devices. */
+#define PORT_I2C_RETRY_POLICY_DEFAULT                                          \
+	{                                                                          \
+		.budget_ticks = pdMS_TO_TICKS(500),                                    \
+		.poll_ticks = pdMS_TO_TICKS(10),                                       \
+		.poll_max_ticks = pdMS_TO_TICKS(50),                                   \
+		.max_polls = 8,                                                        \
+		.op_timeout_ms = 20,                                                   \
+	}
+
+/** Max addresses one bus can scan. */
+#define PORT_I2C_SCAN_MAX_ADDRS 8
+
+/**
+ * @brief Result of one background scan probe.
+ *
+ * Runs in the bus owner task: keep it short and never block (post the
+ * result to another task instead).
+ *
+ * @param port Bus the probe ran on.
+ * @param addr Probed 7-bit address.
+ * @param err  ESP_OK if the address ACKed, ESP_ERR_NOT_FOUND if not, or
+ *             another probe error (e.g. ESP_ERR_TIMEOUT on a stuck bus).
+ * @param arg  Value passed to port_i2c_service_set_scan().
+ */
+typedef void (*port_i2c_scan_cb_t)(port_i2c_port_t port, uint8_t addr,
+								   esp_err_t err, void *arg);
+
+/**
+ * @brief Register an external I2C device on a Grove port.
+ *
+ * On the first device for a port, this also initializes that port's bus,
+ * creates its request queue and starts its owner task. Each port gets its
+ * own owner, so devices on different ports transact in parallel.
+ *
+ * Not reentrant: call from a single task (normally the sensor discovery
+ * task, see sensor_discovery.h).
+ *
+ * Note: ESP32-S3 has two I2C controllers and the BSP system bus uses one,
+ * so initializing a second external port fails with the error from
+ * i2c_new_master_bus() unless the board frees a controller.
+ *
+ * @param[in]  port    Grove port the device is wired to.
+ * @param[in]  addr    7-bit I2C device address.
+ * @param[in]  scl_hz  Clock speed for this device (Hz).
+ * @param[out] out_dev Receives the device handle used in requests.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG for bad args
+ *      - ESP_ERR_NO_MEM if the device table or task/queue allocation is full
+ *      - Other ESP-IDF error codes from bus or device creation
+ */
+esp_err_t port_i2c_service_add_device(port_i2c_port_t port, uint8_t addr,
+									  uint32_t scl_hz,
+									  i2c_master_dev_handle_t *out_dev);
+
+/**
+ * @brief Bring up a port's bus and owner task without adding a device.
+ *
+ * Lets a port be scanned before anything has been found on it. No-op if
+ * the bus is already running. Same threading rules as
+ * port_i2c_service_add_device().
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or the bus/task creation error.
+ */
+esp_err_t port_i2c_service_start_bus(port_i2c_port_t port);
+
+/**
+ * @brief Probe a set of addresses on a bus in the background.
+ *
+ * The owner task probes one address at a time with i2c_probe_addr(),
+ * cycling through `addrs` so that each is probed about once per `period`.
+ * A probe only runs in an idle gap: nothing queued or deferred and no
+ * parked read due within the next 10 ms, so scanning never delays real
+ * transactions. Addresses of registered devices that are converting are
+ * skipped for that round. Each result is passed to `cb`.
+ *
+ * Replaces any previous scan of the port; n == 0 stops scanning.
+ *
+ * @param[in] port   Bus to scan (must be started).
+ * @param[in] addrs  7-bit addresses to probe (copied).
+ * @param[in] n      Number of addresses (0..PORT_I2C_SCAN_MAX_ADDRS).
+ * @param[in] period Target time between two probes of the same address.
+ * @param[in] cb     Result callback (runs in the owner task).
+ * @param[in] arg    Passed to cb.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG for a bad port, count, or NULL addrs/cb
+ *      - ESP_ERR_INVALID_STATE if the bus has not been started
+ */
+esp_err_t port_i2c_service_set_scan(port_i2c_port_t port, const uint8_t *addrs,
+									int n, TickType_t period,
+									port_i2c_scan_cb_t cb, void *arg);
 
 /**
- * @brief Get the Port A I2C service request queue.
+ * @brief Get the request queue of a port's owner task.
  *
  * Requesters send port_i2c_req_t messages to this queue.
  *
- * @return Queue handle for Port A service requests (NULL if service not
- * started).
+ * @return Queue handle (NULL if no device has been added on that port).
+ */
+QueueHandle_t port_i2c_service_queue(port_i2c_port_t port);
+
+/**
+ * @brief Get the request queue of the bus a device was registered on.
+ *
+ * This is how requesters route to the right owner at runtime without
+ * knowing which port their device is wired to.
+ *
+ * @param[in] dev Handle returned by port_i2c_service_add_device().
+ *
+ * @return Queue handle (NULL if dev is not registered).
+ */
+QueueHandle_t port_i2c_service_queue_for(i2c_master_dev_handle_t dev);
+
+/**
+ * @brief Replace a device's retry policy.
+ *
+ * Takes effect for requests started after the call.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG for NULL args or a zero budget/op timeout
+ *      - ESP_ERR_NOT_FOUND if dev is not registered
+ */
+esp_err_t
+port_i2c_service_set_retry_policy(i2c_master_dev_handle_t dev,
+								  const port_i2c_retry_policy_t *policy);
+
+/**
+ * @brief Submit a request to the owner of req->dev's bus.
+ *
+ * Equivalent to sending to port_i2c_service_queue_for(req->dev), but also
+ * stamps the submit time so the owner can account queue wait and
+ * end-to-end latency (see port_i2c_stats.h).
+ *
+ * @param[in] req     Request to copy into the queue.
+ * @param[in] timeout Max time to wait for queue space.
+ *
+ * @return
+ *      - ESP_OK once queued
+ *      - ESP_ERR_INVALID_ARG if req is NULL
+ *      - ESP_ERR_INVALID_STATE if req->dev is not registered
+ *      - ESP_ERR_TIMEOUT if the queue stayed full
+ */
+esp_err_t port_i2c_service_submit(const port_i2c_req_t *req,
+								  TickType_t timeout);
+
+/**
+ * @brief Get the bus handle of a port.
+ *
+ * @return Bus handle (NULL if the port has not been started, or always with
+ *         CONFIG_PORT_I2C_SIM).
  */
-QueueHandle_t port_i2c_service_queue(void);
+i2c_master_bus_handle_t port_i2c_service_bus(port_i2c_port_t port);
 
 #ifdef __cplusplus
 }
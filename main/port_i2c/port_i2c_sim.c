@@ -0,0 +1,461 @@
+#include "port_i2c_sim.h"
+
+#include <string.h>
+
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "sensirion_utils.h" // sensirion_encode/decode_words()
+
+/* Initial fault injection settings (changeable at runtime). */
+#if CONFIG_PORT_I2C_SIM
+#define SIM_NACK_PERMILLE CONFIG_PORT_I2C_SIM_NACK_PERMILLE
+#define SIM_CRC_PERMILLE CONFIG_PORT_I2C_SIM_CRC_PERMILLE
+#define SIM_EXTRA_LATENCY_US CONFIG_PORT_I2C_SIM_EXTRA_LATENCY_US
+#else
+#define SIM_NACK_PERMILLE 0
+#define SIM_CRC_PERMILLE 0
+#define SIM_EXTRA_LATENCY_US 0
+#endif
+
+/* NACK as reported by the IDF >= 5.3 master driver (see port_i2c_is_nack). */
+#define SIM_ERR_NACK ESP_ERR_INVALID_RESPONSE
+
+/* Clock used for probes (matches the real probe's address-only transfer). */
+#define SIM_PROBE_SCL_HZ 100000
+
+/* SGP30 reports fixed 400 ppm / 0 ppb for this long after IAQ init. */
+#define SGP30_WARMUP_US (15 * 1000 * 1000)
+
+/* Longest reply any model produces (SHT40/SGP30 serial: 3 words). */
+#define SIM_MAX_REPLY 9
+
+typedef struct sim_dev sim_dev_t;
+
+/**
+ * @brief Behaviour of one device type.
+ */
+typedef struct {
+	uint8_t cmd_len; ///< Command width in bytes (1 or 2)
+	/**
+	 * Start a command (args = bytes after the command word). Prepares the
+	 * reply, if any, and returns the conversion time in us, or -1 to NACK.
+	 */
+	int32_t (*command)(sim_dev_t *d, uint16_t cmd, const uint8_t *args,
+					   size_t args_len, int64_t now);
+} sim_model_t;
+
+/**
+ * @brief State of one simulated device (guarded by s_lock).
+ */
+struct sim_dev {
+	const sim_model_t *model;
+	uint8_t addr;
+	bool present;
+	uint32_t scl_hz;
+	int64_t ready_us;  ///< End of the current conversion
+	uint8_t reply[SIM_MAX_REPLY];
+	uint8_t reply_len; ///< Bytes readable once ready (0 = NACK reads)
+	uint32_t samples;  ///< Measurements taken (drives the waveforms)
+	int64_t init_us;   ///< SGP30 IAQ init time (0 = not initialized)
+	uint16_t baseline_eco2;
+	uint16_t baseline_tvoc;
+};
+
+static int32_t sht40_command(sim_dev_t *d, uint16_t cmd, const uint8_t *args,
+							 size_t args_len, int64_t now);
+static int32_t sgp30_command(sim_dev_t *d, uint16_t cmd, const uint8_t *args,
+							 size_t args_len, int64_t now);
+
+static const sim_model_t s_sht40_model = {1, sht40_command};
+static const sim_model_t s_sgp30_model = {2, sgp30_command};
+
+/* Device bank present on every port. */
+static const struct {
+	uint8_t addr;
+	const sim_model_t *model;
+	bool plugged; ///< Plugged in at boot
+} s_sockets[] = {
+	{0x44, &s_sht40_model, true},
+	{0x45, &s_sht40_model, false},
+	{0x46, &s_sht40_model, false},
+	{0x58, &s_sgp30_model, true},
+};
+#define SIM_SOCKETS (sizeof(s_sockets) / sizeof(s_sockets[0]))
+
+static sim_dev_t s_devs[PORT_I2C_PORT_COUNT][SIM_SOCKETS];
+static port_i2c_io_t s_io[PORT_I2C_PORT_COUNT];
+static bool s_ready;
+
+static port_i2c_sim_faults_t s_faults = {
+	.nack_permille = SIM_NACK_PERMILLE,
+	.crc_permille = SIM_CRC_PERMILLE,
+	.extra_latency_us = SIM_EXTRA_LATENCY_US,
+};
+static uint32_t s_rng = 0x2545F491;
+
+/* Device state and fault settings are shared by every owner task. */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* -------------------------------------------------------------------------- */
+/* Helpers                                                                    */
+/* -------------------------------------------------------------------------- */
+
+/** True with probability permille/1000 (xorshift32; caller holds s_lock). */
+static bool roll(uint16_t permille) {
+	if (permille == 0)
+		return false;
+	s_rng ^= s_rng << 13;
+	s_rng ^= s_rng >> 17;
+	s_rng ^= s_rng << 5;
+	return s_rng % 1000 < permille;
+}
+
+/** 0, 1, ... half, half - 1, ... 0: slow waveform for synthetic values. */
+static int32_t triangle(uint32_t n, uint32_t half) {
+	uint32_t p = n % (2 * half);
+	return (int32_t)(p < half ? p : 2 * half - p);
+}
+
+/** Make `n` words (with CRCs) the device's next read. */
+static void set_reply(sim_dev_t *d, const uint16_t *words, int n) {
+	d->reply_len =
+		(uint8_t)sensirion_encode_words(words, n, d->reply, sizeof(d->reply));
+}
+
+/** Back to power-on state (caller holds s_lock). */
+static void power_cycle(sim_dev_t *d) {
+	d->ready_us = 0;
+	d->reply_len = 0;
+	d->init_us = 0;
+	d->baseline_eco2 = 0;
+	d->baseline_tvoc = 0;
+}
+
+/**
+ * @brief Hold the caller for the bus time of an n-byte transfer.
+ *
+ * Whole ticks are slept (a real transfer blocks the task without using the
+ * CPU); the remainder is spun in esp_rom_delay_us().
+ */
+static void bus_time(uint32_t scl_hz, size_t n) {
+	portENTER_CRITICAL(&s_lock);
+	uint32_t extra = s_faults.extra_latency_us;
+	portEXIT_CRITICAL(&s_lock);
+
+	uint64_t us = (uint64_t)(n + 1) * 9 * 1000000 / (scl_hz ? scl_hz : 1);
+	us += extra;
+
+	const uint64_t tick_us = (uint64_t)portTICK_PERIOD_MS * 1000;
+	if (us >= tick_us) {
+		vTaskDelay((TickType_t)(us / tick_us));
+		us %= tick_us;
+	}
+	esp_rom_delay_us((uint32_t)us);
+}
+
+/** Device acknowledges its address (caller holds s_lock). */
+static bool acks(const sim_dev_t *d) {
+	return d->present && !roll(s_faults.nack_permille);
+}
+
+static sim_dev_t *find_dev(port_i2c_port_t port, uint8_t addr) {
+	if ((int)port < 0 || port >= PORT_I2C_PORT_COUNT)
+		return NULL;
+	for (size_t i = 0; i < SIM_SOCKETS; i++) {
+		if (s_devs[port][i].addr == addr)
+			return &s_devs[port][i];
+	}
+	return NULL;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Device models                                                              */
+/* -------------------------------------------------------------------------- */
+
+static int32_t sht40_command(sim_dev_t *d, uint16_t cmd, const uint8_t *args,
+							 size_t args_len, int64_t now) {
+	(void)args;
+	(void)now;
+	if (args_len != 0)
+		return -1;
+
+	int32_t conv_us;
+	switch (cmd) {
+	case 0xFD: // high precision
+		conv_us = 8300;
+		break;
+	case 0xF6: // medium precision
+		conv_us = 4500;
+		break;
+	case 0xE0: // low precision
+		conv_us = 1700;
+		break;
+	case 0x89: // serial number
+		set_reply(d, (const uint16_t[]){0x1234, d->addr}, 2);
+		return 1000;
+	case 0x94: // soft reset
+		d->reply_len = 0;
+		return 1000;
+	default:
+		return -1;
+	}
+
+	/* 21.00..22.50 degC and 45..48 %RH over a 60-sample cycle */
+	d->samples++;
+	int32_t t_centi = 2100 + triangle(d->samples, 30) * 5;
+	int32_t rh_centi = 4500 + triangle(d->samples, 30) * 10;
+	const uint16_t words[2] = {
+		(uint16_t)((t_centi + 4500) * 65535 / 17500),
+		(uint16_t)((rh_centi + 600) * 65535 / 12500),
+	};
+	set_reply(d, words, 2);
+	return conv_us;
+}
+
+static int32_t sgp30_command(sim_dev_t *d, uint16_t cmd, const uint8_t *args,
+							 size_t args_len, int64_t now) {
+	switch (cmd) {
+	case 0x2003: // IAQ init
+		if (args_len != 0)
+			return -1;
+		d->init_us = now ? now : 1;
+		d->baseline_eco2 = 0;
+		d->baseline_tvoc = 0;
+		d->reply_len = 0;
+		return 10000;
+
+	case 0x2008: { // measure IAQ
+		if (args_len != 0)
+			return -1;
+		d->samples++;
+		uint16_t eco2 = 400;
+		uint16_t tvoc = 0;
+		if (d->init_us && now - d->init_us >= SGP30_WARMUP_US) {
+			eco2 = (uint16_t)(400 + triangle(d->samples, 60) * 20);
+			tvoc = (uint16_t)(triangle(d->samples, 60) * 3);
+		}
+		set_reply(d, (const uint16_t[]){eco2, tvoc}, 2);
+		return 12000;
+	}
+
+	case 0x2015: { // get baseline: eCO2 then TVOC
+		if (args_len != 0)
+			return -1;
+		const uint16_t words[2] = {
+			d->baseline_eco2 ? d->baseline_eco2
+							 : (uint16_t)(0x8000 + d->samples),
+			d->baseline_tvoc ? d->baseline_tvoc
+							 : (uint16_t)(0x8800 + d->samples),
+		};
+		set_reply(d, words, 2);
+		return 10000;
+	}
+
+	case 0x201E: { // set baseline: TVOC then eCO2
+		uint16_t words[2];
+		if (args_len != 6)
+			return -1;
+		if (sensirion_decode_words(args, args_len, words, 2, NULL) == ESP_OK) {
+			d->baseline_tvoc = words[0];
+			d->baseline_eco2 = words[1];
+		}
+		d->reply_len = 0;
+		return 10000;
+	}
+
+	case 0x2061: // set absolute humidity
+		if (args_len != 3 ||
+			sensirion_decode_words(args, args_len, NULL, 1, NULL) != ESP_OK)
+			return -1;
+		d->reply_len = 0;
+		return 10000;
+
+	case 0x202F: // get feature set
+		if (args_len != 0)
+			return -1;
+		set_reply(d, (const uint16_t[]){0x0022}, 1);
+		return 10000;
+
+	default:
+		return -1;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+/* Transport                                                                  */
+/* -------------------------------------------------------------------------- */
+
+static esp_err_t sim_transmit(const port_i2c_io_t *io,
+							  i2c_master_dev_handle_t dev, const uint8_t *tx,
+							  size_t tx_len, int timeout_ms) {
+	(void)io;
+	(void)timeout_ms;
+	sim_dev_t *d = (sim_dev_t *)dev;
+	if (!d || !tx || tx_len == 0)
+		return ESP_ERR_INVALID_ARG;
+
+	bus_time(d->scl_hz, tx_len);
+	int64_t now = esp_timer_get_time();
+	esp_err_t err = SIM_ERR_NACK;
+
+	portENTER_CRITICAL(&s_lock);
+	/* A converting device NACKs new commands */
+	if (acks(d) && now >= d->ready_us && tx_len >= d->model->cmd_len) {
+		uint16_t cmd = d->model->cmd_len == 2
+						   ? (uint16_t)((tx[0] << 8) | tx[1])
+						   : tx[0];
+		size_t n = d->model->cmd_len;
+		int32_t conv = d->model->command(d, cmd, tx + n, tx_len - n, now);
+		if (conv >= 0) {
+			d->ready_us = now + conv;
+			err = ESP_OK;
+		}
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return err;
+}
+
+static esp_err_t sim_receive(const port_i2c_io_t *io,
+							 i2c_master_dev_handle_t dev, uint8_t *rx,
+							 size_t rx_len, int timeout_ms) {
+	(void)io;
+	(void)timeout_ms;
+	sim_dev_t *d = (sim_dev_t *)dev;
+	if (!d || !rx || rx_len == 0)
+		return ESP_ERR_INVALID_ARG;
+
+	bus_time(d->scl_hz, rx_len);
+	int64_t now = esp_timer_get_time();
+	esp_err_t err = SIM_ERR_NACK;
+
+	portENTER_CRITICAL(&s_lock);
+	/* Nothing to read, or still converting: NACK */
+	if (acks(d) && d->reply_len > 0 && now >= d->ready_us) {
+		size_t n = rx_len < d->reply_len ? rx_len : d->reply_len;
+		memcpy(rx, d->reply, n);
+		memset(rx + n, 0xFF, rx_len - n); // released SDA reads as 1s
+
+		size_t words = n / SENSIRION_WORD_SIZE;
+		if (words > 0 && roll(s_faults.crc_permille)) {
+			rx[(s_rng % words) * SENSIRION_WORD_SIZE + 2] ^= 0x01;
+		}
+		d->reply_len = 0;
+		err = ESP_OK;
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return err;
+}
+
+static esp_err_t sim_transmit_receive(const port_i2c_io_t *io,
+									  i2c_master_dev_handle_t dev,
+									  const uint8_t *tx, size_t tx_len,
+									  uint8_t *rx, size_t rx_len,
+									  int timeout_ms) {
+	/* No time between the phases: a converting command NACKs the read */
+	esp_err_t err = sim_transmit(io, dev, tx, tx_len, timeout_ms);
+	if (err != ESP_OK)
+		return err;
+	return sim_receive(io, dev, rx, rx_len, timeout_ms);
+}
+
+static esp_err_t sim_probe(const port_i2c_io_t *io,
+						   i2c_master_bus_handle_t bus, uint8_t addr,
+						   int timeout_ms) {
+	(void)bus;
+	(void)timeout_ms;
+	port_i2c_port_t port = (port_i2c_port_t)(intptr_t)io->ctx;
+
+	bus_time(SIM_PROBE_SCL_HZ, 0);
+
+	portENTER_CRITICAL(&s_lock);
+	sim_dev_t *d = find_dev(port, addr);
+	bool ack = d && acks(d);
+	portEXIT_CRITICAL(&s_lock);
+
+	return ack ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Public API                                                                 */
+/* -------------------------------------------------------------------------- */
+
+const port_i2c_io_t *port_i2c_sim_io(port_i2c_port_t port) {
+	if ((int)port < 0 || port >= PORT_I2C_PORT_COUNT)
+		return NULL;
+
+	portENTER_CRITICAL(&s_lock);
+	if (!s_ready) {
+		for (int p = 0; p < PORT_I2C_PORT_COUNT; p++) {
+			for (size_t i = 0; i < SIM_SOCKETS; i++) {
+				sim_dev_t *d = &s_devs[p][i];
+				memset(d, 0, sizeof(*d));
+				d->model = s_sockets[i].model;
+				d->addr = s_sockets[i].addr;
+				d->present = s_sockets[i].plugged;
+				d->scl_hz = SIM_PROBE_SCL_HZ;
+			}
+			s_io[p].transmit = sim_transmit;
+			s_io[p].receive = sim_receive;
+			s_io[p].transmit_receive = sim_transmit_receive;
+			s_io[p].probe = sim_probe;
+			s_io[p].ctx = (void *)(intptr_t)p;
+		}
+		s_ready = true;
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return &s_io[port];
+}
+
+esp_err_t port_i2c_sim_add_device(port_i2c_port_t port, uint8_t addr,
+								  uint32_t scl_hz,
+								  i2c_master_dev_handle_t *out_dev) {
+	if (!out_dev || scl_hz == 0 || !port_i2c_sim_io(port))
+		return ESP_ERR_INVALID_ARG;
+
+	portENTER_CRITICAL(&s_lock);
+	sim_dev_t *d = find_dev(port, addr);
+	if (d)
+		d->scl_hz = scl_hz;
+	portEXIT_CRITICAL(&s_lock);
+
+	if (!d)
+		return ESP_ERR_NOT_FOUND;
+	*out_dev = (i2c_master_dev_handle_t)d;
+	return ESP_OK;
+}
+
+esp_err_t port_i2c_sim_set_present(port_i2c_port_t port, uint8_t addr,
+								   bool present) {
+	if (!port_i2c_sim_io(port))
+		return ESP_ERR_INVALID_ARG;
+
+	esp_err_t err = ESP_ERR_NOT_FOUND;
+	portENTER_CRITICAL(&s_lock);
+	sim_dev_t *d = find_dev(port, addr);
+	if (d) {
+		if (d->present != present)
+			power_cycle(d);
+		d->present = present;
+		err = ESP_OK;
+	}
+	portEXIT_CRITICAL(&s_lock);
+
+	return err;
+}
+
+void port_i2c_sim_set_faults(const port_i2c_sim_faults_t *faults) {
+	if (!faults)
+		return;
+
+	portENTER_CRITICAL(&s_lock);
+	s_faults = *faults;
+	if (faults->seed)
+		s_rng = faults->seed;
+	portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "port_i2c.h" // port_i2c_io_t, port_i2c_port_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fault injection settings for the simulated bus.
+ *
+ * Probabilities are in 1/1000 and are drawn from a deterministic PRNG, so a
+ * given seed replays the same fault sequence.
+ */
+typedef struct {
+	uint16_t nack_permille;	   ///< Chance that any bus operation NACKs
+	uint16_t crc_permille;	   ///< Chance that a read frame has a bad CRC
+	uint32_t extra_latency_us; ///< Bus time added to every operation
+	uint32_t seed;			   ///< PRNG seed (0 keeps the current sequence)
+} port_i2c_sim_faults_t;
+
+/**
+ * @brief Transport that answers from device models instead of hardware.
+ *
+ * Each port has its own bank of simulated devices:
+ *  - SHT40 at 0x44 (plugged in), 0x45 and 0x46 (unplugged): measurement
+ *    commands 0xFD/0xF6/0xE0 with datasheet conversion times, serial
+ *    number 0x89, soft reset 0x94
+ *  - SGP30 at 0x58 (plugged in): IAQ init/measure, get/set baseline,
+ *    set humidity and get feature set, with the 15 s warm-up after init
+ *
+ * Devices NACK reads until their conversion time has elapsed and NACK new
+ * commands while converting, like the real parts. Frames carry correct
+ * Sensirion CRCs and slowly varying values. Bus time per operation follows
+ * the device's SCL clock (9 bit times per byte, address included) plus any
+ * injected latency; the calling task is blocked for that long.
+ *
+ * Device handles returned by port_i2c_sim_add_device() are only valid with
+ * this transport.
+ */
+const port_i2c_io_t *port_i2c_sim_io(port_i2c_port_t port);
+
+/**
+ * @brief Create a handle for a simulated device.
+ *
+ * Succeeds for any modelled address, plugged in or not (like adding a real
+ * device, which does not touch the bus).
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_NOT_FOUND if no model
+ *         exists at addr.
+ */
+esp_err_t port_i2c_sim_add_device(port_i2c_port_t port, uint8_t addr,
+								  uint32_t scl_hz,
+								  i2c_master_dev_handle_t *out_dev);
+
+/**
+ * @brief Plug a simulated device in or out.
+ *
+ * An unplugged device NACKs everything. Plugging it back in power cycles
+ * it (pending measurements, SGP30 init and baseline are lost).
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_NOT_FOUND.
+ */
+esp_err_t port_i2c_sim_set_present(port_i2c_port_t port, uint8_t addr,
+								   bool present);
+
+/**
+ * @brief Replace the fault injection settings (initially from Kconfig).
+ *
+ * Safe to call from any task; applies to the next bus operation.
+ */
+void port_i2c_sim_set_faults(const port_i2c_sim_faults_t *faults);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,303 @@
+#include "port_i2c_stats.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#define TAG "port_i2c_stats"
+
+/* Max devices tracked (matches the service's device table). */
+#define PORT_I2C_STATS_MAX_DEVICES 8
+
+/* Histogram bucket upper bounds in microseconds (last bucket is open). */
+static const uint32_t s_lat_bounds_us[PORT_I2C_STATS_LAT_BUCKETS - 1] = {
+	1000, 2000, 5000, 10000, 20000, 50000, 100000,
+};
+
+static port_i2c_dev_stats_t s_stats[PORT_I2C_STATS_MAX_DEVICES];
+static int s_stats_count;
+
+/* Start of each bus's utilization window (0 = bus not in use). */
+static int64_t s_window_start_us[PORT_I2C_PORT_COUNT];
+
+/* Owner task per bus and its run-time counter at window start. */
+static TaskHandle_t s_owner[PORT_I2C_PORT_COUNT];
+static uint64_t s_owner_cpu_base[PORT_I2C_PORT_COUNT];
+
+/*
+ * Counters are written by the owner tasks (and CRC reports from decoders)
+ * and read by any task; updates are a handful of adds, so a spinlock keeps
+ * snapshots consistent without a mutex round trip.
+ */
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/** Find a device's entry; caller holds s_stats_lock. */
+static port_i2c_dev_stats_t *find_locked(i2c_master_dev_handle_t dev) {
+	for (int i = 0; i < s_stats_count; i++) {
+		if (s_stats[i].dev == dev)
+			return &s_stats[i];
+	}
+	return NULL;
+}
+
+/** Owner CPU time in microseconds (esp_timer-based run-time stats). */
+static uint64_t owner_runtime_us(TaskHandle_t task) {
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+	return task ? (uint64_t)ulTaskGetRunTimeCounter(task) : 0;
+#else
+	(void)task;
+	return 0;
+#endif
+}
+
+static int latency_bucket(int64_t us) {
+	for (int i = 0; i < PORT_I2C_STATS_LAT_BUCKETS - 1; i++) {
+		if (us < (int64_t)s_lat_bounds_us[i])
+			return i;
+	}
+	return PORT_I2C_STATS_LAT_BUCKETS - 1;
+}
+
+esp_err_t port_i2c_stats_add_device(i2c_master_dev_handle_t dev,
+									port_i2c_port_t port, uint8_t addr) {
+	if (!dev || (int)port < 0 || port >= PORT_I2C_PORT_COUNT)
+		return ESP_ERR_INVALID_ARG;
+
+	int64_t now = esp_timer_get_time();
+	esp_err_t err = ESP_OK;
+
+	portENTER_CRITICAL(&s_stats_lock);
+	if (s_stats_count < PORT_I2C_STATS_MAX_DEVICES) {
+		port_i2c_dev_stats_t *st = &s_stats[s_stats_count++];
+		memset(st, 0, sizeof(*st));
+		st->dev = dev;
+		st->port = port;
+		st->addr = addr;
+		if (s_window_start_us[port] == 0)
+			s_window_start_us[port] = now;
+	} else {
+		err = ESP_ERR_NO_MEM;
+	}
+	portEXIT_CRITICAL(&s_stats_lock);
+
+	return err;
+}
+
+void port_i2c_stats_set_owner(port_i2c_port_t port, TaskHandle_t task) {
+	if ((int)port < 0 || port >= PORT_I2C_PORT_COUNT)
+		return;
+
+	uint64_t base = owner_runtime_us(task);
+	portENTER_CRITICAL(&s_stats_lock);
+	s_owner[port] = task;
+	s_owner_cpu_base[port] = base;
+	portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void port_i2c_stats_record(i2c_master_dev_handle_t dev,
+						   const port_i2c_stats_sample_t *sample) {
+	if (!sample)
+		return;
+
+	int bucket = latency_bucket(sample->latency_us);
+
+	portENTER_CRITICAL(&s_stats_lock);
+	port_i2c_dev_stats_t *st = find_locked(dev);
+	if (st) {
+		st->transactions++;
+		if (sample->err != ESP_OK)
+			st->errors++;
+		st->nacks += sample->nacks;
+		st->retries += sample->retries;
+
+		st->latency_hist[bucket]++;
+		if (sample->busy_us > 0)
+			st->busy_us += (uint64_t)sample->busy_us;
+	}
+	portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void port_i2c_stats_record_wait(i2c_master_dev_handle_t dev, int64_t wait_us) {
+	if (wait_us < 0)
+		return;
+	uint32_t wait = wait_us > UINT32_MAX ? UINT32_MAX : (uint32_t)wait_us;
+
+	portENTER_CRITICAL(&s_stats_lock);
+	port_i2c_dev_stats_t *st = find_locked(dev);
+	if (st) {
+		st->queue_wait_us_total += wait;
+		st->queue_wait_samples++;
+		if (wait > st->queue_wait_us_max)
+			st->queue_wait_us_max = wait;
+	}
+	portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void port_i2c_stats_report_crc_error(i2c_master_dev_handle_t dev) {
+	portENTER_CRITICAL(&s_stats_lock);
+	port_i2c_dev_stats_t *st = find_locked(dev);
+	if (st)
+		st->crc_errors++;
+	portEXIT_CRITICAL(&s_stats_lock);
+}
+
+esp_err_t port_i2c_stats_get(i2c_master_dev_handle_t dev,
+							 port_i2c_dev_stats_t *out) {
+	if (!dev || !out)
+		return ESP_ERR_INVALID_ARG;
+
+	esp_err_t err = ESP_ERR_NOT_FOUND;
+	portENTER_CRITICAL(&s_stats_lock);
+	port_i2c_dev_stats_t *st = find_locked(dev);
+	if (st) {
+		*out = *st;
+		err = ESP_OK;
+	}
+	portEXIT_CRITICAL(&s_stats_lock);
+
+	return err;
+}
+
+int port_i2c_stats_get_all(port_i2c_dev_stats_t *out, int max) {
+	if (!out || max <= 0)
+		return 0;
+
+	portENTER_CRITICAL(&s_stats_lock);
+	int n = s_stats_count < max ? s_stats_count : max;
+	memcpy(out, s_stats, (size_t)n * sizeof(out[0]));
+	portEXIT_CRITICAL(&s_stats_lock);
+
+	return n;
+}
+
+esp_err_t port_i2c_stats_get_bus(port_i2c_port_t port,
+								 port_i2c_bus_stats_t *out) {
+	if (!out || (int)port < 0 || port >= PORT_I2C_PORT_COUNT)
+		return ESP_ERR_INVALID_ARG;
+
+	int64_t now = esp_timer_get_time();
+	uint64_t busy = 0;
+	uint32_t xfers = 0;
+	int64_t start;
+	TaskHandle_t owner;
+	uint64_t cpu_base;
+
+	portENTER_CRITICAL(&s_stats_lock);
+	for (int i = 0; i < s_stats_count; i++) {
+		if (s_stats[i].port == port) {
+			busy += s_stats[i].busy_us;
+			xfers += s_stats[i].transactions;
+		}
+	}
+	start = s_window_start_us[port];
+	owner = s_owner[port];
+	cpu_base = s_owner_cpu_base[port];
+	portEXIT_CRITICAL(&s_stats_lock);
+
+	out->busy_us = busy;
+	out->window_us = (start > 0 && now > start) ? (uint64_t)(now - start) : 0;
+	out->busy_pct =
+		out->window_us ? (float)busy * 100.0f / (float)out->window_us : 0.0f;
+
+	uint64_t cpu = owner_runtime_us(owner);
+	out->owner_cpu_us = cpu > cpu_base ? cpu - cpu_base : 0;
+	out->transactions = xfers;
+	out->owner_cpu_us_per_xfer =
+		xfers ? (uint32_t)(out->owner_cpu_us / xfers) : 0;
+
+	return ESP_OK;
+}
+
+void port_i2c_stats_reset(void) {
+	int64_t now = esp_timer_get_time();
+	uint64_t cpu[PORT_I2C_PORT_COUNT];
+	for (int p = 0; p < PORT_I2C_PORT_COUNT; p++)
+		cpu[p] = owner_runtime_us(s_owner[p]);
+
+	portENTER_CRITICAL(&s_stats_lock);
+	for (int i = 0; i < s_stats_count; i++) {
+		port_i2c_dev_stats_t *st = &s_stats[i];
+		i2c_master_dev_handle_t dev = st->dev;
+		port_i2c_port_t port = st->port;
+		uint8_t addr = st->addr;
+		memset(st, 0, sizeof(*st));
+		st->dev = dev;
+		st->port = port;
+		st->addr = addr;
+	}
+	for (int p = 0; p < PORT_I2C_PORT_COUNT; p++) {
+		if (s_window_start_us[p] != 0)
+			s_window_start_us[p] = now;
+		s_owner_cpu_base[p] = cpu[p];
+	}
+	portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void port_i2c_stats_log(void) {
+	port_i2c_dev_stats_t all[PORT_I2C_STATS_MAX_DEVICES];
+	int n = port_i2c_stats_get_all(all, PORT_I2C_STATS_MAX_DEVICES);
+
+	for (int i = 0; i < n; i++) {
+		const port_i2c_dev_stats_t *st = &all[i];
+		uint32_t avg_wait =
+			st->queue_wait_samples
+				? (uint32_t)(st->queue_wait_us_total / st->queue_wait_samples)
+				: 0;
+		const uint32_t *h = st->latency_hist;
+		ESP_LOGI(TAG,
+				 "port %d 0x%02x: tx=%" PRIu32 " err=%" PRIu32
+				 " nack=%" PRIu32 " retry=%" PRIu32 " crc=%" PRIu32
+				 " wait avg/max=%" PRIu32 "/%" PRIu32 " us"
+				 " lat[<1,<2,<5,<10,<20,<50,<100,>=100 ms]=%" PRIu32
+				 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32
+				 ",%" PRIu32 ",%" PRIu32,
+				 (int)st->port, st->addr, st->transactions, st->errors,
+				 st->nacks, st->retries, st->crc_errors, avg_wait,
+				 st->queue_wait_us_max, h[0], h[1], h[2], h[3], h[4], h[5],
+				 h[6], h[7]);
+	}
+
+	for (int p = 0; p < PORT_I2C_PORT_COUNT; p++) {
+		port_i2c_bus_stats_t bus;
+		if (port_i2c_stats_get_bus((port_i2c_port_t)p, &bus) == ESP_OK &&
+			bus.window_us > 0) {
+			ESP_LOGI(TAG,
+					 "port %d: bus busy %.2f%%, owner cpu %" PRIu32
+					 " us/transaction",
+					 p, bus.busy_pct, bus.owner_cpu_us_per_xfer);
+		}
+	}
+}
+
+#if CONFIG_PORT_I2C_STATS_LOG_PERIOD_S > 0
+static void on_log_timer(void *arg) {
+	(void)arg;
+	port_i2c_stats_log();
+}
+#endif
+
+esp_err_t port_i2c_stats_start_log(void) {
+#if CONFIG_PORT_I2C_STATS_LOG_PERIOD_S > 0
+	static esp_timer_handle_t s_log_timer;
+	if (s_log_timer)
+		return ESP_OK;
+
+	const esp_timer_create_args_t args = {
+		.callback = on_log_timer,
+		.dispatch_method = ESP_TIMER_TASK,
+		.name = "i2c_stats",
+	};
+	esp_err_t err = esp_timer_create(&args, &s_log_timer);
+	if (err != ESP_OK)
+		return err;
+	return esp_timer_start_periodic(
+		s_log_timer, (uint64_t)CONFIG_PORT_I2C_STATS_LOG_PERIOD_S * 1000000);
+#else
+	return ESP_OK;
+#endif
+}
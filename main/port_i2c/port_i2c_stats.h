@@ -0,0 +1,157 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "port_i2c.h" // port_i2c_port_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of transaction latency histogram buckets. Upper bounds (ms):
+ *   <1, <2, <5, <10, <20, <50, <100, >=100
+ */
+#define PORT_I2C_STATS_LAT_BUCKETS 8
+
+/**
+ * @brief Counters for one external I2C device.
+ *
+ * Maintained by the bus owner task; CRC failures are reported back by the
+ * code that decodes the device's frames.
+ */
+typedef struct {
+	i2c_master_dev_handle_t dev; ///< Device the counters belong to
+	port_i2c_port_t port;		 ///< Grove port the device is wired to
+	uint8_t addr;				 ///< 7-bit device address
+
+	uint32_t transactions; ///< Requests completed (success or failure)
+	uint32_t errors;	   ///< Requests completed with an error
+	uint32_t nacks;		   ///< Bus operations NACKed (incl. retried ones)
+	uint32_t retries;	   ///< Extra read attempts after a failed read
+	uint32_t crc_errors;   ///< Frames rejected by the decoder
+
+	uint64_t queue_wait_us_total; ///< Submit -> dequeue, summed
+	uint32_t queue_wait_us_max;	  ///< Worst submit -> dequeue
+	uint32_t queue_wait_samples;  ///< Requests with a submit timestamp
+
+	/** Submit (or dequeue) -> reply, bucketed per PORT_I2C_STATS_LAT_BUCKETS */
+	uint32_t latency_hist[PORT_I2C_STATS_LAT_BUCKETS];
+
+	uint64_t busy_us; ///< Time the bus was held for this device
+} port_i2c_dev_stats_t;
+
+/**
+ * @brief Utilization of one external bus.
+ */
+typedef struct {
+	uint64_t busy_us;	///< Time the owner held the bus since window start
+	uint64_t window_us; ///< Length of the measurement window
+	float busy_pct;		///< busy_us / window_us * 100
+
+	/**
+	 * CPU time the bus owner task consumed in the window, from FreeRTOS
+	 * run-time stats (0 if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS is off).
+	 * Compare owner_cpu_us_per_xfer between sync and async builds.
+	 */
+	uint64_t owner_cpu_us;
+	uint32_t transactions;		   ///< Requests completed on this bus
+	uint32_t owner_cpu_us_per_xfer; ///< owner_cpu_us / transactions
+} port_i2c_bus_stats_t;
+
+/**
+ * @brief One completed request, as seen by the owner task.
+ */
+typedef struct {
+	esp_err_t err;		///< Final result
+	uint8_t retries;	///< Extra read attempts
+	uint8_t nacks;		///< NACKed operations
+	int64_t latency_us; ///< Submit (or dequeue) -> reply
+	int64_t busy_us;	///< Bus time spent on this request
+} port_i2c_stats_sample_t;
+
+/**
+ * @brief Create the counters for a device (called by the I2C service).
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the table is full.
+ */
+esp_err_t port_i2c_stats_add_device(i2c_master_dev_handle_t dev,
+									port_i2c_port_t port, uint8_t addr);
+
+/**
+ * @brief Set the owner task of a bus, for its CPU-time accounting.
+ */
+void port_i2c_stats_set_owner(port_i2c_port_t port, TaskHandle_t task);
+
+/**
+ * @brief Account one completed request (owner task only).
+ */
+void port_i2c_stats_record(i2c_master_dev_handle_t dev,
+						   const port_i2c_stats_sample_t *sample);
+
+/**
+ * @brief Account the time a request spent in the bus queue (owner task only).
+ */
+void port_i2c_stats_record_wait(i2c_master_dev_handle_t dev, int64_t wait_us);
+
+/**
+ * @brief Report a frame from `dev` that failed CRC validation.
+ *
+ * Safe to call from any task.
+ */
+void port_i2c_stats_report_crc_error(i2c_master_dev_handle_t dev);
+
+/**
+ * @brief Copy the counters of one device.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_NOT_FOUND.
+ */
+esp_err_t port_i2c_stats_get(i2c_master_dev_handle_t dev,
+							 port_i2c_dev_stats_t *out);
+
+/**
+ * @brief Copy the counters of every registered device.
+ *
+ * @param[out] out Array receiving up to `max` entries.
+ * @param[in]  max Capacity of out.
+ *
+ * @return Number of entries written.
+ */
+int port_i2c_stats_get_all(port_i2c_dev_stats_t *out, int max);
+
+/**
+ * @brief Utilization of a bus since boot or the last reset.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for a bad port.
+ */
+esp_err_t port_i2c_stats_get_bus(port_i2c_port_t port,
+								 port_i2c_bus_stats_t *out);
+
+/**
+ * @brief Zero every counter and restart the utilization windows.
+ */
+void port_i2c_stats_reset(void);
+
+/**
+ * @brief Log a one-line summary per device and per bus in use.
+ */
+void port_i2c_stats_log(void);
+
+/**
+ * @brief Call port_i2c_stats_log() every CONFIG_PORT_I2C_STATS_LOG_PERIOD_S
+ *        seconds from an esp_timer (no-op while the option is 0).
+ *
+ * Counters keep accumulating, so each dump covers the time since boot or
+ * the last port_i2c_stats_reset().
+ *
+ * @return ESP_OK, or the esp_timer error.
+ */
+esp_err_t port_i2c_stats_start_log(void);
+
+#ifdef __cplusplus
+}
+#endif
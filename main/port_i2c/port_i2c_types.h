@@ -11,7 +11,7 @@ extern "C" {
 #endif
 
 /**
- * @brief Logical sensor identifier for Port A requests.
+ * @brief Logical sensor identifier for external I2C requests.
  *
  * Used by requesters to indicate which sensor a command/transaction
  * is intended for. The owner task may use this to route behavior
@@ -22,9 +22,41 @@ extern "C" {
 typedef enum { SHT40 = 0, SGP30 } sensor_t;
 
 /**
- * @brief Request message sent to the Port A I2C owner task.
+ * @brief Operation kinds for batched (multi-step) transactions.
+ */
+typedef enum {
+	PORT_I2C_OP_WRITE = 0,	///< Transmit tx[0..tx_len)
+	PORT_I2C_OP_READ,		///< Receive rx_len bytes into rx
+	PORT_I2C_OP_WRITE_READ, ///< Transmit tx, then receive rx (repeated start)
+	PORT_I2C_OP_DELAY,		///< Hold the bus for delay_ticks
+} port_i2c_op_type_t;
+
+/**
+ * @brief One step of a batched transaction.
  *
- * A requester sends one of these to the Port A service queue.
+ * Buffers are owned by the requester and must stay valid until the reply
+ * for the enclosing request has been received.
+ */
+typedef struct {
+	port_i2c_op_type_t type;
+
+	/** Bytes to transmit (WRITE, WRITE_READ). */
+	const uint8_t *tx;
+	uint8_t tx_len;
+
+	/** Destination for received bytes (READ, WRITE_READ). */
+	uint8_t *rx;
+	uint8_t rx_len;
+
+	/** Delay to hold the bus for (DELAY). */
+	TickType_t delay_ticks;
+} port_i2c_op_t;
+
+/**
+ * @brief Request message sent to an external I2C bus owner task.
+ *
+ * A requester sends one of these to its bus's service queue
+ * (see port_i2c_service_queue_for()).
  * The owner task serializes access to the I2C bus by processing
  * requests one-at-a-time.
  */
@@ -41,27 +73,60 @@ typedef struct {
 	/** Number of command bytes to transmit (0, 1, or 2). */
 	uint8_t cmd_len;
 
-	/** Number of bytes to read back (0 if write-only). */
-	uint8_t rx_len;
+	/**
+	 * Caller-owned destination for the read phase (NULL if write-only).
+	 *
+	 * The owner reads straight into this buffer; it must stay valid until
+	 * the reply for this request has been received.
+	 */
+	uint8_t *rx;
+
+	/** Number of bytes to read into rx (0 if write-only). */
+	uint16_t rx_len;
 
 	/** Number of ticks to wait to read back */
 	TickType_t post_cmd_delay_ticks;
 
-	/** Device handle created from the Port A bus (i2c_master_dev_handle_t). */
+	/**
+	 * Absolute tick by which the request must have completed (0 = dequeue
+	 * time + the device's retry-policy budget). The owner re-polls a NACKed
+	 * read until it succeeds or this passes, and fails requests that reach
+	 * the front of the queue already late without touching the bus.
+	 */
+	TickType_t deadline;
+
+	/** Device handle from port_i2c_service_add_device(). */
 	i2c_master_dev_handle_t dev;
 
 	/** Optional reply queue for exactly one response. */
 	QueueHandle_t reply_queue;
+
+	/**
+	 * Optional batch of operations (NULL = plain cmd/rx request).
+	 *
+	 * When set, cmd/cmd_len/rx_len/post_cmd_delay_ticks are ignored and
+	 * the owner executes ops[0..n_ops) back to back on `dev` with no other
+	 * request interleaved, then sends a single response. Read data lands
+	 * in each op's rx buffer, not in the request's rx.
+	 */
+	const port_i2c_op_t *ops;
+
+	/** Number of entries in ops. */
+	uint8_t n_ops;
+
+	/**
+	 * esp_timer time at submission (set by port_i2c_service_submit(); 0 if
+	 * sent to the queue directly). Used for queue-wait statistics.
+	 */
+	int64_t submit_us;
 } port_i2c_req_t;
 
 /**
  * @brief Response message sent back to the requester.
  *
- * Returned via the request's reply_queue (if provided). The payload
- * format is application-defined; `data` commonly contains raw sensor bytes.
- *
- * Note: `data[6]` matches sensors like SHT40 (6-byte measurement), but
- * other sensors may require different sizes (caller/owner must agree).
+ * Returned via the request's reply_queue (if provided). Read data is not
+ * carried here: it was written into the request's rx buffer (or each op's
+ * rx for batches), so replies stay small regardless of frame length.
  */
 typedef struct {
 	/** Correlation ID copied from request_id. */
@@ -70,8 +135,14 @@ typedef struct {
 	/** Result of the I2C transaction (ESP_OK on success). */
 	esp_err_t err;
 
-	/** Raw response bytes (application-defined). */
-	uint8_t data[6];
+	/** Bytes written to the request's rx buffer (0 on error or batch). */
+	uint16_t rx_len;
+
+	/** Read polls repeated after a failure (0 = first poll worked). */
+	uint8_t retries;
+
+	/** Bus operations NACKed while serving the request. */
+	uint8_t nacks;
 } port_i2c_resp_t;
 
 #ifdef __cplusplus
@@ -0,0 +1,220 @@
+#include "sensor_discovery.h"
+
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "port_i2c_service.h" // port_i2c_service_set_scan()
+#include "sensor_sampler.h"	  // sensor_sampler_suspend/resume()
+
+#define TAG "discovery"
+
+// Probe results waiting for the discovery task. A result dropped on
+// overflow is simply seen again on the next scan round.
+#define DISCOVERY_EVENT_QUEUE_LEN 8
+
+/**
+ * @brief Runtime state of one driver table entry (discovery task only).
+ */
+typedef struct {
+	const sensor_driver_t *drv;
+	i2c_master_dev_handle_t dev; ///< NULL until the device first answered
+	bool bound;					 ///< drv->bind() succeeded
+	bool present;				 ///< Answering (or not yet declared lost)
+	bool reported_absent;		 ///< "not found" already logged
+	uint8_t misses;				 ///< Consecutive missed probes
+} driver_state_t;
+
+typedef struct {
+	port_i2c_port_t port;
+	uint8_t addr;
+	esp_err_t err;
+} probe_event_t;
+
+static driver_state_t s_drivers[SENSOR_DISCOVERY_MAX];
+static int s_driver_count;
+static QueueHandle_t s_event_q;
+
+/**
+ * @brief Scan callback; runs in a bus owner task, so only hand off.
+ */
+static void on_probe(port_i2c_port_t port, uint8_t addr, esp_err_t err,
+					 void *arg) {
+	(void)arg;
+	probe_event_t ev = {.port = port, .addr = addr, .err = err};
+	(void)xQueueSend(s_event_q, &ev, 0);
+}
+
+/**
+ * @brief The device answered: bind it the first time, resume it after a
+ * loss. A failed bind leaves the entry absent, so the next answer retries.
+ */
+static void handle_present(driver_state_t *st) {
+	const sensor_driver_t *drv = st->drv;
+	st->misses = 0;
+	if (st->present) {
+		return;
+	}
+
+	if (!st->dev) {
+		esp_err_t err = port_i2c_service_add_device(drv->port, drv->addr,
+													drv->scl_hz, &st->dev);
+		if (err != ESP_OK) {
+			ESP_LOGE(TAG, "%s: add device failed: %s", drv->name,
+					 esp_err_to_name(err));
+			st->dev = NULL;
+			return; // retried on the next answer
+		}
+	}
+
+	if (st->bound) {
+		st->present = true;
+		(void)sensor_sampler_resume(st->dev);
+		ESP_LOGI(TAG, "%s back at 0x%02x on port %d, sampling resumed",
+				 drv->name, drv->addr, (int)drv->port);
+		return;
+	}
+
+	esp_err_t err = drv->bind(st->dev);
+	if (err != ESP_OK) {
+		ESP_LOGE(TAG, "%s: bind failed: %s", drv->name, esp_err_to_name(err));
+		return; // retried on the next answer
+	}
+	st->bound = true;
+	st->present = true;
+	ESP_LOGI(TAG, "%s found at 0x%02x on port %d", drv->name, drv->addr,
+			 (int)drv->port);
+}
+
+/**
+ * @brief The device did not answer: declare it lost after enough misses.
+ */
+static void handle_missing(driver_state_t *st, esp_err_t err) {
+	const sensor_driver_t *drv = st->drv;
+
+	if (!st->present) {
+		if (!st->dev && !st->reported_absent) {
+			ESP_LOGW(TAG, "%s not found at 0x%02x on port %d (%s), scanning",
+					 drv->name, drv->addr, (int)drv->port,
+					 esp_err_to_name(err));
+			st->reported_absent = true;
+		}
+		return;
+	}
+
+	if (++st->misses < CONFIG_SENSOR_DISCOVERY_MISS_LIMIT) {
+		return;
+	}
+
+	st->present = false;
+	if (st->bound) {
+		(void)sensor_sampler_suspend(st->dev);
+	}
+	ESP_LOGW(TAG, "%s lost at 0x%02x on port %d, sampling suspended",
+			 drv->name, drv->addr, (int)drv->port);
+}
+
+static void discovery_task(void *arg) {
+	(void)arg;
+	probe_event_t ev;
+
+	for (;;) {
+		if (xQueueReceive(s_event_q, &ev, portMAX_DELAY) != pdTRUE) {
+			continue;
+		}
+
+		for (int i = 0; i < s_driver_count; i++) {
+			driver_state_t *st = &s_drivers[i];
+			if (st->drv->port != ev.port || st->drv->addr != ev.addr) {
+				continue;
+			}
+			if (ev.err == ESP_OK) {
+				handle_present(st);
+			} else {
+				handle_missing(st, ev.err);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Bring up a port and hand its owner the table's addresses for it.
+ */
+static void start_port_scan(port_i2c_port_t port) {
+	uint8_t addrs[PORT_I2C_SCAN_MAX_ADDRS];
+	int n = 0;
+
+	for (int i = 0; i < s_driver_count && n < PORT_I2C_SCAN_MAX_ADDRS; i++) {
+		const sensor_driver_t *drv = s_drivers[i].drv;
+		if (drv->port != port) {
+			continue;
+		}
+		bool dup = false;
+		for (int k = 0; k < n; k++) {
+			dup |= addrs[k] == drv->addr;
+		}
+		if (!dup) {
+			addrs[n++] = drv->addr;
+		}
+	}
+	if (n == 0) {
+		return;
+	}
+
+	esp_err_t err = port_i2c_service_start_bus(port);
+	if (err == ESP_OK) {
+		err = port_i2c_service_set_scan(
+			port, addrs, n,
+			pdMS_TO_TICKS(CONFIG_SENSOR_DISCOVERY_SCAN_PERIOD_MS), on_probe,
+			NULL);
+	}
+	if (err != ESP_OK) {
+		ESP_LOGE(TAG, "port %d: cannot scan: %s", (int)port,
+				 esp_err_to_name(err));
+		return;
+	}
+	ESP_LOGI(TAG, "port %d: scanning %d address(es)", (int)port, n);
+}
+
+esp_err_t sensor_discovery_start(const sensor_driver_t *drivers, int n) {
+	if (!drivers || n <= 0 || n > SENSOR_DISCOVERY_MAX) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	for (int i = 0; i < n; i++) {
+		if (!drivers[i].bind || (int)drivers[i].port < 0 ||
+			drivers[i].port >= PORT_I2C_PORT_COUNT) {
+			return ESP_ERR_INVALID_ARG;
+		}
+	}
+	if (s_event_q) {
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	s_event_q = xQueueCreate(DISCOVERY_EVENT_QUEUE_LEN, sizeof(probe_event_t));
+	if (!s_event_q) {
+		return ESP_ERR_NO_MEM;
+	}
+
+	for (int i = 0; i < n; i++) {
+		s_drivers[i] = (driver_state_t){.drv = &drivers[i]};
+	}
+	s_driver_count = n;
+
+	// Task first: scan results may arrive as soon as a port is started
+	if (xTaskCreatePinnedToCore(discovery_task, "discovery", 3072, NULL, 4,
+								NULL, 0) != pdPASS) {
+		vQueueDelete(s_event_q);
+		s_event_q = NULL;
+		return ESP_ERR_NO_MEM;
+	}
+
+	for (int p = 0; p < PORT_I2C_PORT_COUNT; p++) {
+		start_port_scan((port_i2c_port_t)p);
+	}
+	return ESP_OK;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "port_i2c.h" // port_i2c_port_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of drivers in the discovery table. */
+#define SENSOR_DISCOVERY_MAX 8
+
+/**
+ * @brief Attach a driver to a freshly discovered device.
+ *
+ * Called once, from the discovery task, the first time the device answers.
+ * Normally registers the driver's descriptor with the sensor sampler.
+ */
+typedef esp_err_t (*sensor_bind_fn)(i2c_master_dev_handle_t dev);
+
+/**
+ * @brief One entry of the driver table: where a sensor may appear and how
+ * to start it.
+ */
+typedef struct {
+	const char *name;	  ///< Short name for logs
+	port_i2c_port_t port; ///< Grove port to scan
+	uint8_t addr;		  ///< 7-bit address the sensor answers on
+	uint32_t scl_hz;	  ///< Bus clock for the device handle
+	sensor_bind_fn bind;  ///< Driver registration hook
+} sensor_driver_t;
+
+/**
+ * @brief Start scanning for the sensors in `drivers` and bind them as they
+ * appear.
+ *
+ * Every port named in the table is brought up and its owner task probes the
+ * table's addresses in bus idle gaps, each about once per
+ * CONFIG_SENSOR_DISCOVERY_SCAN_PERIOD_MS. A discovery task consumes the
+ * results:
+ *  - first answer: the device is added to the I2C service and bound
+ *  - CONFIG_SENSOR_DISCOVERY_MISS_LIMIT missed probes in a row: its sampling
+ *    is suspended (sensor_sampler_suspend())
+ *  - answer after that: sampling resumes (sensor_sampler_resume())
+ *
+ * A sensor that is absent at boot therefore costs one address phase per
+ * scan period instead of a failing sample every period.
+ *
+ * @param drivers Driver table; must stay valid for the program lifetime.
+ * @param n       Number of entries (at most SENSOR_DISCOVERY_MAX).
+ *
+ * @return
+ *      - ESP_OK on success (ports that fail to start are logged and skipped)
+ *      - ESP_ERR_INVALID_ARG for a bad table
+ *      - ESP_ERR_INVALID_STATE if already started
+ *      - ESP_ERR_NO_MEM if the task or queue cannot be created
+ */
+esp_err_t sensor_discovery_start(const sensor_driver_t *drivers, int n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,341 @@
+#include "sensor_sampler.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "port_i2c_service.h" // port_i2c_service_submit()
+#include "port_i2c_stats.h"	  // port_i2c_stats_report_crc_error()
+
+#define TAG "sampler"
+
+// How long a sample may stay in flight before a late-reply warning. The
+// sample is never abandoned: the owner may still be reading into its frame,
+// so the sensor is not resampled until the reply arrives.
+#define SAMPLER_REPLY_TIMEOUT pdMS_TO_TICKS(800)
+
+// Registered sensors (pointers to driver-owned descriptors)
+static sensor_desc_t *s_sensors[SENSOR_SAMPLER_MAX];
+static int s_sensor_count;
+static portMUX_TYPE s_sensors_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Replies for periodic samples (one slot per sensor is enough)
+static QueueHandle_t s_sample_q;
+// Replies for synchronous hook transactions
+static QueueHandle_t s_sync_q;
+
+// Request correlation ID shared by all sensors
+static uint32_t s_rid;
+
+/**
+ * @brief True once `now` has reached `deadline` (wraparound-safe).
+ */
+static inline bool deadline_reached(TickType_t now, TickType_t deadline) {
+	return (int32_t)(now - deadline) >= 0;
+}
+
+/**
+ * @brief Snapshot the registration table so the task can iterate unlocked.
+ */
+static int sensors_snapshot(sensor_desc_t **out) {
+	taskENTER_CRITICAL(&s_sensors_lock);
+	int n = s_sensor_count;
+	memcpy(out, s_sensors, (size_t)n * sizeof(out[0]));
+	taskEXIT_CRITICAL(&s_sensors_lock);
+	return n;
+}
+
+esp_err_t sensor_sampler_register(sensor_desc_t *desc) {
+	if (!desc || !desc->dev || !desc->decode ||
+		(desc->rx_len > 0 && !desc->frame)) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	memset(&desc->sched, 0, sizeof(desc->sched));
+	desc->sched.next_due = xTaskGetTickCount();
+
+	esp_err_t err = ESP_OK;
+	taskENTER_CRITICAL(&s_sensors_lock);
+	if (s_sensor_count < SENSOR_SAMPLER_MAX) {
+		s_sensors[s_sensor_count++] = desc;
+	} else {
+		err = ESP_ERR_NO_MEM;
+	}
+	taskEXIT_CRITICAL(&s_sensors_lock);
+
+	if (err == ESP_OK) {
+		ESP_LOGI(TAG, "Registered %s (period %" PRIu32 " ms)", desc->name,
+				 (uint32_t)(desc->period * portTICK_PERIOD_MS));
+	}
+	return err;
+}
+
+/**
+ * @brief Set or clear the suspend flag of every sensor on `dev`.
+ */
+static esp_err_t set_suspended(i2c_master_dev_handle_t dev, bool suspended) {
+	esp_err_t err = ESP_ERR_NOT_FOUND;
+
+	taskENTER_CRITICAL(&s_sensors_lock);
+	for (int i = 0; i < s_sensor_count; i++) {
+		sensor_desc_t *d = s_sensors[i];
+		if (d->dev != dev) {
+			continue;
+		}
+		if (d->sched.suspended && !suspended) {
+			d->sched.resumed = true;
+		}
+		d->sched.suspended = suspended;
+		err = ESP_OK;
+	}
+	taskEXIT_CRITICAL(&s_sensors_lock);
+
+	return err;
+}
+
+esp_err_t sensor_sampler_suspend(i2c_master_dev_handle_t dev) {
+	return set_suspended(dev, true);
+}
+
+esp_err_t sensor_sampler_resume(i2c_master_dev_handle_t dev) {
+	return set_suspended(dev, false);
+}
+
+/**
+ * @brief Read a sensor's suspend state, applying a pending resume.
+ *
+ * @return true if the sensor must not be sampled.
+ */
+static bool check_suspended(sensor_desc_t *d, TickType_t now) {
+	taskENTER_CRITICAL(&s_sensors_lock);
+	bool suspended = d->sched.suspended;
+	bool resumed = d->sched.resumed;
+	d->sched.resumed = false;
+	taskEXIT_CRITICAL(&s_sensors_lock);
+
+	if (resumed) {
+		// Device may have been power cycled: re-init, then sample now
+		d->sched.initialized = false;
+		d->sched.next_due = now;
+	}
+	return suspended;
+}
+
+esp_err_t sensor_sampler_xfer(const sensor_desc_t *desc, port_i2c_req_t *req,
+							  port_i2c_resp_t *out, TickType_t timeout) {
+	if (!desc || !req || !out) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	// The owner gives up on the request by the caller's limit, so its
+	// reply (ESP_ERR_TIMEOUT if late) is due shortly after
+	TickType_t limit = xTaskGetTickCount() + timeout;
+	if (limit == 0) {
+		limit = 1; // 0 means "unset"
+	}
+	if (req->deadline == 0 || deadline_reached(req->deadline, limit)) {
+		req->deadline = limit;
+	}
+	req->request_id = ++s_rid;
+	req->reply_queue = s_sync_q;
+	esp_err_t err = port_i2c_service_submit(req, timeout);
+	if (err != ESP_OK) {
+		return err;
+	}
+
+	// Wait for the reply even past the timeout: until it arrives the owner
+	// may still be reading into (or writing from) the caller's buffers.
+	for (;;) {
+		if (xQueueReceive(s_sync_q, out, timeout) != pdTRUE) {
+			ESP_LOGW(TAG, "%s: still waiting for id=%" PRIu32, desc->name,
+					 req->request_id);
+			continue;
+		}
+		if (out->request_id == req->request_id) {
+			return out->err;
+		}
+	}
+}
+
+/**
+ * @brief Submit one sample for a due sensor (runs its init hook first).
+ */
+static void issue_sample(sensor_desc_t *d, TickType_t now) {
+	// Keep the grid of sample times; skip ahead if we fell behind
+	d->sched.next_due += d->period;
+	if (deadline_reached(now, d->sched.next_due)) {
+		d->sched.next_due = now + d->period;
+	}
+
+	if (!d->sched.initialized) {
+		if (d->init) {
+			esp_err_t err = d->init(d);
+			if (err != ESP_OK) {
+				ESP_LOGW(TAG, "%s init failed: %s", d->name,
+						 esp_err_to_name(err));
+				return; // retry next period
+			}
+		}
+		d->sched.initialized = true;
+	}
+
+	port_i2c_req_t req = {
+		.request_id = ++s_rid,
+		.sensor = d->sensor,
+		.cmd = d->cmd,
+		.cmd_len = d->cmd_len,
+		.rx = d->frame,
+		.rx_len = d->rx_len,
+		.post_cmd_delay_ticks = d->conv_ticks,
+		.dev = d->dev,
+		.reply_queue = s_sample_q,
+	};
+
+	// Never block the whole schedule on one full bus queue
+	esp_err_t err = port_i2c_service_submit(&req, 0);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "%s: sample skipped: %s", d->name, esp_err_to_name(err));
+		return;
+	}
+
+	d->sched.request_id = req.request_id;
+	d->sched.sent_at = now;
+	d->sched.in_flight = true;
+	d->sched.late = false;
+}
+
+/**
+ * @brief Route a reply to the sensor that issued it and decode it.
+ */
+static void handle_reply(sensor_desc_t **sensors, int n,
+						 const port_i2c_resp_t *resp) {
+	for (int i = 0; i < n; i++) {
+		sensor_desc_t *d = sensors[i];
+		if (!d->sched.in_flight || d->sched.request_id != resp->request_id) {
+			continue;
+		}
+
+		d->sched.in_flight = false;
+		d->sched.late = false;
+		if (resp->err != ESP_OK) {
+			ESP_LOGW(TAG, "%s: I2C read failed id=%" PRIu32 ": %s", d->name,
+					 resp->request_id, esp_err_to_name(resp->err));
+			return;
+		}
+
+		TickType_t period = d->period;
+		esp_err_t err = d->decode(d, d->frame, resp->rx_len);
+		if (d->period < period) {
+			// The decoder tightened the period: don't wait out the old one
+			TickType_t due = d->sched.sent_at + d->period;
+			if (!deadline_reached(due, d->sched.next_due)) {
+				d->sched.next_due = due;
+			}
+		}
+		if (err == ESP_ERR_INVALID_CRC) {
+			port_i2c_stats_report_crc_error(d->dev);
+		}
+		if (err != ESP_OK) {
+			ESP_LOGW(TAG, "%s: bad frame id=%" PRIu32 ": %s", d->name,
+					 resp->request_id, esp_err_to_name(err));
+		}
+		return;
+	}
+	// Reply for an unknown request (e.g. sensor re-registered): ignore
+}
+
+/**
+ * @brief Ticks until the next due sample or in-flight timeout.
+ */
+static TickType_t next_wait_ticks(sensor_desc_t **sensors, int n,
+								  TickType_t now) {
+	TickType_t wait = portMAX_DELAY;
+	for (int i = 0; i < n; i++) {
+		const sensor_desc_t *d = sensors[i];
+		if (d->sched.late) {
+			continue; // already warned; only its reply can wake us
+		}
+		if (!d->sched.in_flight && d->sched.suspended) {
+			continue; // a resume is picked up within the bounded wait
+		}
+		TickType_t deadline = d->sched.in_flight
+								  ? d->sched.sent_at + SAMPLER_REPLY_TIMEOUT
+								  : d->sched.next_due;
+		if (deadline_reached(now, deadline)) {
+			return 0;
+		}
+		TickType_t left = deadline - now;
+		if (left < wait) {
+			wait = left;
+		}
+	}
+	return wait;
+}
+
+/**
+ * @brief Single task that samples every registered sensor on its schedule.
+ *
+ * Samples are submitted without waiting for each other, so sensors on the
+ * same bus overlap their conversion times in the owner task and sensors on
+ * different buses run fully in parallel. Decode hooks run here, in order of
+ * reply arrival.
+ */
+static void sampler_task(void *arg) {
+	(void)arg;
+	sensor_desc_t *sensors[SENSOR_SAMPLER_MAX];
+
+	for (;;) {
+		int n = sensors_snapshot(sensors);
+		TickType_t now = xTaskGetTickCount();
+
+		for (int i = 0; i < n; i++) {
+			sensor_desc_t *d = sensors[i];
+			if (d->sched.in_flight) {
+				if (!d->sched.late &&
+					deadline_reached(now,
+									 d->sched.sent_at + SAMPLER_REPLY_TIMEOUT)) {
+					ESP_LOGW(TAG, "%s: reply overdue for id=%" PRIu32, d->name,
+							 d->sched.request_id);
+					d->sched.late = true;
+				}
+				continue;
+			}
+			if (check_suspended(d, now)) {
+				continue;
+			}
+			if (deadline_reached(now, d->sched.next_due)) {
+				issue_sample(d, now);
+			}
+		}
+
+		// Sleep until a reply arrives or the next deadline; bounded so that
+		// sensors registered or resumed at runtime are picked up.
+		TickType_t wait = next_wait_ticks(sensors, n, xTaskGetTickCount());
+		if (wait > pdMS_TO_TICKS(1000)) {
+			wait = pdMS_TO_TICKS(1000);
+		}
+
+		port_i2c_resp_t resp;
+		if (xQueueReceive(s_sample_q, &resp, wait) == pdTRUE) {
+			do {
+				handle_reply(sensors, n, &resp);
+			} while (xQueueReceive(s_sample_q, &resp, 0) == pdTRUE);
+		}
+	}
+}
+
+void sensor_sampler_start(void) {
+	s_sample_q = xQueueCreate(SENSOR_SAMPLER_MAX, sizeof(port_i2c_resp_t));
+	s_sync_q = xQueueCreate(2, sizeof(port_i2c_resp_t));
+	if (!s_sample_q || !s_sync_q) {
+		ESP_LOGE(TAG, "Failed to create reply queues");
+		return;
+	}
+
+	xTaskCreatePinnedToCore(sampler_task, "sampler", 4096, NULL, 5, NULL, 0);
+}
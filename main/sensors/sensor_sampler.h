@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "port_i2c_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of sensors the sampler can drive. */
+#define SENSOR_SAMPLER_MAX 8
+
+typedef struct sensor_desc sensor_desc_t;
+
+/**
+ * @brief One-time init hook, run from the sampler task before the first
+ * sample. May issue synchronous transactions via sensor_sampler_xfer().
+ *
+ * @return ESP_OK when the sensor is ready; any error retries on the next
+ *         period.
+ */
+typedef esp_err_t (*sensor_init_fn)(sensor_desc_t *desc);
+
+/**
+ * @brief Decode hook, run from the sampler task for each raw frame.
+ *
+ * @param desc Descriptor the frame belongs to.
+ * @param buf  Raw bytes read from the device.
+ * @param len  Number of bytes read into buf.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_CRC (or other) on bad frames.
+ */
+typedef esp_err_t (*sensor_decode_fn)(sensor_desc_t *desc, const uint8_t *buf,
+									  size_t len);
+
+/**
+ * @brief Declarative description of a periodically sampled I2C sensor.
+ *
+ * Drivers own a static instance, fill in the public fields and hand it to
+ * sensor_sampler_register(). The sampler task then issues
+ *   cmd -> wait conv_ticks -> read rx_len bytes into frame
+ * every `period` and passes the frame to `decode`. The bus owner reads
+ * straight into `frame`, so frames of any length cost nothing extra in the
+ * request/reply queues.
+ *
+ * The measurement fields (cmd, cmd_len, conv_ticks, rx_len, period) are
+ * re-read before every sample, so hooks may adjust them at runtime. A decode
+ * hook that shortens `period` also pulls in the already scheduled next
+ * sample.
+ */
+struct sensor_desc {
+	const char *name;			 ///< Short name for logs
+	i2c_master_dev_handle_t dev; ///< Device from port_i2c_service_add_device()
+	sensor_t sensor;			 ///< Routing hint copied into requests
+
+	uint16_t cmd;		   ///< Measurement command (big-endian on the wire)
+	uint8_t cmd_len;	   ///< Command length in bytes (1 or 2)
+	TickType_t conv_ticks; ///< Conversion time between command and read
+	uint16_t rx_len;	   ///< Frame length to read
+	uint8_t *frame;		   ///< Driver-owned buffer of at least rx_len bytes
+	TickType_t period;	   ///< Sampling period
+
+	sensor_init_fn init;	 ///< Optional one-time init (may be NULL)
+	sensor_decode_fn decode; ///< Frame decoder (required)
+	void *ctx;				 ///< Driver-private state
+
+	/* Scheduling state: owned by the sampler task, do not touch. */
+	struct {
+		TickType_t next_due;
+		TickType_t sent_at;
+		uint32_t request_id;
+		bool initialized;
+		bool in_flight;
+		bool late;
+		bool suspended; ///< Set by sensor_sampler_suspend() (locked)
+		bool resumed;	///< Set by sensor_sampler_resume() (locked)
+	} sched;
+};
+
+/**
+ * @brief Add a sensor to the sampler's schedule.
+ *
+ * Can be called before or after sensor_sampler_start(). The descriptor must
+ * stay valid for the lifetime of the program.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if desc, desc->dev or desc->decode is NULL, or
+ *        rx_len is non-zero without a frame buffer
+ *      - ESP_ERR_NO_MEM if SENSOR_SAMPLER_MAX sensors are already registered
+ */
+esp_err_t sensor_sampler_register(sensor_desc_t *desc);
+
+/**
+ * @brief Stop sampling every sensor on `dev` (e.g. it was unplugged).
+ *
+ * A sample already in flight still completes. Safe to call from any task.
+ *
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if no sensor uses dev.
+ */
+esp_err_t sensor_sampler_suspend(i2c_master_dev_handle_t dev);
+
+/**
+ * @brief Resume sampling every sensor on `dev` after a suspend.
+ *
+ * The device may have been power cycled, so init hooks run again before
+ * the next sample, which is taken right away. Safe to call from any task.
+ *
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if no sensor uses dev.
+ */
+esp_err_t sensor_sampler_resume(i2c_master_dev_handle_t dev);
+
+/**
+ * @brief Start the single sampler task driving every registered sensor.
+ */
+void sensor_sampler_start(void);
+
+/**
+ * @brief Run one transaction synchronously on a sensor's bus.
+ *
+ * Only for use from sampler hooks (init/decode), i.e. from the sampler
+ * task itself. request_id and reply_queue in `req` are filled in here, and
+ * req->deadline is brought forward to now + timeout if it is later (or
+ * unset), so the owner abandons the request by then.
+ *
+ * Buffers: the owner reads from the tx buffers and writes into the rx
+ * buffers (req->rx, and each op's tx/rx for batches) until it replies.
+ * This call does not return before that reply has arrived, even after the
+ * timeout, so the buffers may live on the caller's stack.
+ *
+ * @param[in]  desc    Sensor the transaction targets (routes to its bus).
+ * @param[in]  req     Request to submit (dev should be desc->dev).
+ * @param[out] out     Response from the owner task.
+ * @param[in]  timeout Time the owner has to complete the request, and
+ *                     max wait for queue space.
+ *
+ * @return Transport error from the owner (ESP_ERR_TIMEOUT if it ran out of
+ *         time), or ESP_ERR_TIMEOUT if the queue stayed full.
+ */
+esp_err_t sensor_sampler_xfer(const sensor_desc_t *desc, port_i2c_req_t *req,
+							  port_i2c_resp_t *out, TickType_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,27 +3,77 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <time.h>
+
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
 #include "freertos/task.h"
 
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "sdkconfig.h"
 
-#include "port_i2c_service.h" // port_i2c_service_queue(), req/resp types
+#include "port_i2c_stats.h" // port_i2c_stats_report_crc_error()
 #include "port_i2c_types.h"
+#include "sensor_sampler.h" // sensor_desc_t, sensor_sampler_xfer()
+#include "sgp30.h"
 
 #include "port_i2c_readings.h" // readings_update_sgp30
-#include "sensirion_utils.h"   // sensirion_crc8()
+#include "sensirion_utils.h"   // Sensirion frame codec
 
-// Logging tag for this module/task
+// Logging tag for this module
 #define TAG "sgp30"
 
-// SGP30 I2C address is typically 0x58 (handled when creating dev handle)
-
 // SGP30 commands are 16-bit values transmitted big-endian on the I2C bus
 #define SGP30_CMD_IAQ_INIT 0x2003
 #define SGP30_CMD_MEASURE_IAQ 0x2008
+#define SGP30_CMD_GET_BASELINE 0x2015
+#define SGP30_CMD_SET_BASELINE 0x201E
+#define SGP30_CMD_SET_HUMIDITY 0x2061
+
+// Max processing time of init/baseline/humidity commands is 10 ms; one extra
+// tick guarantees it with a 10 ms tick
+#define SGP30_CMD_WAIT_TICKS (pdMS_TO_TICKS(10) + 1)
+
+// Without a restored baseline the sensor needs 12 h before its baseline is
+// worth saving (datasheet); after a restore it is valid right away
+#define SGP30_BASELINE_LEARN_US (12LL * 3600 * 1000 * 1000)
+#define SGP30_BASELINE_SAVE_US                                                 \
+	((int64_t)CONFIG_SGP30_BASELINE_SAVE_MIN * 60 * 1000 * 1000)
+
+// A stored baseline older than this is stale (datasheet: 7 days)
+#define SGP30_BASELINE_MAX_AGE_S (7 * 24 * 3600)
+
+// Wall-clock times before this mean SNTP has not synced (2024-01-01)
+#define SGP30_CLOCK_VALID_S 1704067200
+
+// Humidity compensation uses SHT40 samples up to this old (two of its
+// longest periods, so the adaptive SHT40 rate never switches it off)
+#define SGP30_HUMIDITY_MAX_AGE_MS (2 * CONFIG_SHT40_PERIOD_MAX_MS)
+
+// Resend absolute humidity when it moved by this much (1/256 g/m^3 units)
+#define SGP30_HUMIDITY_DEADBAND 8
+
+#define SGP30_NVS_NAMESPACE "sgp30"
+#define SGP30_NVS_KEY "baseline"
+
+/**
+ * @brief Baseline record kept in NVS.
+ */
+typedef struct {
+	uint16_t eco2;	  ///< eCO2 baseline word as read from the sensor
+	uint16_t tvoc;	  ///< TVOC baseline word as read from the sensor
+	int64_t saved_at; ///< Unix time of the readback (0 = clock not set)
+} sgp30_baseline_t;
+
+// Baseline bookkeeping (sampler task only)
+static int64_t s_next_save_us; ///< esp_timer time of the next readback
+
+#if CONFIG_SGP30_HUMIDITY_COMPENSATION
+// Last absolute humidity sent (8.8 fixed-point g/m^3); -1 = none yet
+static int32_t s_humidity_sent = -1;
+#endif
 
 /**
  * @brief Validate and decode the SGP30 "Measure IAQ" response frame.
@@ -32,10 +82,8 @@
  *   [0..1] eCO2 word (MSB..LSB), [2] CRC
  *   [3..4] TVOC word (MSB..LSB), [5] CRC
  *
- * This function:
- *  - Computes Sensirion CRC-8 over each 2-byte word
- *  - Compares with the corresponding CRC byte
- *  - Decodes big-endian words into host-endian uint16_t values
+ * Both words are CRC-checked and decoded in one
+ * sensirion_decode_words() call.
  *
  * @param buf       6-byte response buffer (two words + CRCs)
  * @param eco2_ppm  Output: eCO2 concentration in ppm
@@ -49,157 +97,294 @@ static esp_err_t sgp30_process_iaq_buf(const uint8_t buf[6], uint16_t *eco2_ppm,
 		return ESP_ERR_INVALID_ARG;
 	}
 
-	// Sensirion CRC is computed per-word over the 2 data bytes
-	uint8_t c0 = sensirion_crc8(&buf[0], 2);
-	uint8_t c1 = sensirion_crc8(&buf[3], 2);
+	uint16_t words[2];
+	int bad_word;
+	esp_err_t err = sensirion_decode_words(buf, 6, words, 2, &bad_word);
+	if (err != ESP_OK) {
+		ESP_LOGD(TAG, "IAQ frame rejected at word %d", bad_word);
+		return err;
+	}
+
+	*eco2_ppm = words[0];
+	*tvoc_ppb = words[1];
+	return ESP_OK;
+}
 
-	// Reject frame if either CRC byte does not match
-	if (c0 != buf[2]) {
-		return ESP_ERR_INVALID_CRC;
+/**
+ * @brief Load the stored baseline if there is a fresh one.
+ *
+ * @return true if *out holds a baseline to restore.
+ */
+static bool baseline_load(sgp30_baseline_t *out) {
+	nvs_handle_t h;
+	if (nvs_open(SGP30_NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK) {
+		return false; // nothing saved yet
 	}
-	if (c1 != buf[5]) {
-		return ESP_ERR_INVALID_CRC;
+
+	size_t len = sizeof(*out);
+	esp_err_t err = nvs_get_blob(h, SGP30_NVS_KEY, out, &len);
+	nvs_close(h);
+	if (err != ESP_OK || len != sizeof(*out)) {
+		return false;
 	}
 
-	// Words are big-endian in the response payload
-	*eco2_ppm = (uint16_t)(((uint16_t)buf[0] << 8) | buf[1]);
-	*tvoc_ppb = (uint16_t)(((uint16_t)buf[3] << 8) | buf[4]);
+	int64_t now = (int64_t)time(NULL);
+	if (out->saved_at > 0 && now > SGP30_CLOCK_VALID_S &&
+		now - out->saved_at > SGP30_BASELINE_MAX_AGE_S) {
+		ESP_LOGW(TAG, "Stored baseline is %" PRId64 " h old, not restoring",
+				 (now - out->saved_at) / 3600);
+		return false;
+	}
+	return true;
+}
 
-	return ESP_OK;
+static void baseline_store(const sgp30_baseline_t *bl) {
+	nvs_handle_t h;
+	esp_err_t err = nvs_open(SGP30_NVS_NAMESPACE, NVS_READWRITE, &h);
+	if (err == ESP_OK) {
+		err = nvs_set_blob(h, SGP30_NVS_KEY, bl, sizeof(*bl));
+		if (err == ESP_OK) {
+			err = nvs_commit(h);
+		}
+		nvs_close(h);
+	}
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "Baseline not saved: %s", esp_err_to_name(err));
+	}
 }
 
 /**
- * @brief FreeRTOS task that periodically polls the SGP30 via the Port A I2C
- * service.
+ * @brief Init hook: IAQ init, then restore the saved baseline.
+ *
+ * Runs from the sampler task before the first Measure IAQ (and again after
+ * the device was unplugged, since that resets it). Both commands go out as
+ * one batch so nothing can reach the sensor between them; the batch holds
+ * the bus only for the 10 ms processing time in between. The processing
+ * time of the last command is waited out here, in the sampler task, so
+ * the first Measure IAQ is not NACKed and the bus stays free for other
+ * devices meanwhile. With a restored baseline the readings are accurate
+ * within seconds instead of after the 12 h the sensor needs to learn one
+ * from scratch.
  *
- * High-level behavior:
- *  1) Send IAQ init (required once after boot)
- *  2) Every ~1s: send Measure IAQ command and read back 6 bytes
- *  3) Validate CRCs, decode eCO2/TVOC, and log the readings
+ * @param desc SGP30 descriptor.
+ * @return Transport result, or ESP_ERR_TIMEOUT.
+ */
+static esp_err_t sgp30_init(sensor_desc_t *desc) {
+	uint8_t init_cmd[2];
+	uint8_t set_cmd[2 + 2 * SENSIRION_WORD_SIZE];
+	port_i2c_op_t ops[3];
+	uint8_t n_ops = 0;
+
+	size_t init_len = sensirion_build_cmd(SGP30_CMD_IAQ_INIT, 2, NULL, 0,
+										  init_cmd, sizeof(init_cmd));
+	ops[n_ops++] = (port_i2c_op_t){
+		.type = PORT_I2C_OP_WRITE, .tx = init_cmd, .tx_len = init_len};
+
+	sgp30_baseline_t bl;
+	bool restore = baseline_load(&bl);
+	if (restore) {
+		ops[n_ops++] = (port_i2c_op_t){.type = PORT_I2C_OP_DELAY,
+									   .delay_ticks = SGP30_CMD_WAIT_TICKS};
+
+		// Set baseline takes TVOC first, the reverse of get baseline
+		const uint16_t args[2] = {bl.tvoc, bl.eco2};
+		size_t set_len = sensirion_build_cmd(SGP30_CMD_SET_BASELINE, 2, args, 2,
+											 set_cmd, sizeof(set_cmd));
+		ops[n_ops++] = (port_i2c_op_t){
+			.type = PORT_I2C_OP_WRITE, .tx = set_cmd, .tx_len = set_len};
+	}
+	port_i2c_req_t req = {
+		.sensor = SGP30,
+		.dev = desc->dev,
+		.ops = ops,
+		.n_ops = n_ops,
+	};
+	port_i2c_resp_t resp = {0};
+
+	esp_err_t err = sensor_sampler_xfer(desc, &req, &resp, pdMS_TO_TICKS(500));
+	if (err != ESP_OK) {
+		return err;
+	}
+	vTaskDelay(SGP30_CMD_WAIT_TICKS);
+
+	int64_t now_us = esp_timer_get_time();
+	s_next_save_us =
+		now_us + (restore ? SGP30_BASELINE_SAVE_US : SGP30_BASELINE_LEARN_US);
+#if CONFIG_SGP30_HUMIDITY_COMPENSATION
+	s_humidity_sent = -1; // power-on default is "no compensation"
+#endif
+
+	if (restore) {
+		ESP_LOGI(TAG, "IAQ init OK, baseline restored (eCO2 0x%04" PRIx16
+					  ", TVOC 0x%04" PRIx16 ")",
+				 bl.eco2, bl.tvoc);
+	} else {
+		ESP_LOGI(TAG, "IAQ init OK, no baseline stored (learning for 12 h)");
+	}
+	return ESP_OK;
+}
+
+/**
+ * @brief Read the current baseline back and store it in NVS if due.
+ */
+static void baseline_save_if_due(sensor_desc_t *desc) {
+	int64_t now_us = esp_timer_get_time();
+	if (now_us < s_next_save_us) {
+		return;
+	}
+	s_next_save_us = now_us + SGP30_BASELINE_SAVE_US;
+
+	uint8_t frame[2 * SENSIRION_WORD_SIZE];
+	port_i2c_req_t req = {
+		.sensor = SGP30,
+		.cmd = SGP30_CMD_GET_BASELINE,
+		.cmd_len = 2,
+		.rx = frame,
+		.rx_len = sizeof(frame),
+		.post_cmd_delay_ticks = SGP30_CMD_WAIT_TICKS,
+		.dev = desc->dev,
+	};
+	port_i2c_resp_t resp = {0};
+
+	esp_err_t err = sensor_sampler_xfer(desc, &req, &resp, pdMS_TO_TICKS(500));
+	uint16_t words[2];
+	if (err == ESP_OK) {
+		err = sensirion_decode_words(frame, resp.rx_len, words, 2, NULL);
+		if (err == ESP_ERR_INVALID_CRC) {
+			port_i2c_stats_report_crc_error(desc->dev);
+		}
+	}
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "Baseline readback failed: %s", esp_err_to_name(err));
+		return; // next attempt one save period later
+	}
+
+	int64_t now_s = (int64_t)time(NULL);
+	sgp30_baseline_t bl = {
+		.eco2 = words[0],
+		.tvoc = words[1],
+		.saved_at = now_s > SGP30_CLOCK_VALID_S ? now_s : 0,
+	};
+	baseline_store(&bl);
+	ESP_LOGI(TAG, "Baseline saved (eCO2 0x%04" PRIx16 ", TVOC 0x%04" PRIx16 ")",
+			 bl.eco2, bl.tvoc);
+}
+
+#if CONFIG_SGP30_HUMIDITY_COMPENSATION
+/**
+ * @brief Send the absolute humidity of the latest SHT40 sample.
  *
- * Notes:
- *  - All physical I2C operations are executed by the Port A owner task.
- *  - This task only submits requests and processes responses.
- *  - A small post-command delay is used before reading to avoid "busy" windows
- *    where the SGP30 may NACK reads.
+ * The value is 8.8 fixed-point g/m^3; 0 turns compensation off, which is
+ * what is sent once the SHT40 reading goes stale. Only sent when it moved
+ * by more than SGP30_HUMIDITY_DEADBAND, so a steady room costs no bus time.
  */
-static void sgp30_task(void *arg) {
-	// Device handle (created by port_add_device) passed in via task arg
-	i2c_master_dev_handle_t dev = (i2c_master_dev_handle_t)arg;
-
-	// Port A service request queue (shared by all Port A requesters)
-	QueueHandle_t port_q = port_i2c_service_queue();
-
-	// Per-task reply queue: owner sends exactly one response per request
-	QueueHandle_t reply_q = xQueueCreate(2, sizeof(port_i2c_resp_t));
-	if (!reply_q) {
-		ESP_LOGE(TAG, "Failed to create reply queue");
-		vTaskDelete(NULL);
-	}
-
-	// Request correlation ID (increments each request)
-	uint32_t rid = 0;
-
-	// -------------------------------------------------------------------------
-	// 1) IAQ initialization (run once after power-up)
-	// -------------------------------------------------------------------------
-	{
-		// IAQ init is a write-only command (no readback)
-		port_i2c_req_t init_req = {
-			.request_id = ++rid,
-			.sensor = SGP30,
-			.cmd = SGP30_CMD_IAQ_INIT,
-			.cmd_len = 2,
-			.rx_len = 0,
-			.post_cmd_delay_ticks = pdMS_TO_TICKS(100),
-			.dev = dev,
-			.reply_queue = reply_q,
-		};
-
-		// Submit init request to Port A owner
-		(void)xQueueSend(port_q, &init_req, portMAX_DELAY);
-
-		// Wait for completion status from owner task
-		port_i2c_resp_t init_resp = {0};
-		if (xQueueReceive(reply_q, &init_resp, pdMS_TO_TICKS(500)) == pdTRUE) {
-			if (init_resp.err != ESP_OK) {
-				ESP_LOGW(TAG, "IAQ init failed id=%" PRIu32 ": %s",
-						 init_resp.request_id, esp_err_to_name(init_resp.err));
-			} else {
-				ESP_LOGI(TAG, "IAQ init OK");
-			}
-		} else {
-			ESP_LOGW(TAG, "Timeout waiting for IAQ init response id=%" PRIu32,
-					 rid);
+static void humidity_update(sensor_desc_t *desc) {
+	readings_snapshot_t snap;
+	readings_get_snapshot(&snap);
+
+	uint16_t ah = 0;
+	uint32_t now_ms = esp_log_timestamp();
+	if (snap.sht40_valid &&
+		now_ms - snap.sht40_ts_ms <= SGP30_HUMIDITY_MAX_AGE_MS) {
+		uint32_t mg_m3 = sensirion_abs_humidity_mg_m3(
+			(int32_t)(snap.temp_c * 1000.0f),
+			(int32_t)(snap.rh_percent * 1000.0f));
+		uint32_t fixed = (mg_m3 * 256 + 500) / 1000;
+		ah = fixed > 0xFFFF ? 0xFFFF : (uint16_t)fixed;
+		if (ah == 0 && mg_m3 > 0) {
+			ah = 1; // 0 would disable compensation
 		}
+	}
 
-		// Small guard time before starting periodic measurements
-		vTaskDelay(pdMS_TO_TICKS(10));
-	}
-
-	// -------------------------------------------------------------------------
-	// 2) Periodic measurement loop
-	// -------------------------------------------------------------------------
-
-	// SGP30 IAQ measurement is typically polled at 1 Hz
-	TickType_t last = xTaskGetTickCount();
-	const TickType_t period = pdMS_TO_TICKS(1000);
-
-	for (;;) {
-		// Measure IAQ is command + 6-byte response (two words + CRCs)
-		port_i2c_req_t req = {
-			.request_id = ++rid,
-			.sensor = SGP30,
-			.cmd = SGP30_CMD_MEASURE_IAQ,
-			.cmd_len = 2,
-			.rx_len = 6,
-			// Delay before read helps avoid read attempts during internal
-			// update windows
-			.post_cmd_delay_ticks = pdMS_TO_TICKS(30),
-			.dev = dev,
-			.reply_queue = reply_q,
-		};
-
-		// Submit request to the Port A owner task
-		(void)xQueueSend(port_q, &req, portMAX_DELAY);
-
-		// Wait for response (I2C operation + optional retries in owner)
-		port_i2c_resp_t resp = {0};
-		if (xQueueReceive(reply_q, &resp, pdMS_TO_TICKS(800)) == pdTRUE) {
-			// Transport-level failure (NACK/timeout/etc.)
-			if (resp.err != ESP_OK) {
-				ESP_LOGW(TAG, "I2C read failed id=%" PRIu32 ": %s",
-						 resp.request_id, esp_err_to_name(resp.err));
-			} else {
-				// CRC validation + decode into eCO2 and TVOC units
-				uint16_t eco2 = 0, tvoc = 0;
-				esp_err_t perr = sgp30_process_iaq_buf(resp.data, &eco2, &tvoc);
-				if (perr != ESP_OK) {
-					ESP_LOGW(TAG, "Bad CRC id=%" PRIu32, resp.request_id);
-				} else {
-					ESP_LOGI(TAG,
-							 "eCO2: %" PRIu16 " ppm, TVOC: %" PRIu16 " ppb",
-							 eco2, tvoc);
-					uint32_t now_ms = esp_log_timestamp();
-					readings_update_sgp30(eco2, tvoc, now_ms);
-				}
-			}
-		} else {
-			// No response received within timeout window
-			ESP_LOGW(TAG, "Timeout waiting for response id=%" PRIu32, rid);
+	if (s_humidity_sent >= 0) {
+		int32_t diff = (int32_t)ah - s_humidity_sent;
+		bool toggled = (ah == 0) != (s_humidity_sent == 0);
+		if (!toggled && diff < SGP30_HUMIDITY_DEADBAND &&
+			diff > -SGP30_HUMIDITY_DEADBAND) {
+			return;
 		}
+	}
+
+	uint8_t cmd[2 + SENSIRION_WORD_SIZE];
+	size_t cmd_len = sensirion_build_cmd(SGP30_CMD_SET_HUMIDITY, 2, &ah, 1,
+										 cmd, sizeof(cmd));
+	const port_i2c_op_t op = {
+		.type = PORT_I2C_OP_WRITE, .tx = cmd, .tx_len = cmd_len};
+	port_i2c_req_t req = {
+		.sensor = SGP30,
+		.dev = desc->dev,
+		.ops = &op,
+		.n_ops = 1,
+	};
+	port_i2c_resp_t resp = {0};
 
-		// Sleep until next period boundary (prevents drift)
-		vTaskDelayUntil(&last, period);
+	// The next Measure IAQ is a period away, well past the 10 ms the
+	// sensor needs to apply the value
+	esp_err_t err = sensor_sampler_xfer(desc, &req, &resp, pdMS_TO_TICKS(500));
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "Set humidity failed: %s", esp_err_to_name(err));
+		return;
 	}
+	s_humidity_sent = ah;
+	ESP_LOGD(TAG, "Absolute humidity %" PRIu32 " mg/m3 sent",
+			 (uint32_t)ah * 1000 / 256);
 }
+#endif
 
 /**
- * @brief Create and start the SGP30 task.
+ * @brief Decode hook: validate a Measure IAQ frame and publish it.
  *
- * @param dev I2C device handle for the SGP30.
+ * Afterwards, and only between two measurements, it saves the baseline when
+ * due and refreshes the humidity compensation.
+ *
+ * @param desc SGP30 descriptor.
+ * @param buf  Response buffer (two words + CRCs).
+ * @param len  Number of bytes in buf (must be 6).
+ * @return ESP_OK on success, ESP_ERR_INVALID_CRC on CRC failure.
  */
-void sgp30_task_start(i2c_master_dev_handle_t dev) {
-	// Pin task to core 1; adjust stack/priority as needed
-	xTaskCreatePinnedToCore(sgp30_task, "sgp30", 4096, (void *)dev, 5, NULL, 0);
+static esp_err_t sgp30_decode(sensor_desc_t *desc, const uint8_t *buf,
+							  size_t len) {
+	if (len < 6) {
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	uint16_t eco2 = 0, tvoc = 0;
+	esp_err_t err = sgp30_process_iaq_buf(buf, &eco2, &tvoc);
+	if (err != ESP_OK) {
+		return err;
+	}
+
+	ESP_LOGI(TAG, "eCO2: %" PRIu16 " ppm, TVOC: %" PRIu16 " ppb", eco2, tvoc);
+	uint32_t now_ms = esp_log_timestamp();
+	readings_update_sgp30(eco2, tvoc, now_ms);
+
+	baseline_save_if_due(desc);
+#if CONFIG_SGP30_HUMIDITY_COMPENSATION
+	humidity_update(desc);
+#endif
+	return ESP_OK;
+}
+
+// Measurement frame (two words + CRCs), filled by the bus owner
+static uint8_t s_sgp30_frame[6];
+
+// Sampler descriptor: Measure IAQ -> wait 30 ms -> read 6 bytes, at 1 Hz.
+// The 30 ms wait (max 12 ms per datasheet) avoids NACKs during the sensor's
+// internal update window.
+static sensor_desc_t s_sgp30 = {
+	.name = "sgp30",
+	.sensor = SGP30,
+	.cmd = SGP30_CMD_MEASURE_IAQ,
+	.cmd_len = 2,
+	.conv_ticks = pdMS_TO_TICKS(30),
+	.rx_len = sizeof(s_sgp30_frame),
+	.frame = s_sgp30_frame,
+	.period = pdMS_TO_TICKS(1000),
+	.init = sgp30_init,
+	.decode = sgp30_decode,
+};
+
+esp_err_t sgp30_register(i2c_master_dev_handle_t dev) {
+	s_sgp30.dev = dev;
+	return sensor_sampler_register(&s_sgp30);
 }
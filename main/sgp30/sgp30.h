@@ -1,11 +1,35 @@
 #pragma once
 #include "driver/i2c_master.h"
+#include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void sgp30_task_start(i2c_master_dev_handle_t dev);
+/** Fixed 7-bit I2C address of the SGP30. */
+#define SGP30_I2C_ADDR 0x58
+
+/** Bus clock used for the SGP30. */
+#define SGP30_I2C_SCL_HZ 100000
+
+/**
+ * @brief Register the SGP30 with the sensor sampler.
+ *
+ * The sampler sends IAQ init before the first sample, then polls Measure
+ * IAQ at 1 Hz and publishes eCO2/TVOC to the readings store.
+ *
+ * The IAQ baseline is restored from NVS right after IAQ init and read back
+ * into NVS every CONFIG_SGP30_BASELINE_SAVE_MIN minutes. With
+ * CONFIG_SGP30_HUMIDITY_COMPENSATION, the absolute humidity of the latest
+ * SHT40 sample is sent to the sensor between measurements. Requires NVS to
+ * be initialised.
+ *
+ * @param dev I2C device handle for the SGP30 (registered via
+ *            port_i2c_service_add_device()).
+ *
+ * @return Result of sensor_sampler_register().
+ */
+esp_err_t sgp30_register(i2c_master_dev_handle_t dev);
 
 #ifdef __cplusplus
 }
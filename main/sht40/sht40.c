@@ -4,26 +4,143 @@
 #include <string.h>
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
-#include "freertos/task.h"
 
 #include "esp_err.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
 
-#include "port_i2c_service.h" // port_i2c_service_queue(), req/resp types
-#include "port_i2c_types.h"
+#include "sensor_sampler.h" // sensor_desc_t, sensor_sampler_register()
+#include "sht40.h"
 
 #include "port_i2c_readings.h" // readings_update_sht40
-#include "sensirion_utils.h"   // sensirion_crc8()
+#include "sensirion_utils.h"   // sensirion_decode_words()
 
-// SHT40 "measure high precision, no heater" command (8-bit)
-#define SHT40_CMD_MEAS_HIGH_PREC_NO_HEAT 0xFD
-
-// Logging tag for this module/task
+// Logging tag for this module
 #define TAG "sht40"
 
+// Margin on top of the datasheet conversion time (high precision 8.3 ms);
+// a read that still NACKs is polled again by the bus owner
+#define SHT40_CONV_MARGIN_TICKS 1
+
+/**
+ * @brief One "measure, no heater" repeatability setting.
+ */
+typedef struct {
+	uint8_t cmd;	  ///< 8-bit measurement command
+	uint8_t conv_ms;  ///< Max conversion time (datasheet, rounded up)
+	const char *name; ///< For logs
+} sht40_mode_t;
+
+static const sht40_mode_t s_modes[] = {
+	{0xFD, 9, "high"},	 // 0.04 degC / 0.08 %RH repeatability
+	{0xF6, 5, "medium"}, // 0.07 degC / 0.15 %RH
+	{0xE0, 2, "low"},	 // 0.10 degC / 0.25 %RH
+};
+#define SHT40_MODE_COUNT (int)(sizeof(s_modes) / sizeof(s_modes[0]))
+
+/**
+ * @brief Apply a controller level to the descriptor's measurement fields.
+ */
+static void apply_level(sensor_desc_t *desc, uint8_t level) {
+	const sht40_mode_t *mode =
+		&s_modes[level < SHT40_MODE_COUNT ? level : SHT40_MODE_COUNT - 1];
+
+	uint32_t period_ms = CONFIG_SHT40_PERIOD_MIN_MS;
+	for (uint8_t i = 0; i < level && period_ms < CONFIG_SHT40_PERIOD_MAX_MS;
+		 i++) {
+		period_ms *= 2;
+	}
+	if (period_ms > CONFIG_SHT40_PERIOD_MAX_MS) {
+		period_ms = CONFIG_SHT40_PERIOD_MAX_MS;
+	}
+
+	desc->cmd = mode->cmd;
+	desc->conv_ticks = pdMS_TO_TICKS(mode->conv_ms) + SHT40_CONV_MARGIN_TICKS;
+	desc->period = pdMS_TO_TICKS(period_ms);
+	ESP_LOGI(TAG, "Level %u: %s repeatability, every %" PRIu32 " ms",
+			 (unsigned)level, mode->name, period_ms);
+}
+
+#if CONFIG_SHT40_ADAPTIVE
+/**
+ * @brief Adaptive sampling state (sampler task only).
+ *
+ * Level 0 is high repeatability at SHT40_PERIOD_MIN_MS. Each level down
+ * after SHT40_ADAPT_STABLE_SAMPLES stable samples doubles the period (up to
+ * SHT40_PERIOD_MAX_MS) and lowers repeatability one step; any sample that
+ * moved by more than the fast-change thresholds jumps back to level 0.
+ */
+typedef struct {
+	bool have_last;
+	int32_t last_temp_mc;
+	int32_t last_rh_mpct;
+	uint8_t stable; ///< Consecutive stable samples at this level
+	uint8_t level;	///< 0 = tightest
+} sht40_adapt_t;
+
+static sht40_adapt_t s_adapt;
+
+static int32_t abs_i32(int32_t v) { return v < 0 ? -v : v; }
+
+/**
+ * @brief Highest useful level: low repeatability and the longest period.
+ */
+static uint8_t max_level(void) {
+	uint8_t level = 0;
+	uint32_t period_ms = CONFIG_SHT40_PERIOD_MIN_MS;
+	while (period_ms < CONFIG_SHT40_PERIOD_MAX_MS ||
+		   level < SHT40_MODE_COUNT - 1) {
+		period_ms *= 2;
+		level++;
+	}
+	return level;
+}
+
+/**
+ * @brief Feed one sample to the controller and retune the next ones.
+ */
+static void adapt(sensor_desc_t *desc, int32_t temp_mc, int32_t rh_mpct) {
+	sht40_adapt_t *a = &s_adapt;
+	if (!a->have_last) {
+		a->have_last = true;
+		a->last_temp_mc = temp_mc;
+		a->last_rh_mpct = rh_mpct;
+		return;
+	}
+
+	int32_t dt = abs_i32(temp_mc - a->last_temp_mc);
+	int32_t drh = abs_i32(rh_mpct - a->last_rh_mpct);
+	a->last_temp_mc = temp_mc;
+	a->last_rh_mpct = rh_mpct;
+
+	if (dt > CONFIG_SHT40_ADAPT_FAST_TEMP_MC ||
+		drh > CONFIG_SHT40_ADAPT_FAST_RH_MPCT) {
+		a->stable = 0;
+		if (a->level != 0) {
+			a->level = 0;
+			apply_level(desc, 0);
+		}
+		return;
+	}
+
+	if (dt > CONFIG_SHT40_ADAPT_STABLE_TEMP_MC ||
+		drh > CONFIG_SHT40_ADAPT_STABLE_RH_MPCT) {
+		a->stable = 0;
+		return;
+	}
+
+	if (++a->stable < CONFIG_SHT40_ADAPT_STABLE_SAMPLES ||
+		a->level >= max_level()) {
+		return;
+	}
+	a->stable = 0;
+	a->level++;
+	apply_level(desc, a->level);
+}
+#endif // CONFIG_SHT40_ADAPTIVE
+
 /**
- * @brief Validate and decode a 6-byte SHT40 measurement frame.
+ * @brief Decode hook: validate and decode a 6-byte SHT40 measurement frame.
  *
  * SHT40 returns two 16-bit words, each followed by a CRC byte:
  *   [0..1] Temperature raw (MSB..LSB), [2] CRC
@@ -32,25 +149,27 @@
  * This function:
  *  - Verifies both CRC bytes using Sensirion CRC-8
  *  - Converts the raw words into temperature (°C) and relative humidity (%RH)
- *  - Logs the decoded values
+ *  - Logs the decoded values and publishes them to the readings store
+ *  - Feeds the adaptive controller, which may retune the next samples
  *
- * @param buf 6-byte measurement buffer from the sensor.
- * @return ESP_OK on success, ESP_ERR_INVALID_CRC if CRC fails.
+ * @param desc SHT40 descriptor.
+ * @param buf  Measurement buffer from the sensor.
+ * @param len  Number of bytes in buf (must be 6).
+ * @return ESP_OK on success, ESP_ERR_INVALID_CRC if CRC fails,
+ *         ESP_ERR_INVALID_SIZE if the frame is short.
  */
-static esp_err_t process_buf(const uint8_t buf[6]) {
-	// CRC is computed over each 2-byte word independently
-	uint8_t c0 = sensirion_crc8(&buf[0], 2);
-	uint8_t c1 = sensirion_crc8(&buf[3], 2);
-
-	// Reject data if either CRC byte does not match
-	if (c0 != buf[2])
-		return ESP_ERR_INVALID_CRC;
-	if (c1 != buf[5])
-		return ESP_ERR_INVALID_CRC;
-
-	// Raw values are big-endian words (MSB first)
-	uint16_t raw_t = (uint16_t)(((uint16_t)buf[0] << 8) | buf[1]);
-	uint16_t raw_rh = (uint16_t)(((uint16_t)buf[3] << 8) | buf[4]);
+static esp_err_t sht40_decode(sensor_desc_t *desc, const uint8_t *buf,
+							  size_t len) {
+	// Reject the frame if either word's CRC does not match
+	uint16_t words[2];
+	int bad_word;
+	esp_err_t err = sensirion_decode_words(buf, len, words, 2, &bad_word);
+	if (err != ESP_OK) {
+		ESP_LOGD(TAG, "Frame rejected at word %d", bad_word);
+		return err;
+	}
+	uint16_t raw_t = words[0];
+	uint16_t raw_rh = words[1];
 
 	// Convert according to SHT4x datasheet formulas
 	float temperature_c = -45.0f + 175.0f * ((float)raw_t / 65535.0f);
@@ -68,92 +187,29 @@ static esp_err_t process_buf(const uint8_t buf[6]) {
 	uint32_t now_ms = esp_log_timestamp();
 	readings_update_sht40(temperature_c, humidity_rh, now_ms);
 
+#if CONFIG_SHT40_ADAPTIVE
+	adapt(desc, (int32_t)(temperature_c * 1000.0f),
+		  (int32_t)(humidity_rh * 1000.0f));
+#endif
 	return ESP_OK;
 }
 
-/**
- * @brief FreeRTOS task that periodically reads SHT40 via the Port A I2C
- * service.
- *
- * The task:
- *  - Creates a private reply queue for responses from the owner task
- *  - Periodically sends an I2C request (command + delay + 6-byte read)
- *  - Validates/decodes the returned bytes and logs the measurement
- *
- * Notes:
- *  - All actual I2C transactions are executed by the Port A owner task.
- *  - This task only submits requests and processes replies.
- */
-static void sht40_task(void *arg) {
-	// Device handle (created by port_add_device) passed in via task arg
-	i2c_master_dev_handle_t dev = (i2c_master_dev_handle_t)arg;
-
-	// Port A service request queue (shared by all Port A requesters)
-	QueueHandle_t port_q = port_i2c_service_queue();
-
-	// Per-task reply queue: owner sends exactly one response per request
-	QueueHandle_t reply_q = xQueueCreate(2, sizeof(port_i2c_resp_t));
-	if (!reply_q) {
-		ESP_LOGE(TAG, "Failed to create reply queue");
-		vTaskDelete(NULL);
-	}
-
-	// Periodic scheduling state
-	TickType_t last = xTaskGetTickCount();
-	const TickType_t period = pdMS_TO_TICKS(2 * 1000); // 2 seconds
-
-	// Request correlation ID (increments each request)
-	uint32_t rid = 0;
-
-	for (;;) {
-		// Build a Port A transaction request:
-		//  - Send 1-byte command (0xFD)
-		//  - Wait 25ms for conversion
-		//  - Read 6 bytes (T word+CRC, RH word+CRC)
-		port_i2c_req_t req = {
-			.request_id = ++rid,
-			.sensor = SHT40,
-			.cmd = SHT40_CMD_MEAS_HIGH_PREC_NO_HEAT,
-			.cmd_len = 1,
-			.rx_len = 6,
-			.post_cmd_delay_ticks = pdMS_TO_TICKS(25),
-			.dev = dev,
-			.reply_queue = reply_q,
-		};
-
-		// Submit request to the Port A owner task (blocks until queued)
-		(void)xQueueSend(port_q, &req, portMAX_DELAY);
-
-		// Wait for response from the owner task
-		port_i2c_resp_t resp = {0};
-		if (xQueueReceive(reply_q, &resp, pdMS_TO_TICKS(500)) == pdTRUE) {
-			// Transport-level failure (NACK/timeout/etc.)
-			if (resp.err != ESP_OK) {
-				ESP_LOGW(TAG, "I2C read failed id=%" PRIu32 ": %s",
-						 resp.request_id, esp_err_to_name(resp.err));
-			} else {
-				// CRC/format validation + unit conversion
-				esp_err_t err = process_buf(resp.data);
-				if (err != ESP_OK) {
-					ESP_LOGW(TAG, "Bad CRC id=%" PRIu32, resp.request_id);
-				}
-			}
-		} else {
-			// No response received within timeout window
-			ESP_LOGW(TAG, "Timeout waiting for response id=%" PRIu32, rid);
-		}
-
-		// Sleep until next period boundary (prevents drift)
-		vTaskDelayUntil(&last, period);
-	}
-}
-
-/**
- * @brief Create and start the SHT40 task.
- *
- * @param dev I2C device handle for the SHT40.
- */
-void sht40_task_start(i2c_master_dev_handle_t dev) {
-	// Pin task to core 1; adjust stack/priority as needed
-	xTaskCreatePinnedToCore(sht40_task, "sht40", 4096, (void *)dev, 5, NULL, 0);
+// Measurement frame (two words + CRCs), filled by the bus owner
+static uint8_t s_sht40_frame[6];
+
+// Sampler descriptor: measure -> wait -> read 6 bytes; command, wait and
+// period are set from the controller level at registration
+static sensor_desc_t s_sht40 = {
+	.name = "sht40",
+	.sensor = SHT40,
+	.cmd_len = 1,
+	.rx_len = sizeof(s_sht40_frame),
+	.frame = s_sht40_frame,
+	.decode = sht40_decode,
+};
+
+esp_err_t sht40_register(i2c_master_dev_handle_t dev) {
+	s_sht40.dev = dev;
+	apply_level(&s_sht40, 0);
+	return sensor_sampler_register(&s_sht40);
 }
@@ -1,21 +1,38 @@
 #pragma once
 
 #include "driver/i2c_master.h"
+#include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Fixed 7-bit I2C address of the SHT40. */
+#define SHT40_I2C_ADDR 0x44
+
+/** Bus clock used for the SHT40. */
+#define SHT40_I2C_SCL_HZ 400000
+
 /**
- * @brief Start the SHT40 polling task.
+ * @brief Register the SHT40 with the sensor sampler.
+ *
+ * The sampler requests a high-precision measurement every
+ * CONFIG_SHT40_PERIOD_MIN_MS over the provided external I2C device handle,
+ * then logs temperature and relative humidity and publishes them to the
+ * readings store.
+ *
+ * With CONFIG_SHT40_ADAPTIVE, readings that stay within the stable
+ * thresholds step the sensor down to medium and low repeatability and
+ * double the period up to CONFIG_SHT40_PERIOD_MAX_MS; a reading that moved
+ * past the fast-change thresholds restores high repeatability at the
+ * minimum period.
  *
- * The task periodically requests a high-precision measurement from the SHT40
- * over the provided Port A I2C device handle, then logs temperature and
- * relative humidity.
+ * @param dev I2C device handle for the SHT40 (registered via
+ *            port_i2c_service_add_device()).
  *
- * @param dev I2C device handle for the SHT40 (already added to the Port A bus).
+ * @return Result of sensor_sampler_register().
  */
-void sht40_task_start(i2c_master_dev_handle_t dev);
+esp_err_t sht40_register(i2c_master_dev_handle_t dev);
 
 #ifdef __cplusplus
 }
@@ -4,9 +4,11 @@
 #include "cJSON.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "sdkconfig.h"
+#include "seqlock.h"
 
+#include "data_bus.h"
 #include "http_service.h"
 #include "stocks_task.h"
 
@@ -25,22 +27,18 @@ static const char *s_configured_symbols[STOCKS_MAX_SYMBOLS] = {
 /**
  * @brief Shared stocks snapshot consumed by the UI.
  *
- * The stocks task updates this after each full polling cycle.
- * The UI reads via stocks_get_snapshot() (mutex-protected copy).
+ * The stocks task updates each quote as its response arrives.
+ * The UI reads via stocks_get_snapshot() (seqlock-protected copy).
  */
 static stocks_snapshot_t s_stocks;
-static SemaphoreHandle_t s_stocks_mu;
+static seqlock_t s_stocks_sl = SEQLOCK_INIT;
 
 bool stocks_get_snapshot(stocks_snapshot_t *out) {
-	if (!out || !s_stocks_mu) {
+	if (!out) {
 		return false;
 	}
 
-	if (xSemaphoreTake(s_stocks_mu, pdMS_TO_TICKS(20)) != pdTRUE) {
-		return false;
-	}
-	*out = s_stocks;
-	xSemaphoreGive(s_stocks_mu);
+	out->generation = seqlock_read(&s_stocks_sl, out, &s_stocks, sizeof(*out));
 
 	/* Report valid if at least one quote has been fetched. */
 	for (int i = 0; i < out->count; i++) {
@@ -135,15 +133,15 @@ static void stocks_task(void *arg) {
 	}
 
 	/* Initialise the snapshot with the known symbol list. */
-	if (xSemaphoreTake(s_stocks_mu, portMAX_DELAY) == pdTRUE) {
-		s_stocks.count = count;
-		for (int i = 0; i < count; i++) {
-			snprintf(s_stocks.quotes[i].symbol,
-					 sizeof(s_stocks.quotes[i].symbol), "%s", symbols[i]);
-			s_stocks.quotes[i].valid = false;
-		}
-		xSemaphoreGive(s_stocks_mu);
+	stock_quote_t init[STOCKS_MAX_SYMBOLS] = {0};
+	for (int i = 0; i < count; i++) {
+		snprintf(init[i].symbol, sizeof(init[i].symbol), "%s", symbols[i]);
 	}
+	seqlock_write_begin(&s_stocks_sl);
+	s_stocks.count = count;
+	memcpy(s_stocks.quotes, init, sizeof(init));
+	seqlock_write_end(&s_stocks_sl);
+	data_bus_publish(DATA_TOPIC_STOCKS);
 
 	QueueHandle_t http_q = http_service_queue();
 	/* Size the reply queue to hold all responses simultaneously. */
@@ -206,10 +204,10 @@ static void stocks_task(void *arg) {
 
 			stock_quote_t q = {0};
 			if (parse_finnhub_quote(rx[idx], symbols[idx], &q)) {
-				if (xSemaphoreTake(s_stocks_mu, pdMS_TO_TICKS(50)) == pdTRUE) {
-					s_stocks.quotes[idx] = q;
-					xSemaphoreGive(s_stocks_mu);
-				}
+				seqlock_write_begin(&s_stocks_sl);
+				s_stocks.quotes[idx] = q;
+				seqlock_write_end(&s_stocks_sl);
+				data_bus_publish(DATA_TOPIC_STOCKS);
 				ESP_LOGI(TAG, "%s $%.2f d=%.2f dp=%.2f%%", q.symbol, q.price,
 						 q.change, q.change_pct);
 			} else {
@@ -225,11 +223,9 @@ static void stocks_task(void *arg) {
  * @brief Start the stocks polling task and initialise shared state.
  */
 void stocks_task_start(void) {
-	if (!s_stocks_mu) {
-		s_stocks_mu = xSemaphoreCreateMutex();
-	}
-
+	seqlock_write_begin(&s_stocks_sl);
 	memset(&s_stocks, 0, sizeof(s_stocks));
+	seqlock_write_end(&s_stocks_sl);
 
 	xTaskCreatePinnedToCore(stocks_task, "stocks", 4096, NULL, 5, NULL, 0);
 }
@@ -31,11 +31,13 @@ typedef struct {
  * @brief Snapshot of all configured stock quotes.
  *
  * count reflects the number of non-empty symbols from Kconfig.
- * Entries beyond count are zeroed and not displayed.
+ * Entries beyond count are zeroed and not displayed. generation counts the
+ * updates published before the copy was taken.
  */
 typedef struct {
 	stock_quote_t quotes[STOCKS_MAX_SYMBOLS];
 	int count;
+	uint32_t generation; /* set by stocks_get_snapshot() */
 } stocks_snapshot_t;
 
 /**
@@ -49,6 +51,9 @@ void stocks_task_start(void);
 /**
  * @brief Copy out the latest stocks snapshot for the UI.
  *
+ * Never blocks; *out is always filled in with a coherent copy, even when
+ * returning false.
+ *
  * @param[out] out Destination struct to receive the snapshot.
  * @return true if at least one quote is valid, false otherwise.
  */
@@ -13,19 +13,103 @@
  * Temperature unit (°C / °F) is owned here because both the stats and weather
  * screens display temperature and must agree on the active unit. Screens read
  * the current unit via ui_get_temp_unit() and toggle it via ui_set_temp_unit().
- * The UI update cycle picks up the change on the next 150 ms tick.
+ * Setting it publishes DATA_TOPIC_VIEW, which wakes ui_task to redraw.
  */
 
 #include "ui.h"
 #include "bsp/m5stack_core_s3.h"
+#include "data_bus.h"
+#include "esp_log.h"
 #include "ui_screens.h"
 
+#define TAG "ui"
+
 /* Shared temperature display unit. Default to Celsius on boot. */
 static ui_temp_unit_t s_temp_unit = UI_TEMP_C;
 
 ui_temp_unit_t ui_get_temp_unit(void) { return s_temp_unit; }
 
-void ui_set_temp_unit(ui_temp_unit_t unit) { s_temp_unit = unit; }
+void ui_set_temp_unit(ui_temp_unit_t unit) {
+	s_temp_unit = unit;
+	data_bus_publish(DATA_TOPIC_VIEW);
+}
+
+/*
+ * Redraw accounting. The monitor callback runs in the LVGL task after each
+ * refresh that rendered something; readers on other tasks only load the
+ * 32-bit results.
+ */
+static struct {
+	void (*prev_cb)(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px);
+	uint32_t window_start; /* lv_tick_get() at the window's start */
+	uint32_t px_acc;
+	uint32_t refr_acc;
+	volatile uint32_t px_per_s;
+	volatile uint32_t refr_per_s;
+} s_redraw;
+
+static void on_disp_monitor(lv_disp_drv_t *drv, uint32_t time_ms,
+							uint32_t px) {
+	if (s_redraw.prev_cb)
+		s_redraw.prev_cb(drv, time_ms, px);
+
+	s_redraw.px_acc += px;
+	s_redraw.refr_acc++;
+
+	/* After idle periods the window is longer; averaging over its real
+	 * length keeps the rate honest */
+	uint32_t elapsed = lv_tick_elaps(s_redraw.window_start);
+	if (elapsed < 1000)
+		return;
+	s_redraw.px_per_s = (uint32_t)((uint64_t)s_redraw.px_acc * 1000 / elapsed);
+	s_redraw.refr_per_s = s_redraw.refr_acc * 1000 / elapsed;
+	s_redraw.px_acc = 0;
+	s_redraw.refr_acc = 0;
+	s_redraw.window_start = lv_tick_get();
+	ESP_LOGD(TAG, "redraw: %u px/s in %u refreshes/s",
+			 (unsigned)s_redraw.px_per_s, (unsigned)s_redraw.refr_per_s);
+}
+
+static lv_obj_t *s_tiles[UI_TILE_COUNT];
+static volatile uint32_t s_visible = 1u << UI_TILE_CLOCK;
+
+/**
+ * @brief Track which tiles can be on screen.
+ *
+ * Registered on the tileview for scroll begin/end and value changed. While
+ * a swipe is moving, the neighbours of the active tile may be partly
+ * visible; once it settles only the (possibly new) active tile is.
+ */
+static void on_tileview_event(lv_event_t *e) {
+	lv_obj_t *act = lv_tileview_get_tile_act(lv_event_get_target(e));
+	int idx = 0;
+	for (int i = 0; i < UI_TILE_COUNT; i++) {
+		if (s_tiles[i] == act)
+			idx = i;
+	}
+
+	uint32_t mask = 1u << idx;
+	if (lv_event_get_code(e) == LV_EVENT_SCROLL_BEGIN) {
+		if (idx > 0)
+			mask |= 1u << (idx - 1);
+		if (idx < UI_TILE_COUNT - 1)
+			mask |= 1u << (idx + 1);
+	}
+
+	if (mask != s_visible) {
+		s_visible = mask;
+		data_bus_publish(DATA_TOPIC_VIEW);
+	}
+}
+
+uint32_t ui_visible_tiles(void) { return s_visible; }
+
+void ui_get_redraw_stats(ui_redraw_stats_t *out) {
+	if (!out)
+		return;
+	out->px_per_s = s_redraw.px_per_s;
+	out->refreshes_per_s = s_redraw.refr_per_s;
+}
 
 esp_err_t ui_init(lv_disp_t *disp) {
 	if (!disp)
@@ -33,6 +117,11 @@ esp_err_t ui_init(lv_disp_t *disp) {
 
 	bsp_display_lock(0);
 
+	/* Chain onto whatever monitor callback the display port installed */
+	s_redraw.prev_cb = disp->driver->monitor_cb;
+	s_redraw.window_start = lv_tick_get();
+	disp->driver->monitor_cb = on_disp_monitor;
+
 	/* Full-screen tileview: horizontal swipe navigation between tiles.
 	 * Tiles are arranged in a single row (col 0, 1, 2).
 	 * LV_DIR_* flags control which edges respond to swipe gestures —
@@ -57,6 +146,14 @@ esp_err_t ui_init(lv_disp_t *disp) {
 	ui_weather_build(tile_weather);
 	ui_stocks_build(tile_stocks);
 
+	s_tiles[UI_TILE_CLOCK] = tile_clock;
+	s_tiles[UI_TILE_STATS] = tile_stats;
+	s_tiles[UI_TILE_WEATHER] = tile_weather;
+	s_tiles[UI_TILE_STOCKS] = tile_stocks;
+	lv_obj_add_event_cb(tv, on_tileview_event, LV_EVENT_SCROLL_BEGIN, NULL);
+	lv_obj_add_event_cb(tv, on_tileview_event, LV_EVENT_SCROLL_END, NULL);
+	lv_obj_add_event_cb(tv, on_tileview_event, LV_EVENT_VALUE_CHANGED, NULL);
+
 	bsp_display_unlock();
 
 	return ESP_OK;
@@ -20,7 +20,7 @@
 #include "lvgl.h"
 #include "port_i2c_readings.h" // for readings_snapshot_t
 #include "stocks_task.h"	   // for stocks_snapshot_t
-#include "weather_task.h"	   // for weather_current_t
+#include "weather_task.h"	   // for weather_snapshot_t
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -35,6 +35,20 @@ typedef enum {
 	UI_TEMP_F	   ///< Fahrenheit
 } ui_temp_unit_t;
 
+/**
+ * @brief Tiles of the tileview, left to right.
+ */
+typedef enum {
+	UI_TILE_CLOCK = 0,
+	UI_TILE_STATS,
+	UI_TILE_WEATHER,
+	UI_TILE_STOCKS,
+	UI_TILE_COUNT,
+} ui_tile_t;
+
+/** Mask with every tile's bit (bit n = ui_tile_t n). */
+#define UI_TILES_ALL ((1u << UI_TILE_COUNT) - 1)
+
 /**
  * @brief Initialize the UI system.
  *
@@ -75,8 +89,8 @@ ui_temp_unit_t ui_get_temp_unit(void);
 /**
  * @brief Set temperature unit mode.
  *
- * This does NOT automatically refresh UI.
- * Caller should trigger a refresh (e.g., next update cycle).
+ * Publishes DATA_TOPIC_VIEW, so ui_task redraws both temperature screens
+ * right away.
  */
 void ui_set_temp_unit(ui_temp_unit_t unit);
 
@@ -84,12 +98,14 @@ void ui_set_temp_unit(ui_temp_unit_t unit);
  * @brief Update the weather screen with the latest outdoor data.
  *
  * Safe to call periodically (e.g., every 500 ms).
- * Shows "Fetching..." placeholders when w->valid is false.
+ * Shows "--" placeholders while the displayed location is not yet valid.
  * Background colour changes between day (blue) and night (navy).
+ * With several locations configured, one is shown at a time; tapping the
+ * icon column pages to the next location.
  *
- * @param w Pointer to the latest weather snapshot.
+ * @param w Pointer to the latest multi-location weather snapshot.
  */
-void ui_update_weather(const weather_current_t *w);
+void ui_update_weather(const weather_snapshot_t *w);
 
 /**
  * @brief Update the stocks screen with the latest quote data.
@@ -101,6 +117,36 @@ void ui_update_weather(const weather_current_t *w);
  */
 void ui_update_stocks(const stocks_snapshot_t *s);
 
+/**
+ * @brief Tiles that can currently be on screen.
+ *
+ * The active tile, plus its neighbours from the moment a swipe starts
+ * until it settles. Every change publishes DATA_TOPIC_VIEW, so ui_task can
+ * catch a tile up before it slides into view.
+ *
+ * @return Mask of (1 << ui_tile_t) bits.
+ */
+uint32_t ui_visible_tiles(void);
+
+/**
+ * @brief Display redraw load, measured by the LVGL display driver.
+ */
+typedef struct {
+	uint32_t px_per_s;		  ///< Pixels re-rendered (invalidated area)
+	uint32_t refreshes_per_s; ///< Refresh cycles that rendered anything
+} ui_redraw_stats_t;
+
+/**
+ * @brief Redraw load averaged over about the last second.
+ *
+ * Fed by the display driver's monitor callback, so it reflects what LVGL
+ * actually re-rendered. Also logged at debug level once per second while
+ * the display is redrawing.
+ *
+ * @param out Receives the averages (zeros before ui_init()).
+ */
+void ui_get_redraw_stats(ui_redraw_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -127,29 +127,27 @@ void ui_clock_build(lv_obj_t *tile) {
 /** Update the large time label. Called from ui_set_time_str() under display
  * lock. */
 void ui_clock_set_time(const char *hhmmss) {
-	lv_label_set_text(s_lbl_clock_big, hhmmss);
+	ui_set_label_text(s_lbl_clock_big, hhmmss);
 }
 
+float ui_clock_sample_cpu(void) { return get_total_cpu_usage(); }
+
 /**
  * @brief Refresh CPU usage and date labels.
  *
- * Called every 150 ms by ui_task. Acquires the display lock internally.
- * The date is read from the system RTC (set by SNTP) so no extra parameter
- * is needed — it updates automatically once time is synchronised.
+ * Called by ui_task on each second tick while the clock tile is visible,
+ * under the display lock. The date comes from the same local time ui_task
+ * formatted the clock label from, so the two always agree.
  */
-float ui_clock_sample_cpu(void) { return get_total_cpu_usage(); }
-
-void ui_clock_update_cpu(float cpu_pct) {
-	/* Format date from system time: "Mon Mar 09" */
-	char date_buf[20];
-	struct tm timeinfo = {0};
-	time_t now = time(NULL);
-	localtime_r(&now, &timeinfo);
-	strftime(date_buf, sizeof(date_buf), "%a %b %d", &timeinfo);
+void ui_clock_update(const struct tm *now, float cpu_pct) {
+	if (now) {
+		/* "Mon Mar 09" */
+		char date_buf[20];
+		if (strftime(date_buf, sizeof(date_buf), "%a %b %d", now) != 0)
+			ui_set_label_text(s_lbl_date, date_buf);
+	}
 
 	char cpu_buf[16];
 	snprintf(cpu_buf, sizeof(cpu_buf), "CPU: %.1f%%", cpu_pct);
-
-	lv_label_set_text(s_lbl_date, date_buf);
-	lv_label_set_text(s_lbl_cpu, cpu_buf);
+	ui_set_label_text(s_lbl_cpu, cpu_buf);
 }
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "lvgl.h"
+#include <time.h>
 
 /**
  * @defgroup screen_build Screen build functions
@@ -27,8 +28,11 @@ void ui_clock_build(lv_obj_t *tile);
 /** Sample CPU usage counters (no LVGL calls — call before display lock). */
 float ui_clock_sample_cpu(void);
 
-/** Refresh the CPU usage and date labels using a pre-sampled value. */
-void ui_clock_update_cpu(float cpu_pct);
+/**
+ * Refresh the date and CPU usage labels using pre-sampled values.
+ * @p now is NULL while the clock is not set; the date is then left as is.
+ */
+void ui_clock_update(const struct tm *now, float cpu_pct);
 
 /** Build the indoor sensor dashboard tile (2×2 card grid + header bar). */
 void ui_stats_build(lv_obj_t *tile);
@@ -56,3 +60,28 @@ void ui_clock_set_time(const char *hhmmss);
 void ui_stats_set_time(const char *hhmmss);
 
 /** @} */
+
+/**
+ * @defgroup screen_setters Change-only widget setters
+ *
+ * Drop-in replacements for the LVGL setters used by the ui_update_* paths.
+ * Every LVGL setter invalidates its object, and the renderer then redraws
+ * that area even when the value is the same. These compare with what the
+ * widget already holds (its text, local style or flags, so no separate
+ * cache is kept) and only call LVGL on a real change. Display lock held.
+ * @{
+ */
+
+/** lv_label_set_text() unless the label already shows text. */
+void ui_set_label_text(lv_obj_t *lbl, const char *text);
+
+/** Set the main part's text colour unless it is already its local style. */
+void ui_set_text_color(lv_obj_t *obj, lv_color_t color);
+
+/** Set the main part's bg colour unless it is already its local style. */
+void ui_set_bg_color(lv_obj_t *obj, lv_color_t color);
+
+/** Add or clear LV_OBJ_FLAG_HIDDEN unless it is already in that state. */
+void ui_set_hidden(lv_obj_t *obj, bool hidden);
+
+/** @} */
@@ -47,13 +47,27 @@ static struct {
  * @brief Toggle the global temperature unit on tap.
  *
  * Registered on the TEMP card. The change is picked up by both this screen
- * and the weather screen on the next ui_task tick (~150 ms).
+ * and the weather screen as soon as ui_task wakes on DATA_TOPIC_VIEW.
  */
 static void on_temp_clicked(lv_event_t *e) {
 	(void)e;
 	ui_set_temp_unit(ui_get_temp_unit() == UI_TEMP_C ? UI_TEMP_F : UI_TEMP_C);
 }
 
+/**
+ * @brief Card text colour for a readings_band_t.
+ */
+static lv_color_t band_color(uint8_t band) {
+	switch (band) {
+	case READINGS_BAND_GOOD:
+		return lv_color_hex(CLR_GREEN);
+	case READINGS_BAND_FAIR:
+		return lv_color_hex(CLR_YELLOW);
+	default:
+		return lv_color_hex(CLR_RED);
+	}
+}
+
 /**
  * @brief Create a styled sensor card with a muted title and white value label.
  *
@@ -160,7 +174,7 @@ void ui_stats_build(lv_obj_t *tile) {
 
 /** Update the small time label in the stats header. */
 void ui_stats_set_time(const char *hhmmss) {
-	lv_label_set_text(s_stats.lbl_time, hhmmss);
+	ui_set_label_text(s_stats.lbl_time, hhmmss);
 }
 
 /**
@@ -183,32 +197,19 @@ void ui_update_readings(const readings_snapshot_t *s) {
 					 : s->temp_c;
 	snprintf(buf, sizeof(buf), "%.1f\xc2\xb0%s", temp,
 			 ui_get_temp_unit() == UI_TEMP_F ? "F" : "C");
-	lv_label_set_text(s_stats.lbl_temp_val, buf);
+	ui_set_label_text(s_stats.lbl_temp_val, buf);
 
 	snprintf(buf, sizeof(buf), "%.1f%%", s->rh_percent);
-	lv_label_set_text(s_stats.lbl_hum_val, buf);
+	ui_set_label_text(s_stats.lbl_hum_val, buf);
 
-	/* CO2: colour-coded green → yellow → red */
+	/* CO2: colour-coded green → yellow → red by the filtered band, which
+	 * has hysteresis, so the colour does not flicker at the edges */
 	snprintf(buf, sizeof(buf), "%u ppm", (unsigned)s->eco2_ppm);
-	lv_label_set_text(s_stats.lbl_co2_val, buf);
-	lv_color_t co2_color;
-	if (s->eco2_ppm < 800)
-		co2_color = lv_color_hex(CLR_GREEN);
-	else if (s->eco2_ppm < 1500)
-		co2_color = lv_color_hex(CLR_YELLOW);
-	else
-		co2_color = lv_color_hex(CLR_RED);
-	lv_obj_set_style_text_color(s_stats.lbl_co2_val, co2_color, LV_PART_MAIN);
+	ui_set_label_text(s_stats.lbl_co2_val, buf);
+	ui_set_text_color(s_stats.lbl_co2_val, band_color(s->eco2_band));
 
 	/* TVOC: colour-coded green → yellow → red */
 	snprintf(buf, sizeof(buf), "%u ppb", (unsigned)s->tvoc_ppb);
-	lv_label_set_text(s_stats.lbl_tvoc_val, buf);
-	lv_color_t tvoc_color;
-	if (s->tvoc_ppb < 200)
-		tvoc_color = lv_color_hex(CLR_GREEN);
-	else if (s->tvoc_ppb < 500)
-		tvoc_color = lv_color_hex(CLR_YELLOW);
-	else
-		tvoc_color = lv_color_hex(CLR_RED);
-	lv_obj_set_style_text_color(s_stats.lbl_tvoc_val, tvoc_color, LV_PART_MAIN);
+	ui_set_label_text(s_stats.lbl_tvoc_val, buf);
+	ui_set_text_color(s_stats.lbl_tvoc_val, band_color(s->tvoc_band));
 }
@@ -161,29 +161,27 @@ void ui_update_stocks(const stocks_snapshot_t *s) {
 
 	for (int i = 0; i < STOCKS_MAX_SYMBOLS; i++) {
 		if (i >= s->count) {
-			lv_label_set_text(s_stocks.lbl_symbol[i], "");
-			lv_label_set_text(s_stocks.lbl_price[i], "");
-			lv_label_set_text(s_stocks.lbl_dollar[i], "");
-			lv_label_set_text(s_stocks.lbl_pct[i], "");
+			ui_set_label_text(s_stocks.lbl_symbol[i], "");
+			ui_set_label_text(s_stocks.lbl_price[i], "");
+			ui_set_label_text(s_stocks.lbl_dollar[i], "");
+			ui_set_label_text(s_stocks.lbl_pct[i], "");
 			continue;
 		}
 
 		const stock_quote_t *q = &s->quotes[i];
 
-		lv_label_set_text(s_stocks.lbl_symbol[i], q->symbol);
+		ui_set_label_text(s_stocks.lbl_symbol[i], q->symbol);
 
 		if (!q->valid) {
-			lv_label_set_text(s_stocks.lbl_price[i], "--");
-			lv_label_set_text(s_stocks.lbl_dollar[i], "--");
-			lv_label_set_text(s_stocks.lbl_pct[i], "");
-			lv_obj_set_style_text_color(s_stocks.lbl_dollar[i],
-										lv_color_hex(VALUE_COLOR),
-										LV_PART_MAIN);
-			lv_obj_set_style_text_color(
-				s_stocks.lbl_pct[i], lv_color_hex(TITLE_COLOR), LV_PART_MAIN);
+			ui_set_label_text(s_stocks.lbl_price[i], "--");
+			ui_set_label_text(s_stocks.lbl_dollar[i], "--");
+			ui_set_label_text(s_stocks.lbl_pct[i], "");
+			ui_set_text_color(s_stocks.lbl_dollar[i],
+							  lv_color_hex(VALUE_COLOR));
+			ui_set_text_color(s_stocks.lbl_pct[i], lv_color_hex(TITLE_COLOR));
 		} else {
 			snprintf(buf, sizeof(buf), "$%.2f", q->price);
-			lv_label_set_text(s_stocks.lbl_price[i], buf);
+			ui_set_label_text(s_stocks.lbl_price[i], buf);
 
 			lv_color_t chg_color = (q->change_pct >= 0.0f)
 									   ? lv_color_hex(POS_COLOR)
@@ -191,15 +189,13 @@ void ui_update_stocks(const stocks_snapshot_t *s) {
 
 			/* Top line: absolute dollar change */
 			snprintf(buf, sizeof(buf), "%+.2f", q->change);
-			lv_label_set_text(s_stocks.lbl_dollar[i], buf);
-			lv_obj_set_style_text_color(s_stocks.lbl_dollar[i], chg_color,
-										LV_PART_MAIN);
+			ui_set_label_text(s_stocks.lbl_dollar[i], buf);
+			ui_set_text_color(s_stocks.lbl_dollar[i], chg_color);
 
 			/* Bottom line: percent change */
 			snprintf(buf, sizeof(buf), "%+.2f%%", q->change_pct);
-			lv_label_set_text(s_stocks.lbl_pct[i], buf);
-			lv_obj_set_style_text_color(s_stocks.lbl_pct[i], chg_color,
-										LV_PART_MAIN);
+			ui_set_label_text(s_stocks.lbl_pct[i], buf);
+			ui_set_text_color(s_stocks.lbl_pct[i], chg_color);
 		}
 	}
 }
@@ -2,20 +2,27 @@
  * @file ui_task.c
  * @brief UI update task, pinned to core 0.
  *
- * Owns the periodic loop that pulls the latest data from each service and
- * pushes it to the LVGL screens. Runs on core 0 to leave core 1 free for
- * the LVGL renderer and BSP display driver (pinned to core 1 by the BSP).
+ * Owns the loop that pulls the latest data from each service and pushes it
+ * to the LVGL screens. Runs on core 0 to leave core 1 free for the LVGL
+ * renderer and BSP display driver (pinned to core 1 by the BSP).
  *
- * Update rate: 300 ms — fast enough for a smooth clock display and
- * responsive touch, low enough not to flood the LVGL queue.
+ * The task sleeps on the data bus: a published topic marks its tile dirty,
+ * and a dirty tile is redrawn (from a fresh snapshot) only while it can be
+ * seen — see ui_visible_tiles(). Hidden tiles catch up when a swipe starts
+ * to bring them in. The clock advances on DATA_TOPIC_CLOCK, published by a
+ * one-shot esp_timer re-armed for just after each wall-clock second, so
+ * the label flips on the second and the task does not wake in between.
  *
- * All LVGL writes happen inside the screen update functions, which each
- * acquire bsp_display_lock() internally. This task does not hold the lock
- * directly.
+ * All LVGL writes of a pass happen under one bsp_display_lock(); how often
+ * the task wakes and how long it holds the lock is reported by
+ * ui_task_get_stats().
  */
 
 #include "ui_task.h"
 #include "bsp/m5stack_core_s3.h"
+#include "data_bus.h"
+#include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "port_i2c_readings.h"
@@ -24,42 +31,211 @@
 #include "ui.h"
 #include "ui_screens.h"
 #include "weather_task.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define TAG "ui_task"
+
+/* Fire this long past the second boundary so the time read by the woken
+ * pass is already in the new second. */
+#define UI_TICK_MARGIN_US 2000
+
+/* Length of the window ui_task_get_stats() averages over. */
+#define UI_STATS_WINDOW_US (10 * 1000 * 1000)
+
+static esp_timer_handle_t s_tick_timer;
+
+/*
+ * Wakeup and lock accounting. Accumulated by ui_task only; the finished
+ * window is published under s_stats_lock.
+ */
+static struct {
+	int64_t window_start_us;
+	uint32_t wakeups;
+	uint32_t holds;
+	int64_t hold_acc_us;
+	uint32_t hold_max_us;
+} s_acc;
+
+static ui_task_stats_t s_stats;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void arm_tick(void) {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	esp_timer_start_once(s_tick_timer,
+						 1000000 - tv.tv_usec + UI_TICK_MARGIN_US);
+}
+
+/**
+ * @brief esp_timer callback: the wall-clock second just turned.
+ *
+ * Re-arming from the current time, rather than running a periodic timer,
+ * keeps the tick on the boundary across SNTP corrections.
+ */
+static void on_tick(void *arg) {
+	(void)arg;
+	data_bus_publish(DATA_TOPIC_CLOCK);
+	arm_tick();
+}
+
+static void account_pass(int64_t hold_us) {
+	s_acc.wakeups++;
+	if (hold_us >= 0) {
+		s_acc.holds++;
+		s_acc.hold_acc_us += hold_us;
+		if (hold_us > s_acc.hold_max_us) {
+			s_acc.hold_max_us = (uint32_t)hold_us;
+		}
+	}
+
+	int64_t now = esp_timer_get_time();
+	int64_t elapsed = now - s_acc.window_start_us;
+	if (elapsed < UI_STATS_WINDOW_US) {
+		return;
+	}
+
+	ui_task_stats_t st = {
+		.wakeups_per_s = s_acc.wakeups * 1e6f / (float)elapsed,
+		.lock_hold_avg_us =
+			s_acc.holds ? (uint32_t)(s_acc.hold_acc_us / s_acc.holds) : 0,
+		.lock_hold_max_us = s_acc.hold_max_us,
+	};
+	portENTER_CRITICAL(&s_stats_lock);
+	s_stats = st;
+	portEXIT_CRITICAL(&s_stats_lock);
+	ESP_LOGD(TAG, "%.2f wakeups/s, display lock held %u us avg, %u us max",
+			 st.wakeups_per_s, (unsigned)st.lock_hold_avg_us,
+			 (unsigned)st.lock_hold_max_us);
+
+	memset(&s_acc, 0, sizeof(s_acc));
+	s_acc.window_start_us = now;
+}
+
+void ui_task_get_stats(ui_task_stats_t *out) {
+	if (!out) {
+		return;
+	}
+	portENTER_CRITICAL(&s_stats_lock);
+	*out = s_stats;
+	portEXIT_CRITICAL(&s_stats_lock);
+}
 
 /**
  * @brief Main UI refresh loop.
  *
- * Reads each data source in turn then delays. Snapshot structs are stack-
- * allocated and reused each iteration — no heap allocation in steady state.
+ * Marks the tiles whose topics were published since the last pass dirty
+ * (all of them on DATA_TOPIC_VIEW), redraws the dirty ones that are
+ * visible, then sleeps on the data bus. Local time is read once per pass
+ * and feeds both the time labels and the date. Snapshot structs are
+ * stack-allocated and kept between passes — no heap allocation in steady
+ * state.
  */
 static void ui_task(void *arg) {
 	(void)arg;
 
 	readings_snapshot_t snapshot = {0};
-	weather_current_t weather = {0};
+	weather_snapshot_t weather = {0};
 	stocks_snapshot_t stocks = {0};
 	char time_str[9]; /* "HH:MM:SS\0" */
 
+	const uint32_t subscribed = DATA_TOPIC_READINGS | DATA_TOPIC_WEATHER |
+								DATA_TOPIC_STOCKS | DATA_TOPIC_VIEW |
+								DATA_TOPIC_CLOCK;
+	ESP_ERROR_CHECK(data_bus_subscribe(subscribed));
+
+	const esp_timer_create_args_t tick_args = {
+		.callback = on_tick,
+		.dispatch_method = ESP_TIMER_TASK,
+		.name = "ui_tick",
+	};
+	ESP_ERROR_CHECK(esp_timer_create(&tick_args, &s_tick_timer));
+	arm_tick();
+
+	/* Tiles with a time label; elsewhere a tick alone has nothing to do. */
+	const uint32_t time_tiles = (1u << UI_TILE_CLOCK) | (1u << UI_TILE_STATS);
+	uint32_t topics = 0;
+	uint32_t dirty = UI_TILES_ALL; /* each tile's first sight draws it */
+	s_acc.window_start_us = esp_timer_get_time();
+
 	for (;;) {
+		if (topics & DATA_TOPIC_READINGS) {
+			dirty |= 1u << UI_TILE_STATS;
+		}
+		if (topics & DATA_TOPIC_WEATHER) {
+			dirty |= 1u << UI_TILE_WEATHER;
+		}
+		if (topics & DATA_TOPIC_STOCKS) {
+			dirty |= 1u << UI_TILE_STOCKS;
+		}
+		if (topics & DATA_TOPIC_CLOCK) {
+			dirty |= 1u << UI_TILE_CLOCK;
+		}
+		/* A view change (unit, page, swipe) redraws from fresh snapshots. */
+		if (topics & DATA_TOPIC_VIEW) {
+			dirty = UI_TILES_ALL;
+		}
+
+		uint32_t visible = ui_visible_tiles();
+		uint32_t draw = dirty & visible;
+		dirty &= ~draw;
+
+		/* Time labels only change on a tick */
+		bool tick = topics & DATA_TOPIC_CLOCK;
+		if (!draw && !(tick && (visible & time_tiles))) {
+			account_pass(-1);
+			topics = data_bus_wait(portMAX_DELAY);
+			continue;
+		}
+
 		/* Gather all data before acquiring the lock — no LVGL calls here.
 		 * ui_clock_sample_cpu() calls uxTaskGetSystemState which briefly
 		 * suspends the scheduler; keeping it outside the lock lets the
-		 * LVGL renderer run freely during the measurement. */
-		sntp_service_format_local_time("%H:%M:%S", time_str, sizeof(time_str));
-		readings_get_snapshot(&snapshot);
-		weather_get_snapshot(&weather);
-		stocks_get_snapshot(&stocks);
-		float cpu_pct = ui_clock_sample_cpu();
+		 * LVGL renderer run freely during the measurement. It is only
+		 * taken when the clock tile is redrawn, so once per second. */
+		struct tm now;
+		const struct tm *now_p = NULL;
+		if (sntp_service_get_local_timeinfo(&now) == ESP_OK &&
+			strftime(time_str, sizeof(time_str), "%H:%M:%S", &now) != 0) {
+			now_p = &now;
+		} else {
+			snprintf(time_str, sizeof(time_str), "--:--");
+		}
+		if (draw & (1u << UI_TILE_STATS)) {
+			readings_get_snapshot(&snapshot);
+		}
+		if (draw & (1u << UI_TILE_WEATHER)) {
+			weather_get_snapshot(&weather);
+		}
+		if (draw & (1u << UI_TILE_STOCKS)) {
+			stocks_get_snapshot(&stocks);
+		}
+		bool clock_drawn = draw & (1u << UI_TILE_CLOCK);
+		float cpu_pct = clock_drawn ? ui_clock_sample_cpu() : 0.0f;
 
 		/* Single lock for all LVGL writes. */
 		bsp_display_lock(0);
+		int64_t locked_us = esp_timer_get_time();
 		ui_set_time_str(time_str);
-		ui_update_readings(&snapshot);
-		ui_update_weather(&weather);
-		ui_update_stocks(&stocks);
-		ui_clock_update_cpu(cpu_pct);
+		if (draw & (1u << UI_TILE_STATS)) {
+			ui_update_readings(&snapshot);
+		}
+		if (draw & (1u << UI_TILE_WEATHER)) {
+			ui_update_weather(&weather);
+		}
+		if (draw & (1u << UI_TILE_STOCKS)) {
+			ui_update_stocks(&stocks);
+		}
+		if (clock_drawn) {
+			ui_clock_update(now_p, cpu_pct);
+		}
+		int64_t hold_us = esp_timer_get_time() - locked_us;
 		bsp_display_unlock();
 
-		vTaskDelay(pdMS_TO_TICKS(100));
+		account_pass(hold_us);
+		topics = data_bus_wait(portMAX_DELAY);
 	}
 }
 
@@ -1,15 +1,27 @@
 /**
  * @file ui_task.h
- * @brief UI update task: periodically pulls sensor/weather/time data and
- *        pushes it to the LVGL screens.
+ * @brief UI update task: pulls sensor/weather/stocks/time data and pushes
+ *        it to the LVGL screens.
  *
- * This is the only entry point needed by app_main. All data sources
- * (sensor readings, weather snapshots, SNTP time) are queried internally
- * at a fixed 150 ms interval on core 0.
+ * This is the only entry point needed by app_main. The task sleeps on the
+ * data bus (data_bus.h) and copies a snapshot only after its producer
+ * published a change; the clock is advanced by a timer aligned to the
+ * wall-clock second.
  */
 
 #pragma once
 
+#include <stdint.h>
+
+/**
+ * @brief UI task load, averaged over the last 10 s window.
+ */
+typedef struct {
+	float wakeups_per_s;	   ///< Passes through the refresh loop
+	uint32_t lock_hold_avg_us; ///< Mean bsp_display_lock() hold per pass
+	uint32_t lock_hold_max_us; ///< Longest hold in the window
+} ui_task_stats_t;
+
 /**
  * @brief Create and start the UI update task, pinned to core 0.
  *
@@ -20,3 +32,9 @@
  * display driver (both defaulting to core 1) are not disrupted.
  */
 void ui_task_start(void);
+
+/**
+ * @brief Copy the latest load figures; all zero until the first window
+ *        has completed. Safe to call from any task.
+ */
+void ui_task_get_stats(ui_task_stats_t *out);
@@ -26,12 +26,17 @@
  *             – Flex-column of title/value row pairs (Precipitation,
  *               Humidity, Wind). Titles in muted blue, values in white.
  *
+ * Location header (top-centre, montserrat_16, muted blue):
+ *   – Name of the displayed location, plus "i/N" when several locations are
+ *     configured. Tapping the icon column pages to the next location.
+ *
  * Background colour:
  *   Loading / night → deep navy (#0D111F)
  *   Daytime         → lighter slate (#1E3050)
  */
 
 #include "bsp/m5stack_core_s3.h"
+#include "data_bus.h"
 #include "ui.h"
 #include "ui_screens.h"
 #include <stdio.h>
@@ -47,6 +52,8 @@ static struct {
 	lv_obj_t *lbl_hum_val;
 	lv_obj_t *lbl_wind_val;
 	lv_obj_t *lbl_precip_val;
+	lv_obj_t *lbl_loc; /* location name + page indicator */
+	int page;		   /* index of the displayed location */
 } s_weather;
 
 /** Convert Celsius to Fahrenheit. */
@@ -63,6 +70,19 @@ static void on_temp_clicked(lv_event_t *e) {
 	ui_set_temp_unit(ui_get_temp_unit() == UI_TEMP_C ? UI_TEMP_F : UI_TEMP_C);
 }
 
+/**
+ * @brief Page to the next configured location on tap.
+ *
+ * Registered on the icon column. The index wraps in ui_update_weather(),
+ * which knows how many locations the snapshot carries; publishing
+ * DATA_TOPIC_VIEW makes ui_task call it.
+ */
+static void on_page_clicked(lv_event_t *e) {
+	(void)e;
+	s_weather.page++;
+	data_bus_publish(DATA_TOPIC_VIEW);
+}
+
 /**
  * @brief Append a title + value label pair to a flex-column container.
  *
@@ -123,6 +143,8 @@ void ui_weather_build(lv_obj_t *tile) {
 	lv_obj_set_style_bg_opa(icon_col, LV_OPA_TRANSP, LV_PART_MAIN);
 	lv_obj_set_style_border_width(icon_col, 0, LV_PART_MAIN);
 	lv_obj_set_style_pad_all(icon_col, 0, LV_PART_MAIN);
+	lv_obj_add_flag(icon_col, LV_OBJ_FLAG_CLICKABLE);
+	lv_obj_add_event_cb(icon_col, on_page_clicked, LV_EVENT_CLICKED, NULL);
 
 	/* Sun/moon circle — colour updated dynamically in ui_update_weather() */
 	s_weather.icon_sun = lv_obj_create(icon_col);
@@ -217,41 +239,66 @@ void ui_weather_build(lv_obj_t *tile) {
 	add_stat_row(stats_col, "Precipitation", &s_weather.lbl_precip_val);
 	add_stat_row(stats_col, "Humidity", &s_weather.lbl_hum_val);
 	add_stat_row(stats_col, "Wind", &s_weather.lbl_wind_val);
+
+	/* ---- Top: location header (created last so it draws on top) ---- */
+	s_weather.lbl_loc = lv_label_create(tile);
+	lv_label_set_text(s_weather.lbl_loc, "");
+	lv_obj_set_style_text_color(s_weather.lbl_loc, lv_color_hex(0x6A8FAF),
+								LV_PART_MAIN);
+	lv_obj_set_style_text_font(s_weather.lbl_loc, &lv_font_montserrat_16,
+							   LV_PART_MAIN);
+	lv_obj_align(s_weather.lbl_loc, LV_ALIGN_TOP_MID, 0, 6);
 }
 
 /**
  * @brief Refresh the weather screen with the latest outdoor data.
  *
- * When w->valid is false (no successful fetch yet), all labels show "--"
- * and the icon reverts to the loading state (grey circle, no cloud/rain).
+ * Only the currently paged location is rendered. When it is not valid yet
+ * (no successful fetch), all labels show "--" and the icon reverts to the
+ * loading state (grey circle, no cloud/rain).
  *
- * @param w Latest weather snapshot from weather_get_snapshot().
+ * @param snap Latest weather snapshot from weather_get_snapshot().
  */
-void ui_update_weather(const weather_current_t *w) {
-	if (!w)
+void ui_update_weather(const weather_snapshot_t *snap) {
+	if (!snap)
 		return;
 
 	char buf[32];
 
+	/* Wrap the page index here; the tap handler only increments it */
+	if (snap->count > 0) {
+		s_weather.page %= snap->count;
+	} else {
+		s_weather.page = 0;
+	}
+
+	static const weather_current_t empty = {0};
+	const weather_current_t *w =
+		(snap->count > 0) ? &snap->locations[s_weather.page] : &empty;
+
+	if (snap->count > 1) {
+		snprintf(buf, sizeof(buf), "%s  %d/%d", w->name, s_weather.page + 1,
+				 snap->count);
+		ui_set_label_text(s_weather.lbl_loc, buf);
+	} else {
+		ui_set_label_text(s_weather.lbl_loc, w->name);
+	}
+
 	if (!w->valid) {
 		/* No data yet — show placeholders and a neutral grey icon */
-		lv_label_set_text(s_weather.lbl_temp, "--");
-		lv_label_set_text(s_weather.lbl_hum_val, "--");
-		lv_label_set_text(s_weather.lbl_wind_val, "--");
-		lv_label_set_text(s_weather.lbl_precip_val, "--");
-		lv_obj_set_style_bg_color(s_weather.icon_sun, lv_color_hex(0x3A4A5A),
-								  LV_PART_MAIN);
-		lv_obj_add_flag(s_weather.icon_cloud, LV_OBJ_FLAG_HIDDEN);
+		ui_set_label_text(s_weather.lbl_temp, "--");
+		ui_set_label_text(s_weather.lbl_hum_val, "--");
+		ui_set_label_text(s_weather.lbl_wind_val, "--");
+		ui_set_label_text(s_weather.lbl_precip_val, "--");
+		ui_set_bg_color(s_weather.icon_sun, lv_color_hex(0x3A4A5A));
+		ui_set_hidden(s_weather.icon_cloud, true);
 		for (int i = 0; i < 3; i++)
-			lv_obj_add_flag(s_weather.icon_rain[i], LV_OBJ_FLAG_HIDDEN);
-		lv_obj_set_style_bg_color(s_weather.tile, lv_color_hex(0x0D111F),
-								  LV_PART_MAIN);
+			ui_set_hidden(s_weather.icon_rain[i], true);
+		ui_set_bg_color(s_weather.tile, lv_color_hex(0x0D111F));
 	} else {
 		/* Background: lighter slate-blue during the day, deep navy at night */
-		lv_obj_set_style_bg_color(s_weather.tile,
-								  w->is_day ? lv_color_hex(0x1E3050)
-											: lv_color_hex(0x0D111F),
-								  LV_PART_MAIN);
+		ui_set_bg_color(s_weather.tile, w->is_day ? lv_color_hex(0x1E3050)
+												  : lv_color_hex(0x0D111F));
 
 		/* Temperature label: rounded integer + convert if °F mode active */
 		float temp = (ui_get_temp_unit() == UI_TEMP_F)
@@ -259,24 +306,22 @@ void ui_update_weather(const weather_current_t *w) {
 						 : w->temperature_c;
 		const char *unit = (ui_get_temp_unit() == UI_TEMP_F) ? "F" : "C";
 		snprintf(buf, sizeof(buf), "%.0f", temp);
-		lv_label_set_text(s_weather.lbl_temp, buf);
+		ui_set_label_text(s_weather.lbl_temp, buf);
 
 		/* Unit hint: active unit shown first so it reads "°F | °C" or "°C | °F"
 		 */
 		snprintf(buf, sizeof(buf), "\xc2\xb0%s | \xc2\xb0%s", unit,
 				 (ui_get_temp_unit() == UI_TEMP_F) ? "C" : "F");
-		lv_label_set_text(s_weather.lbl_unit, buf);
+		ui_set_label_text(s_weather.lbl_unit, buf);
 
 		/* Day/night icon state */
 		if (w->is_day) {
-			lv_obj_set_style_bg_color(s_weather.icon_sun,
-									  lv_color_hex(0xFF9500), LV_PART_MAIN);
-			lv_obj_clear_flag(s_weather.icon_cloud, LV_OBJ_FLAG_HIDDEN);
+			ui_set_bg_color(s_weather.icon_sun, lv_color_hex(0xFF9500));
+			ui_set_hidden(s_weather.icon_cloud, false);
 		} else {
 			/* Night: silver moon circle, no cloud */
-			lv_obj_set_style_bg_color(s_weather.icon_sun,
-									  lv_color_hex(0xA8B8CC), LV_PART_MAIN);
-			lv_obj_add_flag(s_weather.icon_cloud, LV_OBJ_FLAG_HIDDEN);
+			ui_set_bg_color(s_weather.icon_sun, lv_color_hex(0xA8B8CC));
+			ui_set_hidden(s_weather.icon_cloud, true);
 		}
 
 		/* Rain drop count encodes intensity:
@@ -293,18 +338,18 @@ void ui_update_weather(const weather_current_t *w) {
 			rain_drops = 1;
 		for (int i = 0; i < 3; i++) {
 			if (i < rain_drops)
-				lv_obj_clear_flag(s_weather.icon_rain[i], LV_OBJ_FLAG_HIDDEN);
+				ui_set_hidden(s_weather.icon_rain[i], false);
 			else
-				lv_obj_add_flag(s_weather.icon_rain[i], LV_OBJ_FLAG_HIDDEN);
+				ui_set_hidden(s_weather.icon_rain[i], true);
 		}
 
 		snprintf(buf, sizeof(buf), "%d%%", w->humidity_pct);
-		lv_label_set_text(s_weather.lbl_hum_val, buf);
+		ui_set_label_text(s_weather.lbl_hum_val, buf);
 
 		snprintf(buf, sizeof(buf), "%.0f mph", w->windspeed_mph);
-		lv_label_set_text(s_weather.lbl_wind_val, buf);
+		ui_set_label_text(s_weather.lbl_wind_val, buf);
 
 		snprintf(buf, sizeof(buf), "%.1f mm", w->precipitation_mm);
-		lv_label_set_text(s_weather.lbl_precip_val, buf);
+		ui_set_label_text(s_weather.lbl_precip_val, buf);
 	}
 }
@@ -0,0 +1,49 @@
+/**
+ * @file ui_widgets.c
+ * @brief Change-only widget setters (see ui_screens.h).
+ */
+
+#include "ui_screens.h"
+#include <string.h>
+
+void ui_set_label_text(lv_obj_t *lbl, const char *text) {
+	const char *cur = lv_label_get_text(lbl);
+	if (cur && strcmp(cur, text) == 0)
+		return;
+	lv_label_set_text(lbl, text);
+}
+
+/**
+ * True if obj's main part has color as a local style. The resolved value
+ * would not do: it includes what the parent passes down, and a widget
+ * left without a local style would follow a later parent change (the
+ * weather tile switching between day and night, for one).
+ */
+static bool has_local_color(lv_obj_t *obj, lv_style_prop_t prop,
+							lv_color_t color) {
+	lv_style_value_t cur;
+	return lv_obj_get_local_style_prop(obj, prop, &cur, LV_PART_MAIN) ==
+			   LV_RES_OK &&
+		   lv_color_to32(cur.color) == lv_color_to32(color);
+}
+
+void ui_set_text_color(lv_obj_t *obj, lv_color_t color) {
+	if (has_local_color(obj, LV_STYLE_TEXT_COLOR, color))
+		return;
+	lv_obj_set_style_text_color(obj, color, LV_PART_MAIN);
+}
+
+void ui_set_bg_color(lv_obj_t *obj, lv_color_t color) {
+	if (has_local_color(obj, LV_STYLE_BG_COLOR, color))
+		return;
+	lv_obj_set_style_bg_color(obj, color, LV_PART_MAIN);
+}
+
+void ui_set_hidden(lv_obj_t *obj, bool hidden) {
+	if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) == hidden)
+		return;
+	if (hidden)
+		lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+	else
+		lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
+}
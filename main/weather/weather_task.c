@@ -1,38 +1,74 @@
 #include <inttypes.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "cJSON.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
+#include "freertos/queue.h"
 
+#include "data_bus.h"
 #include "http_service.h"
 #include "sdkconfig.h"
+#include "seqlock.h"
+#include "sntp.h"
 #include "weather_task.h"
 
 static const char *TAG = "weather";
 
+/* Open-Meteo refreshes its "current" block every 15 minutes. Used when the
+ * response does not carry current.interval. */
+#define WEATHER_PROVIDER_CADENCE_S (15 * 60)
+
+/* Fetch this long after a model slot starts so the new data is published. */
+#define WEATHER_SLOT_SLACK_S 60
+
+/* Change between successive snapshots that counts as "changing fast". */
+#define WEATHER_PRECIP_FAST_MM 0.2f
+#define WEATHER_WIND_FAST_MPH 5.0f
+
+/**
+ * @brief Compile-time list of configured locations.
+ *
+ * Entries with a blank latitude (left empty in menuconfig) are skipped at
+ * runtime. The first entry is the primary location and is always present.
+ */
+static const struct {
+	const char *name;
+	const char *lat;
+	const char *lon;
+} s_configured_locations[WEATHER_MAX_LOCATIONS] = {
+	{CONFIG_LOCATION_NAME, CONFIG_LOCATION_LATITUDE, CONFIG_LOCATION_LONGITUDE},
+	{CONFIG_LOCATION_2_NAME, CONFIG_LOCATION_2_LATITUDE,
+	 CONFIG_LOCATION_2_LONGITUDE},
+	{CONFIG_LOCATION_3_NAME, CONFIG_LOCATION_3_LATITUDE,
+	 CONFIG_LOCATION_3_LONGITUDE},
+};
+
 /**
  * @brief Shared weather snapshot used by the UI.
  *
- * The weather task periodically fetches data and updates this structure.
- * The UI reads the latest snapshot via weather_get_snapshot().
+ * The weather task periodically fetches data for every configured location
+ * and updates this structure. The UI reads the latest snapshot via
+ * weather_get_snapshot().
  *
  * Synchronization:
- *  - Access is guarded by s_weather_mu to prevent partial reads while the
- *    writer task is updating.
+ *  - Guarded by s_weather_sl. The weather task is the only writer and reads
+ *    its own data directly; readers copy it out with seqlock_read(), which
+ *    never blocks and retries if it overlapped an update.
  */
-static weather_current_t s_weather;
+static weather_snapshot_t s_weather;
+static seqlock_t s_weather_sl = SEQLOCK_INIT;
 
 /**
- * @brief Mutex protecting the shared weather snapshot.
+ * @brief Poll interval chosen for the next fetch (seconds).
  *
- * Notes:
- *  - Created once in weather_task_start().
- *  - Both the weather task and the UI use this mutex when accessing s_weather.
+ * Written only by the weather task, read by weather_get_poll_interval_s().
+ * A single aligned 32-bit word, so no lock is needed.
  */
-static SemaphoreHandle_t s_weather_mu;
+static volatile uint32_t s_poll_interval_s;
 
 /**
  * @brief Copy out the latest weather snapshot for UI consumption.
@@ -41,27 +77,32 @@ static SemaphoreHandle_t s_weather_mu;
  * the most recent weather values without racing the weather task.
  *
  * @param[out] out Destination struct to receive the snapshot.
- * @return true if a valid snapshot is available, false otherwise.
+ * @return true if at least one location is valid, false otherwise.
  *
  * Notes:
  *  - Returns false until at least one successful fetch+parse has completed.
- *  - The copy is atomic with respect to the writer task (mutex-protected).
+ *  - The copy is coherent with respect to the writer task (seqlock).
  */
-bool weather_get_snapshot(weather_current_t *out) {
-	if (!out || !s_weather_mu) {
+bool weather_get_snapshot(weather_snapshot_t *out) {
+	if (!out) {
 		return false;
 	}
 
-	if (xSemaphoreTake(s_weather_mu, pdMS_TO_TICKS(20)) != pdTRUE) {
-		return false;
+	out->generation =
+		seqlock_read(&s_weather_sl, out, &s_weather, sizeof(*out));
+
+	for (int i = 0; i < out->count; i++) {
+		if (out->locations[i].valid) {
+			return true;
+		}
 	}
-	*out = s_weather;
-	xSemaphoreGive(s_weather_mu);
-	return out->valid;
+	return false;
 }
 
+uint32_t weather_get_poll_interval_s(void) { return s_poll_interval_s; }
+
 /**
- * @brief Parse an Open-Meteo JSON response into a weather snapshot.
+ * @brief Parse one Open-Meteo location object into a weather snapshot.
  *
  * Expects the standard Open-Meteo /v1/forecast JSON structure with a
  * "current" object containing:
@@ -71,26 +112,17 @@ bool weather_get_snapshot(weather_current_t *out) {
  *   precipitation         – mm
  *   windspeed_10m         – mph (requested via wind_speed_unit=mph)
  *   is_day                – 0 or 1
+ *   interval              – model update cadence in seconds (optional)
  *
- * @param[in]  json NUL-terminated JSON response body.
- * @param[out] out  Parsed snapshot (valid=true on success).
+ * @param[in]  loc  One location object (the root, or an array element).
+ * @param[out] out  Parsed snapshot (valid=true on success). name is left
+ *                  untouched.
  * @return true on successful parse, false otherwise.
  */
-static bool parse_openmeteo_current_json(const char *json,
-										 weather_current_t *out) {
-	if (!json || !out) {
-		return false;
-	}
-
-	bool ok = false;
-	cJSON *root = cJSON_Parse(json);
-	if (!root) {
-		return false;
-	}
-
-	const cJSON *current = cJSON_GetObjectItemCaseSensitive(root, "current");
+static bool parse_openmeteo_location(const cJSON *loc, weather_current_t *out) {
+	const cJSON *current = cJSON_GetObjectItemCaseSensitive(loc, "current");
 	if (!cJSON_IsObject(current)) {
-		goto done;
+		return false;
 	}
 
 	const cJSON *time_item = cJSON_GetObjectItemCaseSensitive(current, "time");
@@ -108,7 +140,7 @@ static bool parse_openmeteo_current_json(const char *json,
 	if (!cJSON_IsNumber(time_item) || !cJSON_IsNumber(temp_item) ||
 		!cJSON_IsNumber(hum_item) || !cJSON_IsNumber(prec_item) ||
 		!cJSON_IsNumber(wind_item) || !cJSON_IsNumber(isday_item)) {
-		goto done;
+		return false;
 	}
 
 	out->time_unix = (int64_t)time_item->valuedouble;
@@ -117,12 +149,138 @@ static bool parse_openmeteo_current_json(const char *json,
 	out->precipitation_mm = (float)prec_item->valuedouble;
 	out->windspeed_mph = (float)wind_item->valuedouble;
 	out->is_day = (isday_item->valuedouble != 0.0);
+
+	/* Optional: older responses omit it, fall back to the known cadence */
+	const cJSON *interval_item =
+		cJSON_GetObjectItemCaseSensitive(current, "interval");
+	out->update_interval_s = cJSON_IsNumber(interval_item)
+								 ? (int)interval_item->valuedouble
+								 : WEATHER_PROVIDER_CADENCE_S;
 	out->valid = true;
-	ok = true;
+	return true;
+}
+
+/**
+ * @brief Parse a (possibly multi-location) Open-Meteo response in one pass.
+ *
+ * When several comma-separated coordinates are requested, Open-Meteo returns
+ * a JSON array with one object per location, in request order. A single
+ * location returns a bare object. Both forms are handled here.
+ *
+ * @param[in]  json  NUL-terminated JSON response body.
+ * @param[out] out   Array of `count` snapshots; each is marked valid only if
+ *                   its element parsed successfully.
+ * @param[in]  count Number of locations that were requested.
+ * @return Number of locations parsed successfully.
+ */
+static int parse_openmeteo_json(const char *json, weather_current_t *out,
+								int count) {
+	if (!json || !out || count <= 0) {
+		return 0;
+	}
+
+	for (int i = 0; i < count; i++) {
+		out[i].valid = false;
+	}
+
+	cJSON *root = cJSON_Parse(json);
+	if (!root) {
+		return 0;
+	}
+
+	int parsed = 0;
+	if (cJSON_IsArray(root)) {
+		int i = 0;
+		const cJSON *loc = NULL;
+		cJSON_ArrayForEach(loc, root) {
+			if (i >= count) {
+				break;
+			}
+			if (parse_openmeteo_location(loc, &out[i])) {
+				parsed++;
+			}
+			i++;
+		}
+	} else if (count == 1 && parse_openmeteo_location(root, &out[0])) {
+		parsed = 1;
+	}
 
-done:
 	cJSON_Delete(root);
-	return ok;
+	return parsed;
+}
+
+/**
+ * @brief Choose the interval until the next weather fetch.
+ *
+ * Policy:
+ *  - Fetch failed / first sample          -> CONFIG_WEATHER_POLL_MIN_SEC
+ *  - Precipitation or wind changing fast  -> CONFIG_WEATHER_POLL_MIN_SEC
+ *  - Snapshot unchanged since last fetch  -> double the interval (backoff)
+ *  - Snapshot changed, but not fast       -> halve the interval
+ *
+ * Outside the fast path the next fetch is pushed out to just after the next
+ * provider model slot, so we never fetch data that cannot have changed yet.
+ * The result is always clamped to [MIN, MAX].
+ *
+ * @param prev        Previous successful snapshot (may be invalid).
+ * @param cur         Snapshot just fetched, or NULL if the fetch failed.
+ * @param interval_s  Interval that preceded the fetch that just completed.
+ * @return Interval in seconds until the next fetch.
+ */
+static uint32_t next_poll_interval_s(const weather_current_t *prev,
+									 const weather_current_t *cur,
+									 uint32_t interval_s) {
+	const uint32_t min_s = CONFIG_WEATHER_POLL_MIN_SEC;
+	const uint32_t max_s =
+		(CONFIG_WEATHER_POLL_MAX_SEC > CONFIG_WEATHER_POLL_MIN_SEC)
+			? CONFIG_WEATHER_POLL_MAX_SEC
+			: CONFIG_WEATHER_POLL_MIN_SEC;
+
+	if (!cur || !prev || !prev->valid) {
+		return min_s;
+	}
+
+	float d_precip = fabsf(cur->precipitation_mm - prev->precipitation_mm);
+	float d_wind = fabsf(cur->windspeed_mph - prev->windspeed_mph);
+	if (d_precip >= WEATHER_PRECIP_FAST_MM || d_wind >= WEATHER_WIND_FAST_MPH) {
+		return min_s;
+	}
+
+	/* Same model slot, or a new slot with identical values */
+	bool unchanged = (cur->time_unix == prev->time_unix) ||
+					 (cur->temperature_c == prev->temperature_c &&
+					  cur->humidity_pct == prev->humidity_pct &&
+					  cur->precipitation_mm == prev->precipitation_mm &&
+					  cur->windspeed_mph == prev->windspeed_mph &&
+					  cur->is_day == prev->is_day);
+
+	uint32_t next_s = unchanged ? interval_s * 2 : interval_s / 2;
+	if (next_s < min_s)
+		next_s = min_s;
+	if (next_s > max_s)
+		next_s = max_s;
+
+	/* Align to the provider cadence (needs wall-clock time from SNTP) */
+	if (sntp_service_time_is_set() && cur->update_interval_s > 0) {
+		const int64_t cadence = cur->update_interval_s;
+		const int64_t now = (int64_t)time(NULL);
+		const int64_t base = cur->time_unix + WEATHER_SLOT_SLACK_S;
+		const int64_t target = now + (int64_t)next_s;
+
+		if (target > base) {
+			int64_t aligned =
+				base + ((target - base + cadence - 1) / cadence) * cadence;
+			/* Rounding up would overshoot MAX: take the slot before instead */
+			if (aligned - now > (int64_t)max_s) {
+				aligned -= cadence;
+			}
+			if (aligned - now >= (int64_t)min_s) {
+				next_s = (uint32_t)(aligned - now);
+			}
+		}
+	}
+
+	return next_s;
 }
 
 /**
@@ -131,10 +289,13 @@ done:
  *
  * The task:
  *  - Creates a private reply queue for responses from the HTTP owner task
- *  - Builds an Open-Meteo request URL (JSON output)
+ *  - Builds one Open-Meteo request URL covering every configured location
+ *    (comma-separated coordinates), so N sites cost a single TLS request
  *  - Provides a fixed RX buffer for the response body (no heap allocations)
- *  - Parses the "current" JSON object into a weather_current_t snapshot
- *  - Publishes the snapshot for the UI (mutex-protected)
+ *  - Parses the response array into per-location weather_current_t entries
+ *  - Publishes the snapshot for the UI (seqlock-protected)
+ *  - Picks the next poll interval via next_poll_interval_s(), taking the
+ *    shortest interval any location asks for
  *
  * Notes:
  *  - All HTTP transactions are executed by the http_service owner task.
@@ -142,32 +303,89 @@ done:
  *  - The UI reads data via weather_get_snapshot() and never parses HTTP.
  */
 static void weather_task(void *arg) {
-	double lat = strtod(CONFIG_LOCATION_LATITUDE, NULL);
-	double lon = strtod(CONFIG_LOCATION_LONGITUDE, NULL);
-
-	QueueHandle_t http_q = http_service_queue();
-	QueueHandle_t reply_q = xQueueCreate(2, sizeof(http_resp_t));
+	/* Collect configured (non-blank) locations at startup. */
+	double lat[WEATHER_MAX_LOCATIONS];
+	double lon[WEATHER_MAX_LOCATIONS];
+	int count = 0;
+	for (int i = 0; i < WEATHER_MAX_LOCATIONS; i++) {
+		const char *lat_s = s_configured_locations[i].lat;
+		const char *lon_s = s_configured_locations[i].lon;
+		if (!lat_s || lat_s[0] == '\0' || !lon_s || lon_s[0] == '\0') {
+			continue;
+		}
+		lat[count] = strtod(lat_s, NULL);
+		lon[count] = strtod(lon_s, NULL);
 
-	/* JSON responses are larger than the old CSV format. */
-	static char rx[2048];
+		char name[sizeof(s_weather.locations[0].name)];
+		snprintf(name, sizeof(name), "%s", s_configured_locations[i].name);
+		seqlock_write_begin(&s_weather_sl);
+		memcpy(s_weather.locations[count].name, name, sizeof(name));
+		s_weather.count = count + 1;
+		seqlock_write_end(&s_weather_sl);
+		count++;
+	}
 
-	TickType_t last = xTaskGetTickCount();
-	const TickType_t period = pdMS_TO_TICKS(3 * 60 * 1000);
+	/* Coordinates are fixed, so the batched URL is built once. In range,
+	 * each entry is at most 10 characters ("-180.0000,"); a location whose
+	 * entry would not fit is dropped, together with all after it. */
+	char lat_list[WEATHER_MAX_LOCATIONS * 12];
+	char lon_list[WEATHER_MAX_LOCATIONS * 12];
+	size_t lat_len = 0, lon_len = 0;
+	for (int i = 0; i < count; i++) {
+		int n = snprintf(lat_list + lat_len, sizeof(lat_list) - lat_len,
+						 "%s%.4f", i ? "," : "", lat[i]);
+		int m = snprintf(lon_list + lon_len, sizeof(lon_list) - lon_len,
+						 "%s%.4f", i ? "," : "", lon[i]);
+		if (n < 0 || (size_t)n >= sizeof(lat_list) - lat_len || m < 0 ||
+			(size_t)m >= sizeof(lon_list) - lon_len) {
+			ESP_LOGE(TAG, "location %d does not fit the URL; using %d", i, i);
+			lat_list[lat_len] = '\0';
+			lon_list[lon_len] = '\0';
+			count = i;
+			seqlock_write_begin(&s_weather_sl);
+			s_weather.count = count;
+			seqlock_write_end(&s_weather_sl);
+			break;
+		}
+		lat_len += n;
+		lon_len += m;
+	}
+	data_bus_publish(DATA_TOPIC_WEATHER);
 
-	uint32_t rid = 1;
-	char url[256];
+	if (count == 0) {
+		ESP_LOGW(TAG, "No locations configured; task exiting");
+		vTaskDelete(NULL);
+		return;
+	}
 
-	for (;;) {
+	char url[sizeof(((http_req_t *)0)->url)];
+	int url_len =
 		snprintf(url, sizeof(url),
 				 "https://api.open-meteo.com/v1/forecast"
-				 "?latitude=%.4f&longitude=%.4f"
+				 "?latitude=%s&longitude=%s"
 				 "&current=temperature_2m,relative_humidity_2m,precipitation,"
 				 "windspeed_10m,is_day"
 				 "&timeformat=unixtime"
-				 "&temperature_unit=celsius"
 				 "&wind_speed_unit=mph",
-				 lat, lon);
+				 lat_list, lon_list);
+	if (url_len >= (int)sizeof(url)) {
+		ESP_LOGE(TAG, "request URL truncated (%d bytes)", url_len);
+	}
+
+	QueueHandle_t http_q = http_service_queue();
+	QueueHandle_t reply_q = xQueueCreate(2, sizeof(http_resp_t));
 
+	/* One response body carries every location (~600 bytes each). */
+	static char rx[4096];
+
+	TickType_t last = xTaskGetTickCount();
+	uint32_t interval_s = CONFIG_WEATHER_POLL_MIN_SEC;
+	weather_current_t prev[WEATHER_MAX_LOCATIONS] = {0};
+	weather_current_t parsed[WEATHER_MAX_LOCATIONS];
+
+	uint32_t rid = 1;
+
+	for (;;) {
 		http_req_t req = {0};
 		req.method = HTTP_REQ_GET;
 		req.reply_queue = reply_q;
@@ -176,9 +394,15 @@ static void weather_task(void *arg) {
 		req.rx_cap = sizeof(rx);
 		snprintf(req.url, sizeof(req.url), "%s", url);
 
-		ESP_LOGI(TAG, "enqueue id=%" PRIu32, req.request_id);
+		ESP_LOGI(TAG, "enqueue id=%" PRIu32 " locations=%d", req.request_id,
+				 count);
 		xQueueSend(http_q, &req, portMAX_DELAY);
 
+		int got = 0;
+		for (int i = 0; i < count; i++) {
+			parsed[i].valid = false;
+		}
+
 		http_resp_t resp;
 		if (xQueueReceive(reply_q, &resp, pdMS_TO_TICKS(15000)) == pdTRUE) {
 			ESP_LOGI(TAG, "done id=%" PRIu32 " err=%s http=%d rx=%u trunc=%d",
@@ -189,48 +413,78 @@ static void weather_task(void *arg) {
 			if (resp.err == ESP_OK && resp.http_status == 200 &&
 				resp.rx_len > 0 && !resp.truncated) {
 
-				weather_current_t parsed;
-				if (parse_openmeteo_current_json(rx, &parsed)) {
-					if (xSemaphoreTake(s_weather_mu, pdMS_TO_TICKS(50)) ==
-						pdTRUE) {
-						s_weather = parsed;
-						xSemaphoreGive(s_weather_mu);
+				got = parse_openmeteo_json(rx, parsed, count);
+				if (got > 0) {
+					/* Keep the Kconfig name; parse leaves it unset */
+					for (int i = 0; i < count; i++) {
+						memcpy(parsed[i].name, s_weather.locations[i].name,
+							   sizeof(parsed[i].name));
+					}
+					seqlock_write_begin(&s_weather_sl);
+					for (int i = 0; i < count; i++) {
+						if (parsed[i].valid) {
+							s_weather.locations[i] = parsed[i];
+						}
 					}
+					seqlock_write_end(&s_weather_sl);
+					data_bus_publish(DATA_TOPIC_WEATHER);
 
-					ESP_LOGI(TAG,
-							 "updated: %.1fC hum=%d%% wind=%.1fmph rain=%.2fmm "
-							 "day=%d",
-							 parsed.temperature_c, parsed.humidity_pct,
-							 parsed.windspeed_mph, parsed.precipitation_mm,
-							 (int)parsed.is_day);
-				} else {
-					ESP_LOGW(TAG, "JSON parse failed");
+					for (int i = 0; i < count; i++) {
+						if (!parsed[i].valid) {
+							continue;
+						}
+						ESP_LOGI(TAG,
+								 "updated[%d]: %.1fC hum=%d%% wind=%.1fmph "
+								 "rain=%.2fmm day=%d",
+								 i, parsed[i].temperature_c,
+								 parsed[i].humidity_pct,
+								 parsed[i].windspeed_mph,
+								 parsed[i].precipitation_mm,
+								 (int)parsed[i].is_day);
+					}
+				}
+				if (got < count) {
+					ESP_LOGW(TAG, "JSON parse failed for %d of %d locations",
+							 count - got, count);
 				}
 			}
 		} else {
 			ESP_LOGW(TAG, "timeout waiting for response");
 		}
 
-		vTaskDelayUntil(&last, period);
+		/* The most volatile location drives the shared poll interval. */
+		uint32_t next_s = 0;
+		for (int i = 0; i < count; i++) {
+			uint32_t loc_s = next_poll_interval_s(
+				&prev[i], parsed[i].valid ? &parsed[i] : NULL, interval_s);
+			if (next_s == 0 || loc_s < next_s) {
+				next_s = loc_s;
+			}
+			if (parsed[i].valid) {
+				prev[i] = parsed[i];
+			}
+		}
+		interval_s = next_s ? next_s : CONFIG_WEATHER_POLL_MIN_SEC;
+		s_poll_interval_s = interval_s;
+		ESP_LOGI(TAG, "next poll in %" PRIu32 " s", interval_s);
+
+		vTaskDelayUntil(&last, pdMS_TO_TICKS(interval_s * 1000U));
 	}
 }
 
 /**
  * @brief Start the weather task and initialize shared state.
  *
- * Creates the mutex guarding the shared weather snapshot and launches the
- * periodic weather polling task.
+ * Clears the shared weather snapshot and launches the periodic weather
+ * polling task.
  *
  * Notes:
  *  - The snapshot remains invalid until the first successful fetch+parse.
  */
 void weather_task_start(void) {
-	if (!s_weather_mu) {
-		s_weather_mu = xSemaphoreCreateMutex();
-	}
-
+	seqlock_write_begin(&s_weather_sl);
 	memset(&s_weather, 0, sizeof(s_weather));
-	s_weather.valid = false;
+	seqlock_write_end(&s_weather_sl);
 
 	xTaskCreatePinnedToCore(weather_task, "weather", 4096, NULL, 5, NULL, 0);
 }
@@ -7,8 +7,10 @@
 extern "C" {
 #endif
 
+#define WEATHER_MAX_LOCATIONS 3
+
 /**
- * @brief UI-facing weather snapshot.
+ * @brief UI-facing weather snapshot for a single location.
  *
  * This structure is the "model" consumed by the UI. It contains only the
  * fields the UI needs and a validity flag.
@@ -18,16 +20,35 @@ extern "C" {
  *  - valid becomes true after the first successful update.
  */
 typedef struct {
+	char name[16]; /* location label from Kconfig (e.g. "Home") */
 	int64_t time_unix;
 	float temperature_c;
 	int humidity_pct;
 	float precipitation_mm;
 	float windspeed_mph;
 	bool is_day;
+	int update_interval_s; /* provider model cadence ("current.interval") */
 
 	bool valid; /* true once we have a good parse */
 } weather_current_t;
 
+/**
+ * @brief Snapshot of all configured weather locations.
+ *
+ * count reflects the number of locations with coordinates set in Kconfig.
+ * All locations are fetched in a single Open-Meteo request, so entries are
+ * normally updated together. Entries beyond count are zeroed.
+ *
+ * generation counts the updates published before the copy was taken; a
+ * reader can compare it with its previous copy to see whether anything
+ * changed.
+ */
+typedef struct {
+	weather_current_t locations[WEATHER_MAX_LOCATIONS];
+	int count;
+	uint32_t generation; /* set by weather_get_snapshot() */
+} weather_snapshot_t;
+
 /**
  * @brief Start the weather polling task.
  */
@@ -37,13 +58,26 @@ void weather_task_start(void);
  * @brief Copy out the latest weather snapshot for the UI.
  *
  * @param[out] out Destination struct to receive the snapshot.
- * @return true if snapshot is valid, false otherwise.
+ * @return true if at least one location is valid, false otherwise.
  *
  * Notes:
  *  - Returns false until at least one successful fetch+parse has completed.
  *  - The returned data is a copy; the UI holds no pointers into task memory.
+ *  - Never blocks: the copy is retried if it overlapped an update, so *out
+ *    is always filled in, even when returning false.
+ */
+bool weather_get_snapshot(weather_snapshot_t *out);
+
+/**
+ * @brief Return the poll interval chosen for the next weather fetch.
+ *
+ * The weather task adapts its interval between CONFIG_WEATHER_POLL_MIN_SEC
+ * and CONFIG_WEATHER_POLL_MAX_SEC; this exposes the current choice as a
+ * metric for logs/diagnostics.
+ *
+ * @return Interval in seconds (0 before the first fetch has completed).
  */
-bool weather_get_snapshot(weather_current_t *out);
+uint32_t weather_get_poll_interval_s(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,230 @@
+/*
+ * Raw history compression (history_codec.c) on a day of 1 Hz readings per
+ * channel, stored as in history_store.c: 512-byte blocks.
+ *
+ * Without arguments the traces are synthetic, shaped after SHT40 and SGP30
+ * output as the sampler stores it (fixed-point, see history_store.h): a
+ * daily swing, sensor noise, occupancy episodes for eCO2/TVOC, and the odd
+ * late or missed sample. Recorded traces can be given instead, one file
+ * per channel with a "t_s,value" line per sample:
+ *
+ *   bench_history_codec temp.csv rh.csv eco2.csv tvoc.csv
+ *
+ * Decode speed is host wall clock; the bytes are exact.
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "history_codec.h"
+#include "history_store.h"
+#include "host_test.h"
+
+HOST_TEST_STATE;
+
+#define TRACE_LEN (24 * 3600)
+#define BLOCK_BYTES HISTORY_RAW_BLOCK_BYTES
+#define MAX_BLOCKS (TRACE_LEN / 8)
+#define DECODE_ROUNDS 20
+
+/* An uncompressed raw point before the codec (history_point_t). */
+#define POINT_BYTES ((int)sizeof(history_point_t))
+
+typedef struct {
+	const char *name;
+	int32_t (*value)(uint32_t i);
+} trace_t;
+
+static uint32_t s_rng = 0x12345678u;
+
+static uint32_t rng_next(void) {
+	s_rng ^= s_rng << 13;
+	s_rng ^= s_rng >> 17;
+	s_rng ^= s_rng << 5;
+	return s_rng;
+}
+
+/** Roughly normal noise with standard deviation sd (sum of uniforms). */
+static double noise(double sd) {
+	double s = 0;
+	for (int k = 0; k < 4; k++)
+		s += (double)(rng_next() & 0xFFFF) / 65536.0 - 0.5;
+	return s * sd * sqrt(3.0);
+}
+
+static double daily(uint32_t i, double mean, double amplitude) {
+	return mean + amplitude * sin(2 * M_PI * i / (24.0 * 3600));
+}
+
+/** People in the room from 09:00 to 18:00 with a lunch break. */
+static bool occupied(uint32_t i) {
+	uint32_t h = i / 3600;
+	return (h >= 9 && h < 12) || (h >= 13 && h < 18);
+}
+
+/* SHT40, 0.01 degC: ~21.5 degC with a 2 degC swing, 0.02 degC noise */
+static int32_t sht40_temp(uint32_t i) {
+	return (int32_t)lround(daily(i, 21.5, 2.0) * 100 + noise(2.0));
+}
+
+/* SHT40, 0.01 %RH: 45 %RH, 6 %RH swing, 0.08 %RH noise */
+static int32_t sht40_rh(uint32_t i) {
+	return (int32_t)lround(daily(i + 6 * 3600, 45.0, 6.0) * 100 + noise(8.0));
+}
+
+/* SGP30 eCO2, ppm: 400 baseline, rising towards 1100 while occupied */
+static int32_t sgp30_eco2(uint32_t i) {
+	static double level = 400;
+	double target = occupied(i) ? 1100 : 400;
+	level += (target - level) / 1800;
+	int32_t v = (int32_t)lround(level + noise(6.0));
+	return v < 400 ? 400 : v;
+}
+
+/* SGP30 TVOC, ppb: near zero, with cooking/cleaning spikes */
+static int32_t sgp30_tvoc(uint32_t i) {
+	static double level = 5;
+	if (rng_next() % 7200 == 0)
+		level += 300 + rng_next() % 900;
+	level += (5 - level) / 900;
+	int32_t v = (int32_t)lround(level + noise(3.0));
+	return v < 0 ? 0 : v;
+}
+
+static const trace_t s_traces[] = {
+	{"SHT40 temperature", sht40_temp},
+	{"SHT40 humidity", sht40_rh},
+	{"SGP30 eCO2", sgp30_eco2},
+	{"SGP30 TVOC", sgp30_tvoc},
+};
+
+static uint32_t s_t[TRACE_LEN], s_t2[TRACE_LEN];
+static int32_t s_v[TRACE_LEN], s_v2[TRACE_LEN];
+static uint8_t s_blocks[MAX_BLOCKS][BLOCK_BYTES];
+static size_t s_block_len[MAX_BLOCKS];
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** 1 Hz, with one sample in 200 late by a second and one in 1000 missed. */
+static void make_trace(const trace_t *tr) {
+	uint32_t t = HISTORY_BOOT_T_S;
+	for (uint32_t i = 0; i < TRACE_LEN; i++) {
+		uint32_t r = rng_next() % 1000;
+		t += r < 5 ? 2 : r < 6 ? 3 : 1;
+		s_t[i] = t;
+		s_v[i] = tr->value(i);
+	}
+}
+
+/**
+ * @brief Read a recorded trace: "t_s,value" per line, '#' comments.
+ *
+ * @return Samples read (at most TRACE_LEN), 0 if the file cannot be read.
+ */
+static uint32_t load_trace(const char *path) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return 0;
+	}
+	char line[128];
+	uint32_t n = 0;
+	while (n < TRACE_LEN && fgets(line, sizeof(line), f)) {
+		uint32_t t;
+		int32_t v;
+		if (line[0] != '#' &&
+			sscanf(line, "%" SCNu32 ",%" SCNd32, &t, &v) == 2) {
+			s_t[n] = t;
+			s_v[n++] = v;
+		}
+	}
+	fclose(f);
+	return n;
+}
+
+/** Fill blocks as the store does; returns the number used. */
+static int encode_blocks(uint32_t len) {
+	int n = 0;
+	uint32_t done = 0;
+	while (done < len && n < MAX_BLOCKS) {
+		uint32_t taken = 0;
+		s_block_len[n] =
+			history_block_encode(&s_t[done], &s_v[done], len - done,
+								 s_blocks[n], BLOCK_BYTES, &taken);
+		done += taken;
+		n++;
+	}
+	CHECK_EQ(done, len);
+	return n;
+}
+
+static uint32_t decode_blocks(int n, uint32_t len) {
+	uint32_t done = 0;
+	for (int b = 0; b < n; b++) {
+		done += history_block_decode(s_blocks[b], s_block_len[b], &s_t2[done],
+									 &s_v2[done], len - done);
+	}
+	return done;
+}
+
+/**
+ * @brief Compress s_t/s_v[0..len) into blocks, check it, print one row.
+ *
+ * @return Bytes per sample.
+ */
+static double measure(const char *name, uint32_t len) {
+	// Whole blocks, as the store allocates them
+	int blocks = encode_blocks(len);
+	size_t bytes = (size_t)blocks * BLOCK_BYTES;
+
+	// Exact round trip
+	CHECK_EQ(decode_blocks(blocks, len), len);
+	CHECK(memcmp(s_t, s_t2, len * sizeof(s_t[0])) == 0);
+	CHECK(memcmp(s_v, s_v2, len * sizeof(s_v[0])) == 0);
+
+	double t0 = now_ns();
+	for (int r = 0; r < DECODE_ROUNDS; r++)
+		(void)decode_blocks(blocks, len);
+	double ns = (now_ns() - t0) / DECODE_ROUNDS;
+
+	double per = (double)bytes / len;
+	printf("%-18s %8zu %7.2f %7.1f %7.1fx %7d %9.1f\n", name, bytes, per,
+		   per * 8, POINT_BYTES / per, blocks, len / ns * 1e3);
+	return per;
+}
+
+int main(int argc, char **argv) {
+	printf("%-18s %8s %7s %7s %8s %7s %9s\n", "trace", "bytes", "B/smpl",
+		   "bits", "vs pt", "blocks", "dec Ms/s");
+
+	if (argc > 1) {
+		for (int k = 1; k < argc; k++) {
+			uint32_t len = load_trace(argv[k]);
+			CHECK(len > 0);
+			if (len > 0)
+				(void)measure(argv[k], len);
+		}
+		printf("('vs pt' compares with a %d-byte uncompressed point)\n",
+			   POINT_BYTES);
+		return host_test_result("bench_history_codec");
+	}
+
+	for (size_t k = 0; k < sizeof(s_traces) / sizeof(s_traces[0]); k++) {
+		make_trace(&s_traces[k]);
+
+		// Far below a bare (timestamp, value) pair
+		CHECK(measure(s_traces[k].name, TRACE_LEN) < 4.0);
+	}
+
+	printf("(synthetic traces, 24 h at 1 Hz; 'vs pt' compares with a %d-byte "
+		   "uncompressed point)\n",
+		   POINT_BYTES);
+	return host_test_result("bench_history_codec");
+}
@@ -0,0 +1,244 @@
+/*
+ * Simulated-bus benchmark: end-to-end sample latency, jitter, throughput
+ * and bus occupancy as the number of devices on one bus grows.
+ *
+ * Every device has a requester task that samples back to back (submit,
+ * wait for the reply, repeat), so the bus is saturated. Two buses run the
+ * same load side by side:
+ *  - port A: the owner task (port_i2c_service.c), which parks requests
+ *    while their device converts
+ *  - port B: a blocking owner that runs port_i2c_xfer() per request and so
+ *    holds the bus through every conversion (the pre-pipelining design)
+ *
+ * Time is simulated (sim_rtos.c), so results do not depend on the host.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "esp_timer.h"
+#include "host_test.h"
+#include "port_i2c.h"
+#include "port_i2c_service.h"
+#include "port_i2c_sim.h"
+#include "port_i2c_stats.h"
+#include "sim_rtos.h"
+
+HOST_TEST_STATE;
+
+#define BENCH_WARMUP_MS 1000
+#define BENCH_WINDOW_MS 10000
+
+/* Request timeout per bus operation, as the default retry policy. */
+#define BENCH_OP_TIMEOUT_MS 20
+
+/* Requesters run below the owners, like the sensor sampler. */
+#define BENCH_REQUESTER_PRIO 5
+
+/**
+ * @brief One simulated device and how it is sampled (as the drivers do).
+ */
+typedef struct {
+	uint8_t addr;
+	uint32_t scl_hz;
+	uint16_t cmd;
+	uint8_t cmd_len;
+	TickType_t conv_ticks;
+	const char *name;
+} bench_dev_t;
+
+/* Added in this order as the device count grows. */
+static const bench_dev_t s_devs[] = {
+	{0x44, 400000, 0xFD, 1, pdMS_TO_TICKS(9) + 1, "SHT40"},
+	{0x58, 100000, 0x2008, 2, pdMS_TO_TICKS(30), "SGP30"},
+	{0x45, 400000, 0xFD, 1, pdMS_TO_TICKS(9) + 1, "SHT40"},
+	{0x46, 400000, 0xFD, 1, pdMS_TO_TICKS(9) + 1, "SHT40"},
+};
+#define BENCH_DEVS ((int)(sizeof(s_devs) / sizeof(s_devs[0])))
+
+/** Latency accumulator for one requester. */
+typedef struct {
+	uint32_t n;
+	uint32_t errors;
+	double sum_us;
+	double sum_sq_us;
+	int64_t max_us;
+} lat_acc_t;
+
+typedef struct {
+	i2c_master_dev_handle_t dev;
+	const bench_dev_t *cfg;
+	QueueHandle_t submit_q; ///< NULL = port_i2c_service_submit()
+	QueueHandle_t reply_q;
+	lat_acc_t lat;
+} requester_t;
+
+static requester_t s_pipelined[BENCH_DEVS];
+static requester_t s_blocking[BENCH_DEVS];
+
+/* Measurement window: samples submitted inside it are counted. */
+static bool s_measuring;
+static int64_t s_window_start_us;
+
+/* Blocking owner: requests and the time it held the bus. */
+static QueueHandle_t s_blocking_q;
+static int64_t s_blocking_busy_us;
+
+static void lat_add(lat_acc_t *a, int64_t us, esp_err_t err) {
+	if (err != ESP_OK) {
+		a->errors++;
+		return;
+	}
+	a->n++;
+	a->sum_us += (double)us;
+	a->sum_sq_us += (double)us * (double)us;
+	if (us > a->max_us)
+		a->max_us = us;
+}
+
+static void requester_task(void *arg) {
+	requester_t *r = arg;
+	uint8_t rx[6];
+	uint32_t id = 0;
+
+	for (;;) {
+		port_i2c_req_t req = {
+			.request_id = ++id,
+			.cmd = r->cfg->cmd,
+			.cmd_len = r->cfg->cmd_len,
+			.rx = rx,
+			.rx_len = sizeof(rx),
+			.post_cmd_delay_ticks = r->cfg->conv_ticks,
+			.dev = r->dev,
+			.reply_queue = r->reply_q,
+		};
+		int64_t t0 = esp_timer_get_time();
+		if (r->submit_q) {
+			req.submit_us = t0;
+			(void)xQueueSend(r->submit_q, &req, portMAX_DELAY);
+		} else {
+			(void)port_i2c_service_submit(&req, portMAX_DELAY);
+		}
+
+		port_i2c_resp_t resp;
+		(void)xQueueReceive(r->reply_q, &resp, portMAX_DELAY);
+		if (s_measuring && t0 >= s_window_start_us)
+			lat_add(&r->lat, esp_timer_get_time() - t0, resp.err);
+	}
+}
+
+/**
+ * @brief Owner without pipelining: one blocking transfer per request.
+ */
+static void blocking_owner_task(void *arg) {
+	const port_i2c_io_t *io = arg;
+	port_i2c_req_t req;
+
+	for (;;) {
+		(void)xQueueReceive(s_blocking_q, &req, portMAX_DELAY);
+		port_i2c_resp_t resp = {.request_id = req.request_id};
+		int64_t t0 = esp_timer_get_time();
+		resp.err = port_i2c_xfer(io, &req, &resp, BENCH_OP_TIMEOUT_MS);
+		if (s_measuring)
+			s_blocking_busy_us += esp_timer_get_time() - t0;
+		(void)xQueueSend(req.reply_queue, &resp, portMAX_DELAY);
+	}
+}
+
+static void start_requester(requester_t *r, i2c_master_dev_handle_t dev,
+							const bench_dev_t *cfg, QueueHandle_t submit_q) {
+	r->dev = dev;
+	r->cfg = cfg;
+	r->submit_q = submit_q;
+	r->reply_q = xQueueCreate(1, sizeof(port_i2c_resp_t));
+	(void)xTaskCreatePinnedToCore(requester_task, "requester", 4096, r,
+								  BENCH_REQUESTER_PRIO, NULL, 1);
+}
+
+/** Sum the requesters of one bus into a table row. */
+static double print_row(const char *mode, int n, const requester_t *rs,
+						double busy_pct) {
+	lat_acc_t all = {0};
+	for (int i = 0; i < n; i++) {
+		all.n += rs[i].lat.n;
+		all.errors += rs[i].lat.errors;
+		all.sum_us += rs[i].lat.sum_us;
+		all.sum_sq_us += rs[i].lat.sum_sq_us;
+		if (rs[i].lat.max_us > all.max_us)
+			all.max_us = rs[i].lat.max_us;
+	}
+	double mean = all.n ? all.sum_us / all.n : 0;
+	double var = all.n ? all.sum_sq_us / all.n - mean * mean : 0;
+	double rate = all.n * 1000.0 / BENCH_WINDOW_MS;
+
+	printf("%7d  %-9s  %9.1f  %9.2f  %9.2f  %9.2f  %6.1f  %6u\n", n, mode,
+		   rate, mean / 1000.0, sqrt(var > 0 ? var : 0) / 1000.0,
+		   all.max_us / 1000.0, busy_pct, (unsigned)all.errors);
+	CHECK_EQ(all.errors, 0);
+	return rate;
+}
+
+static void bench_main(void *arg) {
+	(void)arg;
+	const port_i2c_io_t *blocking_io = port_i2c_sim_io(PORT_I2C_PORT_B);
+	s_blocking_q = xQueueCreate(8, sizeof(port_i2c_req_t));
+	(void)xTaskCreatePinnedToCore(blocking_owner_task, "blocking_owner", 4096,
+								  (void *)blocking_io, 6, NULL, 0);
+
+	printf("devices  owner      samples/s  lat mean   jitter     lat max   "
+		   "bus %%   errors\n");
+	printf("                                 (ms)       (ms, sd)   (ms)\n");
+
+	double pipelined_rate = 0;
+	double blocking_rate = 0;
+	for (int n = 1; n <= BENCH_DEVS; n++) {
+		const bench_dev_t *cfg = &s_devs[n - 1];
+		(void)port_i2c_sim_set_present(PORT_I2C_PORT_A, cfg->addr, true);
+		(void)port_i2c_sim_set_present(PORT_I2C_PORT_B, cfg->addr, true);
+
+		i2c_master_dev_handle_t dev = NULL;
+		CHECK_EQ(port_i2c_service_add_device(PORT_I2C_PORT_A, cfg->addr,
+											 cfg->scl_hz, &dev),
+				 ESP_OK);
+		start_requester(&s_pipelined[n - 1], dev, cfg, NULL);
+
+		CHECK_EQ(port_i2c_sim_add_device(PORT_I2C_PORT_B, cfg->addr,
+										 cfg->scl_hz, &dev),
+				 ESP_OK);
+		start_requester(&s_blocking[n - 1], dev, cfg, s_blocking_q);
+
+		/* Let the new requesters settle into the rotation */
+		vTaskDelay(pdMS_TO_TICKS(BENCH_WARMUP_MS));
+		for (int i = 0; i < n; i++) {
+			memset(&s_pipelined[i].lat, 0, sizeof(lat_acc_t));
+			memset(&s_blocking[i].lat, 0, sizeof(lat_acc_t));
+		}
+		port_i2c_stats_reset();
+		s_blocking_busy_us = 0;
+		s_window_start_us = esp_timer_get_time();
+		s_measuring = true;
+
+		vTaskDelay(pdMS_TO_TICKS(BENCH_WINDOW_MS));
+
+		s_measuring = false;
+		port_i2c_bus_stats_t bus;
+		CHECK_EQ(port_i2c_stats_get_bus(PORT_I2C_PORT_A, &bus), ESP_OK);
+		pipelined_rate = print_row("pipelined", n, s_pipelined, bus.busy_pct);
+		blocking_rate =
+			print_row("blocking", n, s_blocking,
+					  s_blocking_busy_us * 100.0 / (BENCH_WINDOW_MS * 1000.0));
+	}
+
+	/* Conversions overlap, so throughput must scale past the baseline */
+	CHECK(pipelined_rate > 1.5 * blocking_rate);
+}
+
+int main(void) {
+	sim_rtos_run(bench_main, NULL);
+	return host_test_result("bench_port_i2c_sim");
+}
@@ -0,0 +1,129 @@
+/*
+ * Sensirion CRC-8: the table-driven sensirion_crc8() and frame decoder
+ * against the bit-by-bit loop they replaced.
+ *
+ * Checks that both give the same CRC for every 16-bit word, then times
+ * them on the host (wall clock, so figures vary between machines; the
+ * ratio is what matters).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "host_test.h"
+#include "sensirion_utils.h"
+
+HOST_TEST_STATE;
+
+#define BENCH_WORDS (20 * 1000 * 1000)
+#define BENCH_FRAMES (10 * 1000 * 1000)
+
+/* Reference: the original bitwise CRC (polynomial 0x31, init 0xFF). */
+__attribute__((noinline)) static uint8_t crc8_bitwise(const uint8_t *data,
+													   int len) {
+	uint8_t crc = 0xFF;
+
+	for (int i = 0; i < len; i++) {
+		crc ^= data[i];
+
+		for (int bit = 0; bit < 8; bit++) {
+			if (crc & 0x80)
+				crc = (uint8_t)((crc << 1) ^ 0x31);
+			else
+				crc <<= 1;
+		}
+	}
+
+	return crc;
+}
+
+/* Reference decoder: per-word CRC with the bitwise loop, as drivers did. */
+__attribute__((noinline)) static int
+decode_bitwise(const uint8_t *frame, uint16_t *words, int n) {
+	for (int i = 0; i < n; i++) {
+		const uint8_t *w = &frame[i * SENSIRION_WORD_SIZE];
+		if (crc8_bitwise(w, 2) != w[2])
+			return i;
+		words[i] = (uint16_t)((w[0] << 8) | w[1]);
+	}
+	return -1;
+}
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static volatile uint32_t s_sink;
+
+static double time_crc(uint8_t (*crc)(const uint8_t *, int)) {
+	uint32_t acc = 0;
+	double t0 = now_ns();
+	for (uint32_t i = 0; i < BENCH_WORDS; i++) {
+		const uint8_t w[2] = {(uint8_t)(i >> 8), (uint8_t)(i ^ acc)};
+		acc += crc(w, 2);
+	}
+	double dt = now_ns() - t0;
+	s_sink = acc;
+	return dt / BENCH_WORDS;
+}
+
+/** SGP30 measure-IAQ frame: two words with their CRCs. */
+static void make_frame(uint32_t i, uint8_t frame[6]) {
+	const uint16_t words[2] = {(uint16_t)(400 + (i & 0x3FF)),
+							   (uint16_t)(i & 0xFF)};
+	(void)sensirion_encode_words(words, 2, frame, 6);
+}
+
+static double time_decode(bool table) {
+	uint8_t frames[64][6];
+	for (uint32_t i = 0; i < 64; i++)
+		make_frame(i, frames[i]);
+
+	uint32_t acc = 0;
+	double t0 = now_ns();
+	for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+		uint16_t words[2];
+		const uint8_t *f = frames[i & 63];
+		if (table)
+			acc += sensirion_decode_words(f, 6, words, 2, NULL);
+		else
+			acc += (uint32_t)decode_bitwise(f, words, 2);
+		acc += words[0];
+	}
+	double dt = now_ns() - t0;
+	s_sink = acc;
+	return dt / BENCH_FRAMES;
+}
+
+int main(void) {
+	/* Datasheet example (SHT4x/SGP30): CRC(0xBEEF) = 0x92 */
+	const uint8_t beef[2] = {0xBE, 0xEF};
+	CHECK_EQ(sensirion_crc8(beef, 2), 0x92);
+	CHECK_EQ(crc8_bitwise(beef, 2), 0x92);
+
+	int mismatches = 0;
+	for (uint32_t v = 0; v <= 0xFFFF; v++) {
+		const uint8_t w[2] = {(uint8_t)(v >> 8), (uint8_t)v};
+		mismatches += sensirion_crc8(w, 2) != crc8_bitwise(w, 2);
+	}
+	CHECK_EQ(mismatches, 0);
+
+	double crc_table = time_crc(sensirion_crc8);
+	double crc_bits = time_crc(crc8_bitwise);
+	double dec_table = time_decode(true);
+	double dec_bits = time_decode(false);
+
+	printf("                       table     bitwise   speedup\n");
+	printf("crc8, ns/word        %7.2f     %7.2f     x%.1f\n", crc_table,
+		   crc_bits, crc_bits / crc_table);
+	printf("decode, ns/frame     %7.2f     %7.2f     x%.1f\n", dec_table,
+		   dec_bits, dec_bits / dec_table);
+	printf("(2-word frames, %d words / %d frames per run)\n", BENCH_WORDS,
+		   BENCH_FRAMES);
+
+	return host_test_result("bench_sensirion_crc");
+}
@@ -0,0 +1,413 @@
+/*
+ * UI render cost: ui.c, the tile modules and the change-only setters built
+ * against LVGL 8, drawing into a 320x240 framebuffer in memory through the
+ * device's 20-line double buffer.
+ *
+ * Each tile is shown in turn and fed a generated sequence of snapshots, one
+ * frame per simulated second, the way ui_task does it: the time labels and
+ * the shown tile's update under the display lock, then one LVGL refresh.
+ * Three sequences per tile:
+ *  - idle:    nothing changes, so nothing may be redrawn
+ *  - typical: the clock ticks, readings drift, stocks move every minute and
+ *             the weather every three
+ *  - worst:   every value label changes every frame, band and day/night
+ *             colours included
+ *
+ * Per tile and sequence: the update and render time (host wall clock, so it
+ * varies by machine), the pixels LVGL re-rendered (the monitor callback's
+ * invalidated area), and the flushes to the display. The run ends with
+ * lv_mem_monitor()'s peak. A table goes to stdout; the same figures as JSON
+ * go to the file given on the command line (default ui_render.json), so
+ * runs can be compared between builds:
+ *
+ *   bench_ui_render [report.json]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "lvgl.h"
+
+#include "bsp/m5stack_core_s3.h"
+#include "host_test.h"
+#include "ui.h"
+#include "ui_screens.h"
+
+HOST_TEST_STATE;
+
+#define BENCH_FRAMES 300
+#define BENCH_BUF_LINES 20
+
+/* Local time of the first frame: Tue 2026-03-10 09:41:00 */
+#define BENCH_T0 1773135660
+
+typedef enum {
+	SEQ_IDLE = 0,
+	SEQ_TYPICAL,
+	SEQ_WORST,
+	SEQ_COUNT,
+} seq_t;
+
+static const char *const s_seq_names[SEQ_COUNT] = {"idle", "typical",
+												   "worst"};
+static const char *const s_tile_names[UI_TILE_COUNT] = {"clock", "stats",
+														"weather", "stocks"};
+
+/** One tile under one sequence. */
+typedef struct {
+	double update_ns;
+	double render_ns;
+	double render_max_ns;
+	uint64_t px;
+	uint32_t flushes;
+	uint32_t mem_peak; ///< lv_mem_monitor() max_used after the run
+} result_t;
+
+static result_t s_results[UI_TILE_COUNT][SEQ_COUNT];
+
+/* -------------------------------------------------------------------------- */
+/* Display                                                                    */
+/* -------------------------------------------------------------------------- */
+
+static lv_color_t s_fb[BSP_LCD_V_RES][BSP_LCD_H_RES];
+static lv_color_t s_buf[2][BSP_LCD_H_RES * BENCH_BUF_LINES];
+
+/* Counted by the callbacks during one refresh */
+static uint32_t s_refr_px;
+static uint32_t s_refr_flushes;
+
+static void fb_flush(lv_disp_drv_t *drv, const lv_area_t *area,
+					 lv_color_t *px) {
+	int32_t w = area->x2 - area->x1 + 1;
+	for (int32_t y = area->y1; y <= area->y2; y++) {
+		memcpy(&s_fb[y][area->x1], px, w * sizeof(lv_color_t));
+		px += w;
+	}
+	s_refr_flushes++;
+	lv_disp_flush_ready(drv);
+}
+
+static void fb_monitor(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px) {
+	(void)drv;
+	(void)time_ms;
+	s_refr_px += px;
+}
+
+static lv_disp_t *display_start(void) {
+	static lv_disp_draw_buf_t draw_buf;
+	static lv_disp_drv_t drv;
+
+	lv_disp_draw_buf_init(&draw_buf, s_buf[0], s_buf[1],
+						  BSP_LCD_H_RES * BENCH_BUF_LINES);
+	lv_disp_drv_init(&drv);
+	drv.hor_res = BSP_LCD_H_RES;
+	drv.ver_res = BSP_LCD_V_RES;
+	drv.draw_buf = &draw_buf;
+	drv.flush_cb = fb_flush;
+	drv.monitor_cb = fb_monitor;
+	return lv_disp_drv_register(&drv);
+}
+
+/* Nested or unbalanced locking would deadlock on the device */
+static int s_lock_depth;
+
+bool bsp_display_lock(uint32_t timeout_ms) {
+	(void)timeout_ms;
+	CHECK_EQ(s_lock_depth, 0);
+	s_lock_depth++;
+	return true;
+}
+
+void bsp_display_unlock(void) {
+	CHECK_EQ(s_lock_depth, 1);
+	s_lock_depth--;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Snapshot sequences                                                         */
+/* -------------------------------------------------------------------------- */
+
+static uint32_t s_rng = 0x2545F491u;
+
+static uint32_t rng_next(void) {
+	s_rng ^= s_rng << 13;
+	s_rng ^= s_rng >> 17;
+	s_rng ^= s_rng << 5;
+	return s_rng;
+}
+
+/** A pseudo-random value in [lo, hi). */
+static float rng_range(float lo, float hi) {
+	return lo + (hi - lo) * (float)(rng_next() % 10000) / 10000.0f;
+}
+
+/** Everything one frame shows. */
+typedef struct {
+	time_t t;
+	float cpu_pct;
+	readings_snapshot_t readings;
+	weather_snapshot_t weather;
+	stocks_snapshot_t stocks;
+} frame_t;
+
+static const char *const s_symbols[STOCKS_MAX_SYMBOLS] = {
+	"AAPL", "MSFT", "NVDA", "AMZN", "GOOG", "TSLA"};
+
+static void frame_first(frame_t *f) {
+	memset(f, 0, sizeof(*f));
+	f->t = BENCH_T0;
+	f->cpu_pct = 12.0f;
+
+	readings_snapshot_t *r = &f->readings;
+	r->sgp30_valid = r->sht40_valid = true;
+	r->temp_c = 21.5f;
+	r->rh_percent = 45.0f;
+	r->eco2_ppm = 650;
+	r->tvoc_ppb = 40;
+
+	weather_current_t *w = &f->weather.locations[0];
+	snprintf(w->name, sizeof(w->name), "Home");
+	w->temperature_c = 8.0f;
+	w->humidity_pct = 70;
+	w->precipitation_mm = 0.0f;
+	w->windspeed_mph = 6.0f;
+	w->is_day = true;
+	w->valid = true;
+	f->weather.count = 1;
+
+	for (int i = 0; i < STOCKS_MAX_SYMBOLS; i++) {
+		stock_quote_t *q = &f->stocks.quotes[i];
+		snprintf(q->symbol, sizeof(q->symbol), "%s", s_symbols[i]);
+		q->price = 100.0f + 40.0f * i;
+		q->change = 0.5f;
+		q->change_pct = 0.4f;
+		q->valid = true;
+	}
+	f->stocks.count = STOCKS_MAX_SYMBOLS;
+}
+
+/** Readings drift, stocks move each minute, weather each three minutes. */
+static void frame_typical(frame_t *f, uint32_t i) {
+	f->t++;
+	f->cpu_pct = 10.0f + (float)(rng_next() % 60) / 10.0f;
+
+	readings_snapshot_t *r = &f->readings;
+	if (rng_next() % 4 == 0)
+		r->temp_c += (rng_next() % 2 ? 0.1f : -0.1f);
+	if (rng_next() % 3 == 0)
+		r->rh_percent += (rng_next() % 2 ? 0.1f : -0.1f);
+	r->eco2_ppm += rng_next() % 5 - 2;
+	if (rng_next() % 8 == 0)
+		r->tvoc_ppb += rng_next() % 3 - 1;
+	r->eco2_band = r->eco2_ppm >= READINGS_ECO2_FAIR_PPM;
+
+	if (i % 60 == 0) {
+		for (int k = 0; k < f->stocks.count; k++) {
+			stock_quote_t *q = &f->stocks.quotes[k];
+			float d = rng_range(-0.8f, 0.8f);
+			q->price += d;
+			q->change += d;
+			q->change_pct = q->change / (q->price - q->change) * 100.0f;
+		}
+	}
+
+	if (i % 180 == 0) {
+		weather_current_t *w = &f->weather.locations[0];
+		w->temperature_c += rng_range(-1.0f, 1.0f);
+		w->humidity_pct += (int)(rng_next() % 5) - 2;
+		w->windspeed_mph = rng_range(2.0f, 12.0f);
+	}
+}
+
+/** Every value label changes, and every colour that can flips. */
+static void frame_worst(frame_t *f, uint32_t i) {
+	f->t += 24 * 3600 + 1; // new date and new second
+	f->cpu_pct = (float)(i % 1000) / 10.0f;
+
+	readings_snapshot_t *r = &f->readings;
+	r->temp_c = rng_range(-10.0f, 40.0f);
+	r->rh_percent = rng_range(5.0f, 95.0f);
+	r->eco2_ppm = 400 + rng_next() % 2000;
+	r->tvoc_ppb = rng_next() % 1000;
+	r->eco2_band = i % 3;
+	r->tvoc_band = (i + 1) % 3;
+
+	weather_current_t *w = &f->weather.locations[0];
+	snprintf(w->name, sizeof(w->name), "Site %u", (unsigned)(i % 100));
+	w->temperature_c = rng_range(-20.0f, 40.0f);
+	w->humidity_pct = (int)(rng_next() % 100);
+	static const float rain_mm[] = {0.0f, 0.5f, 2.0f, 6.0f}; // 0-3 drops
+	w->precipitation_mm = rain_mm[i % 4];
+	w->windspeed_mph = rng_range(0.0f, 60.0f);
+	w->is_day = i % 2;
+
+	for (int k = 0; k < f->stocks.count; k++) {
+		stock_quote_t *q = &f->stocks.quotes[k];
+		q->price = rng_range(10.0f, 900.0f);
+		q->change = rng_range(1.0f, 20.0f) * ((i + k) % 2 ? 1 : -1);
+		q->change_pct = q->change / q->price * 100.0f;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+/* Runs                                                                       */
+/* -------------------------------------------------------------------------- */
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** One ui_task pass for a tile, then one refresh. */
+static void draw_frame(lv_disp_t *disp, ui_tile_t tile, const frame_t *f,
+					   result_t *res) {
+	struct tm now;
+	char time_str[9];
+	gmtime_r(&f->t, &now);
+	strftime(time_str, sizeof(time_str), "%H:%M:%S", &now);
+
+	double t0 = now_ns();
+	bsp_display_lock(0);
+	ui_set_time_str(time_str);
+	switch (tile) {
+	case UI_TILE_CLOCK:
+		ui_clock_update(&now, f->cpu_pct);
+		break;
+	case UI_TILE_STATS:
+		ui_update_readings(&f->readings);
+		break;
+	case UI_TILE_WEATHER:
+		ui_update_weather(&f->weather);
+		break;
+	case UI_TILE_STOCKS:
+		ui_update_stocks(&f->stocks);
+		break;
+	default:
+		break;
+	}
+	bsp_display_unlock();
+	double t1 = now_ns();
+
+	s_refr_px = 0;
+	s_refr_flushes = 0;
+	lv_refr_now(disp);
+	double t2 = now_ns();
+	lv_tick_inc(1000);
+
+	if (!res)
+		return;
+	res->update_ns += t1 - t0;
+	res->render_ns += t2 - t1;
+	if (t2 - t1 > res->render_max_ns)
+		res->render_max_ns = t2 - t1;
+	res->px += s_refr_px;
+	res->flushes += s_refr_flushes;
+}
+
+static void run(lv_disp_t *disp, lv_obj_t *tv, ui_tile_t tile, seq_t seq) {
+	lv_obj_set_tile_id(tv, tile, 0, LV_ANIM_OFF);
+
+	frame_t f;
+	frame_first(&f);
+	// Settle: the first frame draws the tile from its previous contents
+	draw_frame(disp, tile, &f, NULL);
+	draw_frame(disp, tile, &f, NULL);
+
+	result_t *res = &s_results[tile][seq];
+	for (uint32_t i = 1; i <= BENCH_FRAMES; i++) {
+		if (seq == SEQ_TYPICAL)
+			frame_typical(&f, i);
+		else if (seq == SEQ_WORST)
+			frame_worst(&f, i);
+		draw_frame(disp, tile, &f, res);
+	}
+
+	lv_mem_monitor_t mon;
+	lv_mem_monitor(&mon);
+	res->mem_peak = mon.max_used;
+}
+
+static void print_row(ui_tile_t tile, seq_t seq) {
+	const result_t *r = &s_results[tile][seq];
+	printf("%-8s %-8s %9.1f %9.1f %9.1f %10.0f %9.2f\n", s_tile_names[tile],
+		   s_seq_names[seq], r->update_ns / BENCH_FRAMES / 1e3,
+		   r->render_ns / BENCH_FRAMES / 1e3, r->render_max_ns / 1e3,
+		   (double)r->px / BENCH_FRAMES, (double)r->flushes / BENCH_FRAMES);
+}
+
+static void write_json(FILE *out, const lv_mem_monitor_t *mon) {
+	fprintf(out, "{\n  \"lvgl\": \"%d.%d.%d\",\n", LVGL_VERSION_MAJOR,
+			LVGL_VERSION_MINOR, LVGL_VERSION_PATCH);
+	fprintf(out,
+			"  \"display\": {\"width\": %d, \"height\": %d, "
+			"\"buffer_lines\": %d},\n",
+			BSP_LCD_H_RES, BSP_LCD_V_RES, BENCH_BUF_LINES);
+	fprintf(out, "  \"frames\": %d,\n  \"tiles\": {\n", BENCH_FRAMES);
+	for (int t = 0; t < UI_TILE_COUNT; t++) {
+		fprintf(out, "    \"%s\": {\n", s_tile_names[t]);
+		for (int s = 0; s < SEQ_COUNT; s++) {
+			const result_t *r = &s_results[t][s];
+			fprintf(out,
+					"      \"%s\": {\"update_us_avg\": %.1f, "
+					"\"render_us_avg\": %.1f, \"render_us_max\": %.1f, "
+					"\"invalidated_px\": %llu, \"flushes\": %u, "
+					"\"mem_peak_bytes\": %u}%s\n",
+					s_seq_names[s], r->update_ns / BENCH_FRAMES / 1e3,
+					r->render_ns / BENCH_FRAMES / 1e3, r->render_max_ns / 1e3,
+					(unsigned long long)r->px, (unsigned)r->flushes,
+					(unsigned)r->mem_peak, s + 1 < SEQ_COUNT ? "," : "");
+		}
+		fprintf(out, "    }%s\n", t + 1 < UI_TILE_COUNT ? "," : "");
+	}
+	fprintf(out,
+			"  },\n  \"mem_peak_bytes\": %u,\n  \"mem_total_bytes\": %u\n}\n",
+			(unsigned)mon->max_used, (unsigned)mon->total_size);
+}
+
+int main(int argc, char **argv) {
+	const char *json_path = argc > 1 ? argv[1] : "ui_render.json";
+
+	lv_init();
+	lv_disp_t *disp = display_start();
+	CHECK(disp != NULL);
+	CHECK_EQ(ui_init(disp), ESP_OK);
+	CHECK_EQ(s_lock_depth, 0);
+
+	// ui_init() puts the tileview on the active screen
+	lv_obj_t *tv = lv_obj_get_child(lv_scr_act(), 0);
+	lv_refr_now(disp);
+
+	printf("tile     frames   update us render us    max us   px/frame "
+		   "flush/frm\n");
+	for (int t = 0; t < UI_TILE_COUNT; t++) {
+		for (int s = 0; s < SEQ_COUNT; s++) {
+			run(disp, tv, (ui_tile_t)t, (seq_t)s);
+			print_row((ui_tile_t)t, (seq_t)s);
+		}
+
+		const result_t *r = s_results[t];
+		// Change-only setters: an unchanged frame redraws nothing
+		CHECK_EQ(r[SEQ_IDLE].px, 0);
+		CHECK_EQ(r[SEQ_IDLE].flushes, 0);
+		CHECK(r[SEQ_WORST].px > r[SEQ_TYPICAL].px);
+		CHECK(r[SEQ_WORST].flushes > 0);
+	}
+
+	lv_mem_monitor_t mon;
+	lv_mem_monitor(&mon);
+	CHECK(mon.max_used > 0 && mon.max_used < mon.total_size);
+	printf("LVGL heap peak %u of %u bytes (64-bit host: pointers are twice "
+		   "the device's)\n",
+		   (unsigned)mon.max_used, (unsigned)mon.total_size);
+
+	FILE *out = fopen(json_path, "w");
+	CHECK(out != NULL);
+	if (out) {
+		write_json(out, &mon);
+		fclose(out);
+		printf("report: %s\n", json_path);
+	}
+	return host_test_result("bench_ui_render");
+}
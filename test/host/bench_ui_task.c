@@ -0,0 +1,345 @@
+/*
+ * UI task load: the event-driven ui_task.c against the 100 ms polling loop
+ * it replaced, with each tile on screen in turn.
+ *
+ * ui_task.c and the data bus are the firmware's. The screens, snapshot
+ * stores, SNTP and the display lock are fakes that count calls; producers
+ * publish at the default cadences (SGP30 1 s, SHT40 2 s, stocks 60 s,
+ * weather 180 s). The reference loop is the pre-event one: every 100 ms it
+ * copies all three snapshots, samples the CPU and redraws every screen
+ * under the display lock.
+ *
+ * Reported per second: task wakeups, display lock acquisitions, screen
+ * updates (ui_update_* and ui_clock_update) and snapshot copies, plus how
+ * far past the wall-clock second the time label flipped. The fakes cost no
+ * simulated time, so lock hold times are not measured here; on the device
+ * ui_task_get_stats() reports them.
+ *
+ * Time is simulated (sim_rtos.c), so results do not depend on the host.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "bsp/m5stack_core_s3.h"
+#include "data_bus.h"
+#include "esp_timer.h"
+#include "host_test.h"
+#include "sim_rtos.h"
+#include "sntp.h"
+#include "ui.h"
+#include "ui_screens.h"
+#include "ui_task.h"
+
+HOST_TEST_STATE;
+
+#define BENCH_WARMUP_MS 2000
+#define BENCH_WINDOW_MS 60000
+
+/* Wall clock at the simulation's time 0, off the second on purpose. */
+#define BENCH_WALL0_US (1767225600LL * 1000000 + 451000)
+
+/** Calls seen by the fakes in the current window. */
+typedef struct {
+	uint32_t wakeups; ///< Passes (reference loop; ui_visible_tiles() calls)
+	uint32_t locks;
+	uint32_t updates;
+	uint32_t snapshots;
+	uint32_t flips; ///< Time label changes
+	int64_t lag_acc_us;
+	int64_t lag_max_us;
+	uint32_t skipped; ///< Seconds the label never showed
+} bench_acc_t;
+
+static bench_acc_t s_acc;
+static bool s_measuring;
+static uint32_t s_visible;
+static volatile bool s_ref_stop;
+
+static readings_snapshot_t s_readings;
+static weather_snapshot_t s_weather;
+static stocks_snapshot_t s_stocks;
+
+static char s_time_shown[9];
+static int64_t s_second_shown = -1;
+
+/* -------------------------------------------------------------------------- */
+/* Wall clock and SNTP                                                        */
+/* -------------------------------------------------------------------------- */
+
+static int64_t wall_us(void) {
+	return BENCH_WALL0_US + esp_timer_get_time();
+}
+
+/* Replaces the C library's: the wall clock runs on simulated time. */
+int gettimeofday(struct timeval *restrict tv, void *restrict tz) {
+	(void)tz;
+	int64_t now = wall_us();
+	tv->tv_sec = (time_t)(now / 1000000);
+	tv->tv_usec = (suseconds_t)(now % 1000000);
+	return 0;
+}
+
+esp_err_t sntp_service_get_local_timeinfo(struct tm *out) {
+	time_t t = (time_t)(wall_us() / 1000000);
+	return gmtime_r(&t, out) ? ESP_OK : ESP_FAIL;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Snapshot stores                                                            */
+/* -------------------------------------------------------------------------- */
+
+void readings_get_snapshot(readings_snapshot_t *out) {
+	if (s_measuring)
+		s_acc.snapshots++;
+	*out = s_readings;
+}
+
+bool weather_get_snapshot(weather_snapshot_t *out) {
+	if (s_measuring)
+		s_acc.snapshots++;
+	*out = s_weather;
+	return true;
+}
+
+bool stocks_get_snapshot(stocks_snapshot_t *out) {
+	if (s_measuring)
+		s_acc.snapshots++;
+	*out = s_stocks;
+	return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Display lock and screens                                                   */
+/* -------------------------------------------------------------------------- */
+
+bool bsp_display_lock(uint32_t timeout_ms) {
+	(void)timeout_ms;
+	if (s_measuring)
+		s_acc.locks++;
+	return true;
+}
+
+void bsp_display_unlock(void) {}
+
+uint32_t ui_visible_tiles(void) {
+	if (s_measuring)
+		s_acc.wakeups++;
+	return s_visible;
+}
+
+/** Only a shown time label counts; lag is measured from the second. */
+void ui_set_time_str(const char *hhmmss) {
+	if (!(s_visible & ((1u << UI_TILE_CLOCK) | (1u << UI_TILE_STATS))) ||
+		strcmp(hhmmss, s_time_shown) == 0)
+		return;
+	snprintf(s_time_shown, sizeof(s_time_shown), "%s", hhmmss);
+
+	int64_t now = wall_us();
+	int64_t second = now / 1000000;
+	if (s_measuring) {
+		int64_t lag = now % 1000000;
+		s_acc.flips++;
+		s_acc.lag_acc_us += lag;
+		if (lag > s_acc.lag_max_us)
+			s_acc.lag_max_us = lag;
+		if (s_second_shown >= 0 && second > s_second_shown + 1)
+			s_acc.skipped += (uint32_t)(second - s_second_shown - 1);
+	}
+	s_second_shown = second;
+}
+
+static void count_update(void) {
+	if (s_measuring)
+		s_acc.updates++;
+}
+
+void ui_update_readings(const readings_snapshot_t *snapshot) {
+	(void)snapshot;
+	count_update();
+}
+
+void ui_update_weather(const weather_snapshot_t *w) {
+	(void)w;
+	count_update();
+}
+
+void ui_update_stocks(const stocks_snapshot_t *s) {
+	(void)s;
+	count_update();
+}
+
+void ui_clock_update(const struct tm *now, float cpu_pct) {
+	(void)now;
+	(void)cpu_pct;
+	count_update();
+}
+
+float ui_clock_sample_cpu(void) {
+	return 12.5f;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Producers                                                                  */
+/* -------------------------------------------------------------------------- */
+
+typedef struct {
+	uint32_t phase_ms;
+	uint32_t period_ms;
+	uint32_t topic;
+} producer_t;
+
+static const producer_t s_producers[] = {
+	{130, 1000, DATA_TOPIC_READINGS},  // SGP30
+	{710, 2000, DATA_TOPIC_READINGS},  // SHT40
+	{4300, 60000, DATA_TOPIC_STOCKS},  // Finnhub
+	{9100, 180000, DATA_TOPIC_WEATHER}, // Open-Meteo
+};
+
+/** Publish like a producer: update the store, then the topic. */
+static void producer_task(void *arg) {
+	const producer_t *p = arg;
+	vTaskDelay(pdMS_TO_TICKS(p->phase_ms));
+	TickType_t last = xTaskGetTickCount();
+	for (;;) {
+		switch (p->topic) {
+		case DATA_TOPIC_READINGS:
+			s_readings.generation++;
+			break;
+		case DATA_TOPIC_WEATHER:
+			s_weather.generation++;
+			break;
+		case DATA_TOPIC_STOCKS:
+			s_stocks.generation++;
+			break;
+		}
+		data_bus_publish(p->topic);
+		vTaskDelayUntil(&last, pdMS_TO_TICKS(p->period_ms));
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+/* Reference loop                                                             */
+/* -------------------------------------------------------------------------- */
+
+/** The loop before the data bus: poll and redraw everything every 100 ms. */
+static void reference_task(void *arg) {
+	(void)arg;
+	readings_snapshot_t snapshot;
+	weather_snapshot_t weather;
+	stocks_snapshot_t stocks;
+	char time_str[9];
+
+	while (!s_ref_stop) {
+		if (s_measuring)
+			s_acc.wakeups++;
+		struct tm now;
+		(void)sntp_service_get_local_timeinfo(&now);
+		strftime(time_str, sizeof(time_str), "%H:%M:%S", &now);
+		readings_get_snapshot(&snapshot);
+		weather_get_snapshot(&weather);
+		stocks_get_snapshot(&stocks);
+		float cpu_pct = ui_clock_sample_cpu();
+
+		bsp_display_lock(0);
+		ui_set_time_str(time_str);
+		ui_update_readings(&snapshot);
+		ui_update_weather(&weather);
+		ui_update_stocks(&stocks);
+		ui_clock_update(&now, cpu_pct);
+		bsp_display_unlock();
+
+		vTaskDelay(pdMS_TO_TICKS(100));
+	}
+	vTaskDelete(NULL);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Runs                                                                       */
+/* -------------------------------------------------------------------------- */
+
+static const char *const s_tile_names[UI_TILE_COUNT] = {"clock", "stats",
+														"weather", "stocks"};
+
+/** Show a tile as ui.c does, then measure one window. */
+static bench_acc_t run_window(ui_tile_t tile) {
+	s_visible = 1u << tile;
+	data_bus_publish(DATA_TOPIC_VIEW);
+	vTaskDelay(pdMS_TO_TICKS(BENCH_WARMUP_MS));
+
+	memset(&s_acc, 0, sizeof(s_acc));
+	s_measuring = true;
+	vTaskDelay(pdMS_TO_TICKS(BENCH_WINDOW_MS));
+	s_measuring = false;
+	return s_acc;
+}
+
+static void print_row(ui_tile_t tile, const char *loop, const bench_acc_t *a) {
+	double s = BENCH_WINDOW_MS / 1000.0;
+	printf("%-8s %-10s %9.2f %7.2f %9.2f %11.2f", s_tile_names[tile], loop,
+		   a->wakeups / s, a->locks / s, a->updates / s, a->snapshots / s);
+	if (a->flips) {
+		printf(" %9.1f %6.1f %7u\n", a->lag_acc_us / 1000.0 / a->flips,
+			   a->lag_max_us / 1000.0, (unsigned)a->skipped);
+	} else {
+		printf(" %9s %6s %7s\n", "-", "-", "-");
+	}
+}
+
+static void bench_main(void *arg) {
+	(void)arg;
+	for (size_t i = 0; i < sizeof(s_producers) / sizeof(s_producers[0]); i++)
+		(void)xTaskCreatePinnedToCore(producer_task, "producer", 4096,
+									  (void *)&s_producers[i], 5, NULL, 0);
+
+	printf("tile     loop       wakeups/s locks/s updates/s snapshots/s "
+		   "lag mean    max skipped\n");
+	printf("                                                            "
+		   "(ms past the second)\n");
+
+	bench_acc_t ref[UI_TILE_COUNT];
+	(void)xTaskCreatePinnedToCore(reference_task, "ui_reference", 4096, NULL,
+								  5, NULL, 0);
+	for (int t = 0; t < UI_TILE_COUNT; t++)
+		ref[t] = run_window((ui_tile_t)t);
+	s_ref_stop = true;
+	vTaskDelay(pdMS_TO_TICKS(200));
+
+	bench_acc_t evt[UI_TILE_COUNT];
+	ui_task_start();
+	for (int t = 0; t < UI_TILE_COUNT; t++) {
+		evt[t] = run_window((ui_tile_t)t);
+
+		// The firmware's own counter over its last 10 s window agrees
+		ui_task_stats_t st;
+		ui_task_get_stats(&st);
+		double counted = evt[t].wakeups * 1000.0 / BENCH_WINDOW_MS;
+		CHECK(st.wakeups_per_s > counted - 0.5 &&
+			  st.wakeups_per_s < counted + 0.5);
+	}
+
+	for (int t = 0; t < UI_TILE_COUNT; t++) {
+		print_row((ui_tile_t)t, "100 ms", &ref[t]);
+		print_row((ui_tile_t)t, "event", &evt[t]);
+
+		CHECK(evt[t].wakeups * 2 < ref[t].wakeups);
+		CHECK(evt[t].locks * 3 < ref[t].locks);
+		CHECK(evt[t].snapshots * 4 < ref[t].snapshots);
+		if (t == UI_TILE_CLOCK || t == UI_TILE_STATS) {
+			// Every second shown, each within the tick margin
+			CHECK_EQ(evt[t].skipped, 0);
+			CHECK(evt[t].flips >= BENCH_WINDOW_MS / 1000 - 1);
+			CHECK(evt[t].lag_max_us < 5000);
+		}
+	}
+}
+
+int main(void) {
+	sim_rtos_run(bench_main, NULL);
+	return host_test_result("bench_ui_task");
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+/*
+ * Minimal checks for the host tests: a failed CHECK prints its location and
+ * the test keeps going; host_test_result() is the process exit code.
+ */
+
+#include <stdio.h>
+
+extern int host_test_failures;
+
+#define CHECK(cond)                                                            \
+	do {                                                                       \
+		if (!(cond)) {                                                         \
+			fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,   \
+					#cond);                                                    \
+			host_test_failures++;                                              \
+		}                                                                      \
+	} while (0)
+
+#define CHECK_EQ(a, b)                                                         \
+	do {                                                                       \
+		long long a_ = (long long)(a);                                         \
+		long long b_ = (long long)(b);                                         \
+		if (a_ != b_) {                                                        \
+			fprintf(stderr, "%s:%d: %s == %s failed (%lld vs %lld)\n",         \
+					__FILE__, __LINE__, #a, #b, a_, b_);                       \
+			host_test_failures++;                                              \
+		}                                                                      \
+	} while (0)
+
+/** Print a summary line and return the exit code for main(). */
+static inline int host_test_result(const char *name) {
+	if (host_test_failures) {
+		fprintf(stderr, "%s: %d check(s) failed\n", name, host_test_failures);
+		return 1;
+	}
+	printf("%s: all checks passed\n", name);
+	return 0;
+}
+
+/** Define once per test executable. */
+#define HOST_TEST_STATE int host_test_failures
@@ -0,0 +1,26 @@
+#pragma once
+
+/*
+ * LVGL 8 configuration for bench_ui_render: the device's settings from
+ * sdkconfig.defaults, LVGL's defaults for the rest (lv_conf_internal.h).
+ */
+
+/* ILI9342C: RGB565, byte-swapped */
+#define LV_COLOR_DEPTH 16
+#define LV_COLOR_16_SWAP 1
+
+/* LVGL's own heap, so lv_mem_monitor() can report it */
+#define LV_MEM_CUSTOM 0
+#define LV_MEM_SIZE (128U * 1024U)
+
+/* The bench advances the tick itself (lv_tick_inc()) */
+#define LV_TICK_CUSTOM 0
+
+#define LV_FONT_MONTSERRAT_14 1
+#define LV_FONT_MONTSERRAT_16 1
+#define LV_FONT_MONTSERRAT_20 1
+#define LV_FONT_MONTSERRAT_40 1
+
+#define LV_USE_LOG 0
+#define LV_USE_PERF_MONITOR 0
+#define LV_USE_MEM_MONITOR 0
@@ -0,0 +1,164 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+
+/* -------------------------------------------------------------------------- */
+/* Errors and logging                                                         */
+/* -------------------------------------------------------------------------- */
+
+const char *esp_err_to_name(esp_err_t code) {
+	switch (code) {
+	case ESP_OK:
+		return "ESP_OK";
+	case ESP_FAIL:
+		return "ESP_FAIL";
+	case ESP_ERR_NO_MEM:
+		return "ESP_ERR_NO_MEM";
+	case ESP_ERR_INVALID_ARG:
+		return "ESP_ERR_INVALID_ARG";
+	case ESP_ERR_INVALID_STATE:
+		return "ESP_ERR_INVALID_STATE";
+	case ESP_ERR_INVALID_SIZE:
+		return "ESP_ERR_INVALID_SIZE";
+	case ESP_ERR_NOT_FOUND:
+		return "ESP_ERR_NOT_FOUND";
+	case ESP_ERR_NOT_SUPPORTED:
+		return "ESP_ERR_NOT_SUPPORTED";
+	case ESP_ERR_TIMEOUT:
+		return "ESP_ERR_TIMEOUT";
+	case ESP_ERR_INVALID_RESPONSE:
+		return "ESP_ERR_INVALID_RESPONSE";
+	case ESP_ERR_INVALID_CRC:
+		return "ESP_ERR_INVALID_CRC";
+	case ESP_ERR_NOT_FINISHED:
+		return "ESP_ERR_NOT_FINISHED";
+	default:
+		return "UNKNOWN ERROR";
+	}
+}
+
+void _esp_error_check_failed(esp_err_t rc, const char *file, int line,
+							 const char *function, const char *expression) {
+	fprintf(stderr, "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\n"
+			"func: %s\nexpression: %s\n",
+			rc, esp_err_to_name(rc), file, line, function, expression);
+	abort();
+}
+
+void sim_log(esp_log_level_t level, const char *tag, const char *fmt, ...) {
+	static int s_max = -1;
+	if (s_max < 0) {
+		const char *env = getenv("ESP_LOG_LEVEL");
+		s_max = env ? atoi(env) : ESP_LOG_WARN;
+	}
+	if ((int)level > s_max)
+		return;
+
+	static const char letters[] = "NEWIDV";
+	fprintf(stderr, "%c (%.3f) %s: ", letters[level],
+			(double)esp_timer_get_time() / 1000.0, tag);
+	va_list ap;
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+}
+
+/* -------------------------------------------------------------------------- */
+/* ROM functions                                                              */
+/* -------------------------------------------------------------------------- */
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+	crc = ~crc;
+	for (uint32_t i = 0; i < len; i++) {
+		crc ^= buf[i];
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+	}
+	return ~crc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* I2C master driver (no hardware on the host)                                */
+/* -------------------------------------------------------------------------- */
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *cfg,
+							 i2c_master_bus_handle_t *out) {
+	(void)cfg;
+	(void)out;
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus) {
+	(void)bus;
+	return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus,
+									const i2c_device_config_t *cfg,
+									i2c_master_dev_handle_t *out) {
+	(void)bus;
+	(void)cfg;
+	(void)out;
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t dev) {
+	(void)dev;
+	return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t *tx,
+							  size_t tx_len, int timeout_ms) {
+	(void)dev;
+	(void)tx;
+	(void)tx_len;
+	(void)timeout_ms;
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t dev, uint8_t *rx,
+							 size_t rx_len, int timeout_ms) {
+	(void)dev;
+	(void)rx;
+	(void)rx_len;
+	(void)timeout_ms;
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t dev,
+									  const uint8_t *tx, size_t tx_len,
+									  uint8_t *rx, size_t rx_len,
+									  int timeout_ms) {
+	(void)dev;
+	(void)tx;
+	(void)tx_len;
+	(void)rx;
+	(void)rx_len;
+	(void)timeout_ms;
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus, uint16_t addr,
+						   int timeout_ms) {
+	(void)bus;
+	(void)addr;
+	(void)timeout_ms;
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t
+i2c_master_register_event_callbacks(i2c_master_dev_handle_t dev,
+									const i2c_master_event_callbacks_t *cbs,
+									void *arg) {
+	(void)dev;
+	(void)cbs;
+	(void)arg;
+	return ESP_ERR_NOT_SUPPORTED;
+}
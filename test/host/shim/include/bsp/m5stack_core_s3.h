@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+ * Host stand-in for the board support package: the display geometry and
+ * lock the UI modules use. Each test that builds UI code defines the lock.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_LCD_H_RES 320
+#define BSP_LCD_V_RES 240
+
+bool bsp_display_lock(uint32_t timeout_ms);
+void bsp_display_unlock(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Let `us` microseconds of virtual time pass for the calling task.
+ *
+ * On the chip this spins the CPU. Here only the caller is held, and other
+ * tasks keep running, so simulated bus time never costs simulated CPU.
+ */
+void esp_rom_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
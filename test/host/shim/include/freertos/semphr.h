@@ -0,0 +1,19 @@
+#pragma once
+
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A mutex is a one-slot queue holding the token (no priority inheritance). */
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+#define xSemaphoreTake(sem, ticks) xQueueReceive((sem), NULL, (ticks))
+#define xSemaphoreGive(sem) xQueueSend((sem), NULL, 0)
+#define vSemaphoreDelete(sem) vQueueDelete(sem)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum {
+	eNoAction = 0,
+	eSetBits,
+	eIncrement,
+	eSetValueWithOverwrite,
+} eNotifyAction;
+
+typedef struct {
+	TaskHandle_t xHandle;
+	const char *pcTaskName;
+	UBaseType_t uxCurrentPriority;
+	uint32_t ulRunTimeCounter; ///< Always 0: simulated time costs no CPU
+} TaskStatus_t;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+								   uint32_t stack_depth, void *arg,
+								   UBaseType_t prio, TaskHandle_t *out,
+								   BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t max,
+								 uint32_t *total_run_time);
+
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *prev, TickType_t increment);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value,
+					   eNotifyAction action);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+						   uint32_t *value, TickType_t ticks);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+ * Configuration for the host builds: the Kconfig defaults of the options
+ * the modules under test read, with the simulated external buses selected.
+ */
+
+#define CONFIG_FREERTOS_HZ 100
+
+#define CONFIG_PORT_I2C_SIM 1
+#define CONFIG_PORT_I2C_SIM_NACK_PERMILLE 0
+#define CONFIG_PORT_I2C_SIM_CRC_PERMILLE 0
+#define CONFIG_PORT_I2C_SIM_EXTRA_LATENCY_US 0
+
+#define CONFIG_HISTORY_LOG_FLUSH_MIN 1
@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+ * RAM-backed flash behind the esp_partition stand-ins, with power cuts.
+ *
+ * The caller owns the memory, so it can outlive a simulated reset (e.g. a
+ * shared mapping across fork()). A cut lands part of the operation it
+ * interrupts: a write programs a prefix of its bytes and some bits of the
+ * next one; an erase resets a random subset of the sector's bytes to 0xFF
+ * and some bits of others. Then the power_off hook runs instead of the
+ * operation returning.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_FLASH_SECTOR_SIZE 4096
+
+typedef enum {
+	SIM_FLASH_WRITE,
+	SIM_FLASH_ERASE,
+} sim_flash_op_t;
+
+typedef struct {
+	/** Before every write or erase; return true to cut power during it. */
+	bool (*before)(sim_flash_op_t op, size_t offset, size_t size, void *arg);
+	/** After every write or erase that completed. */
+	void (*done)(sim_flash_op_t op, size_t offset, const void *src,
+				 size_t size, void *arg);
+	/** Once a cut operation has landed; must not return. */
+	void (*power_off)(void *arg);
+	void *arg;
+} sim_flash_hooks_t;
+
+/**
+ * @brief Register a partition backed by `mem` (size bytes, a multiple of
+ * SIM_FLASH_SECTOR_SIZE). The memory is used as is, not erased.
+ */
+const esp_partition_t *sim_flash_add_partition(const char *label,
+											   esp_partition_type_t type,
+											   esp_partition_subtype_t subtype,
+											   uint8_t *mem, size_t size);
+
+/**
+ * @brief Install hooks (NULL removes them); `seed` drives how much of a
+ * cut operation lands.
+ */
+void sim_flash_set_hooks(const sim_flash_hooks_t *hooks, uint32_t seed);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+ * Virtual-time scheduler behind the FreeRTOS and esp_timer stand-ins.
+ *
+ * Tasks are coroutines on the host thread. The highest-priority ready task
+ * runs until it blocks (delay, queue, semaphore, notification or
+ * esp_rom_delay_us()); when no task is ready, the clock jumps to the next
+ * wake-up. Simulated time is therefore exact and independent of host
+ * speed, and CPU time spent between blocking calls is free.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Run `fn` as a priority-1 task (like app_main) until it returns.
+ *
+ * Other tasks are left where they blocked. Aborts if every task blocks
+ * forever before fn returns.
+ */
+void sim_rtos_run(TaskFunction_t fn, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,156 @@
+#include "sim_flash.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PARTITIONS 4
+
+typedef struct {
+	esp_partition_t part;
+	uint8_t *mem;
+} sim_partition_t;
+
+static sim_partition_t s_parts[MAX_PARTITIONS];
+static int s_n_parts;
+
+static sim_flash_hooks_t s_hooks;
+static uint32_t s_rng = 1;
+
+static uint32_t rng_next(void) {
+	// xorshift32: fixed sequence per seed, so failures reproduce
+	s_rng ^= s_rng << 13;
+	s_rng ^= s_rng >> 17;
+	s_rng ^= s_rng << 5;
+	return s_rng;
+}
+
+static uint8_t *mem_of(const esp_partition_t *part) {
+	for (int i = 0; i < s_n_parts; i++) {
+		if (&s_parts[i].part == part)
+			return s_parts[i].mem;
+	}
+	return NULL;
+}
+
+static bool in_range(const esp_partition_t *part, size_t offset, size_t size) {
+	return offset <= part->size && size <= part->size - offset;
+}
+
+const esp_partition_t *sim_flash_add_partition(const char *label,
+											   esp_partition_type_t type,
+											   esp_partition_subtype_t subtype,
+											   uint8_t *mem, size_t size) {
+	if (s_n_parts >= MAX_PARTITIONS || !mem ||
+		size % SIM_FLASH_SECTOR_SIZE != 0)
+		return NULL;
+
+	sim_partition_t *p = &s_parts[s_n_parts];
+	p->part = (esp_partition_t){
+		.type = type,
+		.subtype = subtype,
+		.address = 0x10000u * (uint32_t)(s_n_parts + 1),
+		.size = (uint32_t)size,
+		.erase_size = SIM_FLASH_SECTOR_SIZE,
+	};
+	strncpy(p->part.label, label, sizeof(p->part.label) - 1);
+	p->mem = mem;
+	s_n_parts++;
+	return &p->part;
+}
+
+void sim_flash_set_hooks(const sim_flash_hooks_t *hooks, uint32_t seed) {
+	s_hooks = hooks ? *hooks : (sim_flash_hooks_t){0};
+	s_rng = seed ? seed : 1;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+												esp_partition_subtype_t subtype,
+												const char *label) {
+	for (int i = 0; i < s_n_parts; i++) {
+		const esp_partition_t *p = &s_parts[i].part;
+		if (p->type == type && p->subtype == subtype &&
+			(!label || strcmp(p->label, label) == 0))
+			return p;
+	}
+	return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset,
+							 void *dst, size_t size) {
+	uint8_t *mem = mem_of(part);
+	if (!mem || !dst)
+		return ESP_ERR_INVALID_ARG;
+	if (!in_range(part, offset, size))
+		return ESP_ERR_INVALID_SIZE;
+	memcpy(dst, mem + offset, size);
+	return ESP_OK;
+}
+
+/** Land part of a write, then cut power. */
+static void cut_write(uint8_t *dst, const uint8_t *src, size_t size) {
+	size_t done = rng_next() % (size + 1);
+	for (size_t i = 0; i < done; i++)
+		dst[i] &= src[i];
+	if (done < size)
+		dst[done] &= (uint8_t)(src[done] | rng_next()); // some bits made it
+
+	s_hooks.power_off(s_hooks.arg);
+	abort(); /* power_off must not return */
+}
+
+/** Land part of an erase, then cut power. */
+static void cut_erase(uint8_t *dst, size_t size) {
+	uint32_t permille = rng_next() % 1001;
+	for (size_t i = 0; i < size; i++) {
+		uint32_t r = rng_next();
+		if (r % 1000 < permille)
+			dst[i] = 0xFF;
+		else if ((r >> 16) % 64 == 0)
+			dst[i] |= (uint8_t)(r >> 8); // weakly erased
+	}
+
+	s_hooks.power_off(s_hooks.arg);
+	abort();
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset,
+							  const void *src, size_t size) {
+	uint8_t *mem = mem_of(part);
+	if (!mem || !src)
+		return ESP_ERR_INVALID_ARG;
+	if (!in_range(part, offset, size))
+		return ESP_ERR_INVALID_SIZE;
+
+	if (s_hooks.before &&
+		s_hooks.before(SIM_FLASH_WRITE, offset, size, s_hooks.arg))
+		cut_write(mem + offset, src, size);
+
+	const uint8_t *s = src;
+	for (size_t i = 0; i < size; i++)
+		mem[offset + i] &= s[i];
+
+	if (s_hooks.done)
+		s_hooks.done(SIM_FLASH_WRITE, offset, src, size, s_hooks.arg);
+	return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *part,
+									size_t offset, size_t size) {
+	uint8_t *mem = mem_of(part);
+	if (!mem)
+		return ESP_ERR_INVALID_ARG;
+	if (offset % part->erase_size != 0)
+		return ESP_ERR_INVALID_ARG;
+	if (size % part->erase_size != 0 || !in_range(part, offset, size))
+		return ESP_ERR_INVALID_SIZE;
+
+	if (s_hooks.before &&
+		s_hooks.before(SIM_FLASH_ERASE, offset, size, s_hooks.arg))
+		cut_erase(mem + offset, size);
+
+	memset(mem + offset, 0xFF, size);
+
+	if (s_hooks.done)
+		s_hooks.done(SIM_FLASH_ERASE, offset, NULL, size, s_hooks.arg);
+	return ESP_OK;
+}
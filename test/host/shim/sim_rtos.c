@@ -0,0 +1,535 @@
+#define _GNU_SOURCE
+#include "sim_rtos.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#define TICK_US (1000000 / configTICK_RATE_HZ)
+#define NEVER INT64_MAX
+
+/*
+ * The clock starts where app_main roughly starts on the chip, so code that
+ * treats a zero timestamp or tick as "unset" behaves as it does there.
+ */
+#define SIM_BOOT_US 500000
+
+/* Host code (stdio in particular) needs far more stack than on the chip. */
+#define SIM_STACK_BYTES (256 * 1024)
+
+/**
+ * @brief One simulated task.
+ *
+ * A task is ready, blocked (wait_obj and/or wake_us set) or done. Blocked
+ * tasks are woken by wake() on their object or by the clock reaching
+ * wake_us, and then re-check whatever they were waiting for.
+ */
+struct sim_task {
+	ucontext_t ctx;
+	TaskFunction_t fn;
+	void *arg;
+	const char *name;
+	UBaseType_t prio;
+	void *stack;
+	bool ready;
+	bool done;
+	bool timed_out;		  ///< Last block ended by wake_us, not by wake()
+	const void *wait_obj; ///< Object blocked on (NULL = plain delay)
+	int64_t wake_us;	  ///< Timeout (NEVER = none)
+	uint64_t order;		  ///< FIFO position among equal priorities
+	uint32_t notify;	  ///< Notification value
+	bool notified;		  ///< A notification arrived since the last wait
+	struct sim_task *next;
+};
+
+struct sim_queue {
+	uint8_t *buf;
+	UBaseType_t len;
+	UBaseType_t item_size;
+	UBaseType_t head;
+	UBaseType_t count;
+};
+
+static int64_t s_now_us = SIM_BOOT_US;
+static struct sim_task *s_tasks; ///< Every task, in creation order
+static struct sim_task *s_current;
+static ucontext_t s_sched;
+static uint64_t s_order;
+
+/* -------------------------------------------------------------------------- */
+/* Scheduler                                                                  */
+/* -------------------------------------------------------------------------- */
+
+static void make_ready(struct sim_task *t) {
+	t->ready = true;
+	t->wait_obj = NULL;
+	t->wake_us = NEVER;
+	t->order = s_order++;
+}
+
+/** Return to the scheduler; the current task's state is already set. */
+static void switch_out(void) {
+	swapcontext(&s_current->ctx, &s_sched);
+}
+
+/**
+ * @brief Block the current task until wake(obj) or until wake_us.
+ *
+ * @return false if the timeout ended the wait.
+ */
+static bool block(const void *obj, int64_t wake_us) {
+	struct sim_task *t = s_current;
+	t->ready = false;
+	t->wait_obj = obj;
+	t->wake_us = wake_us;
+	t->timed_out = false;
+	switch_out();
+	return !t->timed_out;
+}
+
+/** Let a task that just became ready run first if it outranks the caller. */
+static void preempt_check(UBaseType_t prio) {
+	if (s_current && prio > s_current->prio) {
+		make_ready(s_current);
+		switch_out();
+	}
+}
+
+/** Make every task blocked on obj ready; each re-checks its condition. */
+static void wake(const void *obj) {
+	UBaseType_t top = 0;
+	for (struct sim_task *t = s_tasks; t; t = t->next) {
+		if (!t->ready && !t->done && t->wait_obj == obj) {
+			make_ready(t);
+			if (t->prio > top)
+				top = t->prio;
+		}
+	}
+	preempt_check(top);
+}
+
+/** Absolute time a wait of `ticks` from now ends (tick-aligned). */
+static int64_t deadline_us(TickType_t ticks) {
+	if (ticks == portMAX_DELAY)
+		return NEVER;
+	return (s_now_us / TICK_US + (int64_t)ticks) * TICK_US;
+}
+
+static struct sim_task *pick(void) {
+	struct sim_task *best = NULL;
+	for (struct sim_task *t = s_tasks; t; t = t->next) {
+		if (!t->ready || t->done)
+			continue;
+		if (!best || t->prio > best->prio ||
+			(t->prio == best->prio && t->order < best->order))
+			best = t;
+	}
+	return best;
+}
+
+/**
+ * @brief Move the clock to the earliest timeout and wake its tasks.
+ *
+ * @return false if no blocked task has a timeout (deadlock).
+ */
+static bool advance(void) {
+	int64_t next = NEVER;
+	for (struct sim_task *t = s_tasks; t; t = t->next) {
+		if (!t->ready && !t->done && t->wake_us < next)
+			next = t->wake_us;
+	}
+	if (next == NEVER)
+		return false;
+
+	if (next > s_now_us)
+		s_now_us = next;
+	for (struct sim_task *t = s_tasks; t; t = t->next) {
+		if (!t->ready && !t->done && t->wake_us <= s_now_us) {
+			t->timed_out = t->wait_obj != NULL;
+			make_ready(t);
+		}
+	}
+	return true;
+}
+
+static void trampoline(void) {
+	struct sim_task *t = s_current;
+	t->fn(t->arg);
+	t->done = true;
+	t->ready = false;
+	/* uc_link returns to the scheduler */
+}
+
+void sim_rtos_run(TaskFunction_t fn, void *arg) {
+	TaskHandle_t main_task = NULL;
+	if (xTaskCreatePinnedToCore(fn, "main", 0, arg, 1, &main_task, 0) !=
+		pdPASS) {
+		fprintf(stderr, "sim_rtos: cannot create the main task\n");
+		abort();
+	}
+
+	while (!main_task->done) {
+		struct sim_task *t = pick();
+		if (!t) {
+			if (!advance()) {
+				fprintf(stderr, "sim_rtos: every task is blocked forever\n");
+				abort();
+			}
+			continue;
+		}
+		s_current = t;
+		swapcontext(&s_sched, &t->ctx);
+		s_current = NULL;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+/* Tasks and time                                                             */
+/* -------------------------------------------------------------------------- */
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+								   uint32_t stack_depth, void *arg,
+								   UBaseType_t prio, TaskHandle_t *out,
+								   BaseType_t core) {
+	(void)stack_depth;
+	(void)core;
+
+	struct sim_task *t = calloc(1, sizeof(*t));
+	void *stack = malloc(SIM_STACK_BYTES);
+	if (!t || !stack) {
+		free(t);
+		free(stack);
+		return pdFAIL;
+	}
+	t->fn = fn;
+	t->arg = arg;
+	t->name = name;
+	t->prio = prio;
+	t->stack = stack;
+
+	getcontext(&t->ctx);
+	t->ctx.uc_stack.ss_sp = stack;
+	t->ctx.uc_stack.ss_size = SIM_STACK_BYTES;
+	t->ctx.uc_link = &s_sched;
+	makecontext(&t->ctx, trampoline, 0);
+
+	/* Append, so equal wake-up times resolve in creation order */
+	struct sim_task **tail = &s_tasks;
+	while (*tail)
+		tail = &(*tail)->next;
+	*tail = t;
+
+	make_ready(t);
+	if (out)
+		*out = t;
+	preempt_check(prio);
+	return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+	struct sim_task *t = task ? task : s_current;
+	t->done = true;
+	t->ready = false;
+	if (t == s_current)
+		switch_out(); /* never resumed */
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+	return s_current;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t max,
+								 uint32_t *total_run_time) {
+	UBaseType_t n = 0;
+	for (struct sim_task *t = s_tasks; t && n < max; t = t->next) {
+		if (t->done)
+			continue;
+		status[n++] = (TaskStatus_t){
+			.xHandle = t,
+			.pcTaskName = t->name,
+			.uxCurrentPriority = t->prio,
+		};
+	}
+	if (total_run_time)
+		*total_run_time = 0;
+	return n;
+}
+
+TickType_t xTaskGetTickCount(void) {
+	return (TickType_t)(s_now_us / TICK_US);
+}
+
+int64_t esp_timer_get_time(void) {
+	return s_now_us;
+}
+
+void vTaskDelay(TickType_t ticks) {
+	if (ticks == 0) {
+		make_ready(s_current);
+		switch_out();
+		return;
+	}
+	(void)block(NULL, deadline_us(ticks));
+}
+
+void vTaskDelayUntil(TickType_t *prev, TickType_t increment) {
+	TickType_t next = *prev + increment;
+	TickType_t now = xTaskGetTickCount();
+	*prev = next;
+	if ((int32_t)(next - now) > 0) {
+		(void)block(NULL, deadline_us(next - now));
+	}
+}
+
+void esp_rom_delay_us(uint32_t us) {
+	if (us > 0) {
+		(void)block(NULL, s_now_us + us);
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+/* Notifications                                                              */
+/* -------------------------------------------------------------------------- */
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+	struct sim_task *t = s_current;
+	int64_t until = deadline_us(ticks);
+
+	while (t->notify == 0 && ticks != 0) {
+		if (!block(t, until))
+			break;
+	}
+	uint32_t value = t->notify;
+	if (value > 0) {
+		t->notify = clear ? 0 : value - 1;
+		t->notified = false;
+	}
+	return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+	return xTaskNotify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+	if (woken)
+		*woken = pdFALSE;
+	(void)xTaskNotifyGive(task);
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value,
+					   eNotifyAction action) {
+	switch (action) {
+	case eNoAction:
+		break;
+	case eSetBits:
+		task->notify |= value;
+		break;
+	case eIncrement:
+		task->notify++;
+		break;
+	case eSetValueWithOverwrite:
+		task->notify = value;
+		break;
+	}
+	task->notified = true;
+	wake(task);
+	return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+						   uint32_t *value, TickType_t ticks) {
+	struct sim_task *t = s_current;
+	int64_t until = deadline_us(ticks);
+
+	if (!t->notified)
+		t->notify &= ~clear_on_entry;
+	while (!t->notified && ticks != 0) {
+		if (!block(t, until))
+			break;
+	}
+	if (value)
+		*value = t->notify;
+	if (!t->notified)
+		return pdFALSE;
+	t->notify &= ~clear_on_exit;
+	t->notified = false;
+	return pdTRUE;
+}
+
+/* -------------------------------------------------------------------------- */
+/* esp_timer                                                                  */
+/* -------------------------------------------------------------------------- */
+
+struct esp_timer {
+	esp_timer_cb_t cb;
+	void *arg;
+	int64_t due_us;		///< Next expiry (NEVER = stopped)
+	uint64_t period_us; ///< 0 = one-shot
+	struct esp_timer *next;
+};
+
+static struct esp_timer *s_timers;
+static TaskHandle_t s_timer_task;
+
+/** Run expired callbacks in due order; sleep until the next expiry. */
+static void timer_task(void *arg) {
+	(void)arg;
+	for (;;) {
+		struct esp_timer *first = NULL;
+		for (struct esp_timer *t = s_timers; t; t = t->next) {
+			if (t->due_us != NEVER && (!first || t->due_us < first->due_us))
+				first = t;
+		}
+		if (!first || first->due_us > s_now_us) {
+			// Woken early when a timer is started or stopped
+			(void)block(&s_timers, first ? first->due_us : NEVER);
+			continue;
+		}
+		first->due_us =
+			first->period_us ? first->due_us + (int64_t)first->period_us
+							 : NEVER;
+		first->cb(first->arg);
+	}
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args,
+						   esp_timer_handle_t *out) {
+	if (!args || !args->callback || !out)
+		return ESP_ERR_INVALID_ARG;
+	if (!s_timer_task &&
+		xTaskCreatePinnedToCore(timer_task, "esp_timer", 0, NULL, 22,
+								&s_timer_task, 0) != pdPASS)
+		return ESP_ERR_NO_MEM;
+
+	struct esp_timer *t = calloc(1, sizeof(*t));
+	if (!t)
+		return ESP_ERR_NO_MEM;
+	t->cb = args->callback;
+	t->arg = args->arg;
+	t->due_us = NEVER;
+	t->next = s_timers;
+	s_timers = t;
+	*out = t;
+	return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t after_us,
+							 uint64_t period_us) {
+	if (!timer)
+		return ESP_ERR_INVALID_ARG;
+	if (timer->due_us != NEVER)
+		return ESP_ERR_INVALID_STATE;
+	timer->due_us = s_now_us + (int64_t)after_us;
+	timer->period_us = period_us;
+	wake(&s_timers);
+	return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+	return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer,
+								   uint64_t period_us) {
+	return timer_start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+	if (!timer)
+		return ESP_ERR_INVALID_ARG;
+	if (timer->due_us == NEVER)
+		return ESP_ERR_INVALID_STATE;
+	timer->due_us = NEVER;
+	wake(&s_timers);
+	return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+	if (!timer)
+		return ESP_ERR_INVALID_ARG;
+	if (timer->due_us != NEVER)
+		return ESP_ERR_INVALID_STATE;
+	for (struct esp_timer **p = &s_timers; *p; p = &(*p)->next) {
+		if (*p == timer) {
+			*p = timer->next;
+			break;
+		}
+	}
+	free(timer);
+	return ESP_OK;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Queues and mutexes                                                         */
+/* -------------------------------------------------------------------------- */
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size) {
+	if (len == 0)
+		return NULL;
+	struct sim_queue *q = calloc(1, sizeof(*q));
+	if (!q)
+		return NULL;
+	q->buf = calloc(len, item_size ? item_size : 1);
+	if (!q->buf) {
+		free(q);
+		return NULL;
+	}
+	q->len = len;
+	q->item_size = item_size;
+	return q;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+	if (q) {
+		free(q->buf);
+		free(q);
+	}
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks) {
+	int64_t until = deadline_us(ticks);
+	while (q->count >= q->len) {
+		if (ticks == 0 || !block(q, until))
+			return pdFALSE;
+	}
+	if (q->item_size) {
+		UBaseType_t tail = (q->head + q->count) % q->len;
+		memcpy(q->buf + (size_t)tail * q->item_size, item, q->item_size);
+	}
+	q->count++;
+	wake(q);
+	return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks) {
+	int64_t until = deadline_us(ticks);
+	while (q->count == 0) {
+		if (ticks == 0 || !block(q, until))
+			return pdFALSE;
+	}
+	if (q->item_size) {
+		memcpy(item, q->buf + (size_t)q->head * q->item_size, q->item_size);
+	}
+	q->head = (q->head + 1) % q->len;
+	q->count--;
+	wake(q);
+	return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+	return q->count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+	SemaphoreHandle_t sem = xQueueCreate(1, 0);
+	if (sem)
+		sem->count = 1; /* created given */
+	return sem;
+}
@@ -0,0 +1,241 @@
+/*
+ * Round trips of the raw history codec (history_codec.c): every length
+ * class and its boundaries, int32 and timestamp wrap-around, full buffers,
+ * truncated input and the block API.
+ */
+
+#include <string.h>
+
+#include "history_codec.h"
+#include "host_test.h"
+
+HOST_TEST_STATE;
+
+#define MAX_SAMPLES 4096
+
+static uint32_t s_rng = 0x9E3779B9u;
+
+static uint32_t rng_next(void) {
+	s_rng ^= s_rng << 13;
+	s_rng ^= s_rng >> 17;
+	s_rng ^= s_rng << 5;
+	return s_rng;
+}
+
+/**
+ * @brief Encode a series in one stream, then decode and compare it.
+ *
+ * Also checks that no sample costs more than HISTORY_CODEC_MAX_BITS.
+ */
+static void round_trip(const uint32_t *t, const int32_t *v, uint32_t n) {
+	static uint8_t buf[MAX_SAMPLES * HISTORY_CODEC_MAX_BITS / 8];
+	history_enc_t e;
+	history_enc_init(&e, buf, sizeof(buf));
+	for (uint32_t i = 0; i < n; i++) {
+		uint32_t before = e.bits;
+		CHECK(history_enc_add(&e, t[i], v[i]));
+		CHECK(e.bits - before <= HISTORY_CODEC_MAX_BITS);
+	}
+	CHECK_EQ(e.count, n);
+
+	history_dec_t d;
+	history_dec_init(&d, buf, history_enc_bytes(&e), e.count);
+	for (uint32_t i = 0; i < n; i++) {
+		uint32_t dt;
+		int32_t dv;
+		CHECK(history_dec_next(&d, &dt, &dv));
+		CHECK_EQ(dt, t[i]);
+		CHECK_EQ(dv, v[i]);
+	}
+	uint32_t dt;
+	int32_t dv;
+	CHECK(!history_dec_next(&d, &dt, &dv));
+}
+
+/** Value deltas at and around every class boundary, both signs. */
+static void test_value_classes(void) {
+	static const int32_t deltas[] = {
+		0, 1, -1, 7, -8, 8, -9, 127, -128, 128, -129,
+		32767, -32768, 32768, -32769, INT32_MAX, INT32_MIN,
+	};
+	uint32_t t[64];
+	int32_t v[64];
+	uint32_t n = 0;
+	int32_t value = 0;
+	for (size_t i = 0; i < sizeof(deltas) / sizeof(deltas[0]); i++) {
+		t[n] = 1000 + n;
+		v[n++] = value;
+		value = (int32_t)((uint32_t)value + (uint32_t)deltas[i]);
+	}
+	t[n] = 1000 + n;
+	v[n++] = value;
+	round_trip(t, v, n);
+}
+
+/** Timestamp delta-of-deltas at every class boundary, and wrap-around. */
+static void test_timestamp_classes(void) {
+	static const int32_t dods[] = {
+		0, 1, -1, 63, -64, 64, -65, 255, -256, 256, -257, 2047, -2048, 2048,
+	};
+	uint32_t t[64];
+	int32_t v[64] = {0};
+	uint32_t n = 0;
+	uint32_t now = 5000, dt = 3000;
+	for (size_t i = 0; i < sizeof(dods) / sizeof(dods[0]); i++) {
+		t[n++] = now;
+		dt += (uint32_t)dods[i];
+		now += dt;
+	}
+	// Backwards, then across 2^32
+	t[n++] = 10;
+	t[n++] = UINT32_MAX - 1;
+	t[n++] = 3;
+	round_trip(t, v, n);
+}
+
+/** Random walks mixing small steps with occasional jumps of any size. */
+static void test_random_series(void) {
+	static uint32_t t[MAX_SAMPLES];
+	static int32_t v[MAX_SAMPLES];
+
+	for (int series = 0; series < 200; series++) {
+		uint32_t n = 1 + rng_next() % MAX_SAMPLES;
+		uint32_t now = rng_next();
+		uint32_t value = rng_next();
+		for (uint32_t i = 0; i < n; i++) {
+			uint32_t r = rng_next();
+			now += r % 16 == 0 ? rng_next() : 1 + r % 3;
+			value += r % 32 == 0 ? rng_next() : (r >> 8) % 17 - 8;
+			t[i] = now;
+			v[i] = (int32_t)value;
+		}
+		round_trip(t, v, n);
+	}
+}
+
+/**
+ * @brief A steady 1 Hz series costs what the header comment promises.
+ *
+ * The second sample pays for the first period (delta-of-delta 1, 9 bits).
+ */
+static void test_steady_cost(void) {
+	uint8_t buf[256];
+	history_enc_t e;
+
+	history_enc_init(&e, buf, sizeof(buf));
+	for (uint32_t i = 0; i < 100; i++)
+		CHECK(history_enc_add(&e, 100 + i, 2150));
+	CHECK_EQ(e.bits, 64 + 10 + 98 * 2);
+
+	history_enc_init(&e, buf, sizeof(buf));
+	for (uint32_t i = 0; i < 100; i++)
+		CHECK(history_enc_add(&e, 100 + i, 2150 + (int32_t)(i % 8) - 4));
+	CHECK(e.bits <= 64 + 15 + 98 * 7);
+}
+
+/** A full buffer rejects the sample and leaves the stream decodable. */
+static void test_full_buffer(void) {
+	uint8_t buf[16];
+	history_enc_t e;
+	history_enc_init(&e, buf, sizeof(buf));
+
+	uint32_t n = 0;
+	while (history_enc_add(&e, 1000 + n, (int32_t)(n * 1000)))
+		n++;
+	CHECK(n >= 2);
+	uint32_t bits = e.bits;
+	CHECK(!history_enc_add(&e, 1000 + n, (int32_t)(n * 1000)));
+	CHECK_EQ(e.bits, bits);
+	CHECK_EQ(e.count, n);
+	CHECK(history_enc_bytes(&e) <= sizeof(buf));
+
+	history_dec_t d;
+	history_dec_init(&d, buf, sizeof(buf), e.count);
+	uint32_t t;
+	int32_t v;
+	for (uint32_t i = 0; i < n; i++) {
+		CHECK(history_dec_next(&d, &t, &v));
+		CHECK_EQ(t, 1000 + i);
+		CHECK_EQ(v, (int32_t)(i * 1000));
+	}
+	CHECK(!history_dec_next(&d, &t, &v));
+
+	// Not even the first sample fits
+	history_enc_init(&e, buf, 7);
+	CHECK(!history_enc_add(&e, 1, 1));
+	CHECK_EQ(e.count, 0);
+}
+
+/** A truncated stream ends early instead of reading past its length. */
+static void test_truncated(void) {
+	uint8_t buf[64];
+	history_enc_t e;
+	history_enc_init(&e, buf, sizeof(buf));
+	for (uint32_t i = 0; i < 20; i++)
+		CHECK(history_enc_add(&e, 100 + i * 2, (int32_t)(i * i)));
+
+	size_t len = history_enc_bytes(&e);
+	for (size_t cut = 0; cut < len; cut++) {
+		history_dec_t d;
+		history_dec_init(&d, buf, cut, e.count);
+		uint32_t t, n = 0;
+		int32_t v;
+		while (history_dec_next(&d, &t, &v)) {
+			CHECK_EQ(t, 100 + n * 2);
+			CHECK_EQ(v, (int32_t)(n * n));
+			n++;
+		}
+		CHECK(n < e.count);
+	}
+}
+
+static void test_blocks(void) {
+	static uint32_t t[70000], t2[70000];
+	static int32_t v[70000], v2[70000];
+	static uint8_t block[32768];
+
+	for (uint32_t i = 0; i < 70000; i++) {
+		t[i] = 1000 + i;
+		v[i] = 400 + (int32_t)(i / 100 % 50);
+	}
+
+	// A small block takes a prefix and decodes back to it
+	uint32_t taken = 0;
+	size_t len = history_block_encode(t, v, 70000, block, 64, &taken);
+	CHECK(len > HISTORY_BLOCK_HDR && len <= 64);
+	CHECK(taken > 0 && taken < 70000);
+	CHECK_EQ(history_block_decode(block, len, t2, v2, 70000), taken);
+	CHECK(memcmp(t, t2, taken * sizeof(t[0])) == 0);
+	CHECK(memcmp(v, v2, taken * sizeof(v[0])) == 0);
+
+	// The count header caps a block at UINT16_MAX samples
+	len = history_block_encode(t, v, 70000, block, sizeof(block), &taken);
+	CHECK_EQ(taken, UINT16_MAX);
+	CHECK_EQ(history_block_decode(block, len, t2, v2, 70000), UINT16_MAX);
+	CHECK(memcmp(v, v2, UINT16_MAX * sizeof(v[0])) == 0);
+
+	// Decoding stops at max
+	CHECK_EQ(history_block_decode(block, len, t2, v2, 10), 10);
+
+	// Degenerate arguments
+	CHECK_EQ(history_block_encode(t, v, 70000, block, HISTORY_BLOCK_HDR,
+								  &taken),
+			 0);
+	CHECK_EQ(taken, 0);
+	CHECK_EQ(history_block_encode(t, v, 70000, block, HISTORY_BLOCK_HDR + 7,
+								  &taken),
+			 0);
+	CHECK_EQ(history_block_encode(t, v, 0, block, sizeof(block), NULL), 0);
+	CHECK_EQ(history_block_decode(block, 1, t2, v2, 10), 0);
+}
+
+int main(void) {
+	test_value_classes();
+	test_timestamp_classes();
+	test_random_series();
+	test_steady_cost();
+	test_full_buffer();
+	test_truncated();
+	test_blocks();
+	return host_test_result("test_history_codec");
+}
@@ -0,0 +1,339 @@
+/*
+ * Crash consistency of the history flash log (history_log.c).
+ *
+ * Every boot is a forked child that restores the log, then samples and
+ * logs, against a RAM partition the parent keeps across boots. Power is
+ * cut in the middle of a chosen flash operation: a record or sector header
+ * write is torn, or an erase is interrupted, including the erase of sector
+ * 0 when the log wraps. The next boot checks what was restored: every
+ * minute whose write completed (in a sector not erased since) is back, and
+ * every restored minute holds exactly the samples recorded in it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "history_log.h"
+#include "history_store.h"
+#include "host_test.h"
+#include "sim_flash.h"
+#include "sim_rtos.h"
+#include "sntp.h"
+
+HOST_TEST_STATE;
+
+#define BOOTS 240
+#define SEED 0x2545F491u
+
+/* As in history_log.c and partitions.csv */
+#define LOG_SUBTYPE 0x40
+#define LOG_SLOT_SIZE 64
+
+/* A small log (63 minutes per sector) wraps every few boots. */
+#define LOG_SECTORS 4
+
+/* First boot on the wall clock: whole minutes, like HISTORY_BOOT_T_S. */
+#define UNIX0 1700000040u
+#define MAX_MINUTES (45 * 24 * 60)
+
+#define NOT_DURABLE 0xFF
+#define ALL_CHANNELS ((1u << HISTORY_CHANNEL_COUNT) - 1)
+
+/* Exit status of a boot that lost power (0 = ran to its end). */
+#define EXIT_POWER_CUT 3
+
+typedef enum {
+	PLAN_ANY,	 ///< Cut the nth write or erase
+	PLAN_HEADER, ///< Cut the nth sector header write
+	PLAN_ERASE,	 ///< Cut the nth erase
+} cut_plan_t;
+
+typedef enum {
+	CUT_RECORDS,
+	CUT_HEADER,
+	CUT_ERASE,
+	CUT_ERASE_WRAP, ///< Erase of sector 0 after the log went around
+	CUT_KINDS,
+} cut_kind_t;
+
+/**
+ * @brief State shared by the parent and every boot.
+ */
+typedef struct {
+	uint8_t flash[LOG_SECTORS * SIM_FLASH_SECTOR_SIZE];
+	uint8_t samples[MAX_MINUTES]; ///< Samples recorded per minute
+	uint8_t durable[MAX_MINUTES]; ///< Sector holding the minute's completed
+								  ///< write, or NOT_DURABLE
+	bool used[LOG_SECTORS];		  ///< A header was ever written there
+
+	/* Set by the parent for each boot */
+	uint32_t boot_unix;		///< Wall clock at boot (a whole minute)
+	uint32_t run_s;			///< Uptime at which the boot ends uncut
+	cut_plan_t plan;		///< Operations that count towards the cut
+	uint32_t cut_countdown; ///< Cut the nth of them (0 = never)
+
+	/* Updated by the boots */
+	uint32_t now_unix; ///< Last second sampled
+	uint32_t cuts[CUT_KINDS];
+	uint32_t restored; ///< Minutes checked after restores
+} shared_t;
+
+static shared_t *s_sh;
+
+static uint32_t rng_next(uint32_t *s) {
+	*s ^= *s << 13;
+	*s ^= *s >> 17;
+	*s ^= *s << 5;
+	return *s;
+}
+
+static uint32_t minute_of(uint32_t unix_s) {
+	return (unix_s - UNIX0) / 60;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Wall clock and samples                                                     */
+/* -------------------------------------------------------------------------- */
+
+/* Replaces the C library's: the wall clock is set at boot, like SNTP. */
+time_t time(time_t *out) {
+	time_t t = (time_t)s_sh->boot_unix + esp_timer_get_time() / 1000000;
+	if (out)
+		*out = t;
+	return t;
+}
+
+bool sntp_service_time_is_set(void) {
+	return true;
+}
+
+/** A level per channel and minute, plus a ripple within the minute. */
+static int32_t sample_value(int ch, uint32_t unix_s) {
+	static const int32_t base[HISTORY_CHANNEL_COUNT] = {2150, 4500, 450, 20};
+	uint32_t h = (unix_s / 60) * 2654435761u ^ (uint32_t)ch * 40503u;
+	return base[ch] + (int32_t)(h % 500) + (int32_t)(unix_s % 60 % 7);
+}
+
+/**
+ * @brief Rollup of a minute from the samples recorded in it (seconds 0 to
+ * samples - 1: boots start on a whole minute and sample every second).
+ *
+ * @return false if nothing was recorded in that minute.
+ */
+static bool expected(int ch, uint32_t m, history_point_t *out) {
+	uint32_t n = s_sh->samples[m];
+	if (n == 0)
+		return false;
+
+	uint32_t start = UNIX0 + m * 60;
+	int64_t sum = 0;
+	*out = (history_point_t){.min = INT32_MAX, .max = INT32_MIN, .count = n};
+	for (uint32_t s = 0; s < n; s++) {
+		int32_t v = sample_value(ch, start + s);
+		out->min = v < out->min ? v : out->min;
+		out->max = v > out->max ? v : out->max;
+		sum += v;
+	}
+	out->mean = (int32_t)((sum + n / 2) / n);
+	return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Flash hooks (run in the boots)                                             */
+/* -------------------------------------------------------------------------- */
+
+static bool on_before(sim_flash_op_t op, size_t offset, size_t size,
+					  void *arg) {
+	uint32_t sector = (uint32_t)(offset / SIM_FLASH_SECTOR_SIZE);
+	bool header = op == SIM_FLASH_WRITE && offset % SIM_FLASH_SECTOR_SIZE == 0;
+
+	// Even cut short, an erase takes the sector's records with it
+	if (op == SIM_FLASH_ERASE) {
+		for (uint32_t m = 0; m < MAX_MINUTES; m++) {
+			if (s_sh->durable[m] == sector)
+				s_sh->durable[m] = NOT_DURABLE;
+		}
+	}
+
+	bool counts = s_sh->plan == PLAN_ANY ||
+				  (s_sh->plan == PLAN_HEADER && header) ||
+				  (s_sh->plan == PLAN_ERASE && op == SIM_FLASH_ERASE);
+	if (!counts || s_sh->cut_countdown == 0 || --s_sh->cut_countdown > 0)
+		return false;
+
+	cut_kind_t kind = header ? CUT_HEADER : CUT_RECORDS;
+	if (op == SIM_FLASH_ERASE) {
+		kind = sector == 0 && s_sh->used[LOG_SECTORS - 1] ? CUT_ERASE_WRAP
+														  : CUT_ERASE;
+	}
+	s_sh->cuts[kind]++;
+	return true;
+}
+
+static void on_done(sim_flash_op_t op, size_t offset, const void *src,
+					size_t size, void *arg) {
+	if (op != SIM_FLASH_WRITE)
+		return;
+
+	uint32_t sector = (uint32_t)(offset / SIM_FLASH_SECTOR_SIZE);
+	for (size_t k = 0; k < size; k += LOG_SLOT_SIZE) {
+		if ((offset + k) % SIM_FLASH_SECTOR_SIZE == 0) {
+			s_sh->used[sector] = true; // sector header
+			continue;
+		}
+		// A record: its Unix minute comes first (log_record_t)
+		uint32_t unix_s;
+		memcpy(&unix_s, (const uint8_t *)src + k, sizeof(unix_s));
+		uint32_t m = minute_of(unix_s);
+		if (unix_s >= UNIX0 && m < MAX_MINUTES)
+			s_sh->durable[m] = (uint8_t)sector;
+	}
+}
+
+static void on_power_off(void *arg) {
+	fflush(stdout);
+	fflush(stderr);
+	_exit(host_test_failures ? 1 : EXIT_POWER_CUT);
+}
+
+/* -------------------------------------------------------------------------- */
+/* One boot                                                                   */
+/* -------------------------------------------------------------------------- */
+
+/** Compare the restored 1-minute tier with what was recorded and written. */
+static void check_restored(void) {
+	static history_point_t pts[HISTORY_1MIN_LEN];
+	static uint8_t seen[MAX_MINUTES];
+
+	for (int ch = 0; ch < HISTORY_CHANNEL_COUNT; ch++) {
+		int n = history_query((history_channel_t)ch, HISTORY_TIER_1MIN, 0,
+							  UINT32_MAX, pts, HISTORY_1MIN_LEN);
+		for (int i = 0; i < n; i++) {
+			uint32_t unix_s = pts[i].t_s + s_sh->boot_unix - HISTORY_BOOT_T_S;
+			uint32_t m = minute_of(unix_s);
+			history_point_t want = {0};
+			CHECK_EQ(unix_s % 60, 0);
+			CHECK(m < MAX_MINUTES && expected(ch, m, &want));
+			if (m >= MAX_MINUTES || s_sh->samples[m] == 0)
+				continue;
+
+			CHECK_EQ(pts[i].count, want.count);
+			CHECK_EQ(pts[i].min, want.min);
+			CHECK_EQ(pts[i].max, want.max);
+			CHECK_EQ(pts[i].mean, want.mean);
+			seen[m] |= 1u << ch;
+		}
+	}
+
+	for (uint32_t m = 0; m < MAX_MINUTES; m++) {
+		if (s_sh->durable[m] != NOT_DURABLE && seen[m] != ALL_CHANNELS) {
+			fprintf(stderr, "minute %u was written but not restored\n", m);
+			host_test_failures++;
+		}
+		if (seen[m])
+			s_sh->restored++;
+	}
+}
+
+static void boot_main(void *arg) {
+	CHECK_EQ(history_store_init(), ESP_OK);
+	CHECK_EQ(history_log_start(), ESP_OK);
+	check_restored();
+
+	// Sample every channel each second until the boot's end or a cut
+	TickType_t last = xTaskGetTickCount();
+	while (esp_timer_get_time() < (int64_t)s_sh->run_s * 1000000) {
+		uint32_t t_s = history_now_s();
+		uint32_t unix_s = (uint32_t)time(NULL);
+		for (int ch = 0; ch < HISTORY_CHANNEL_COUNT; ch++) {
+			history_record((history_channel_t)ch, t_s,
+						   sample_value(ch, unix_s));
+		}
+		s_sh->samples[minute_of(unix_s)]++;
+		s_sh->now_unix = unix_s;
+		vTaskDelayUntil(&last, pdMS_TO_TICKS(1000));
+	}
+}
+
+static int boot(uint32_t seed) {
+	(void)sim_flash_add_partition("history", ESP_PARTITION_TYPE_DATA,
+								  LOG_SUBTYPE, s_sh->flash,
+								  sizeof(s_sh->flash));
+	const sim_flash_hooks_t hooks = {
+		.before = on_before,
+		.done = on_done,
+		.power_off = on_power_off,
+	};
+	sim_flash_set_hooks(&hooks, seed);
+
+	sim_rtos_run(boot_main, NULL);
+	fflush(stdout);
+	return host_test_failures ? 1 : 0;
+}
+
+int main(void) {
+	s_sh = mmap(NULL, sizeof(*s_sh), PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (s_sh == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	memset(s_sh->flash, 0xFF, sizeof(s_sh->flash));
+	memset(s_sh->durable, NOT_DURABLE, sizeof(s_sh->durable));
+	s_sh->now_unix = UNIX0;
+
+	uint32_t rng = SEED;
+	int boots = 0;
+	for (; boots < BOOTS; boots++) {
+		// Off for up to a few minutes, then on for 10 minutes to 2.5 hours
+		s_sh->boot_unix = (s_sh->now_unix / 60 + 1 + rng_next(&rng) % 5) * 60;
+		s_sh->run_s = 60 * (10 + rng_next(&rng) % 140) + 30;
+
+		// Cut anywhere half the time; otherwise go for a header or an erase.
+		// The last boot only checks the restore.
+		s_sh->plan = boots % 4 < 2 ? PLAN_ANY
+					 : boots % 4 == 2 ? PLAN_HEADER
+									  : PLAN_ERASE;
+		s_sh->cut_countdown =
+			boots == BOOTS - 1 ? 0
+			: s_sh->plan == PLAN_ANY
+				? 1 + rng_next(&rng) % (s_sh->run_s / 60 + 4)
+				: 1;
+		uint32_t seed = rng_next(&rng);
+
+		fflush(stdout);
+		fflush(stderr);
+		pid_t pid = fork();
+		if (pid == 0)
+			_exit(boot(seed));
+
+		int status = 0;
+		if (pid < 0 || waitpid(pid, &status, 0) != pid ||
+			!WIFEXITED(status) ||
+			(WEXITSTATUS(status) != 0 &&
+			 WEXITSTATUS(status) != EXIT_POWER_CUT)) {
+			fprintf(stderr, "boot %d failed (status 0x%x, seed 0x%08x)\n",
+					boots, status, seed);
+			host_test_failures++;
+			break;
+		}
+	}
+
+	printf("%d boots: power cut in %u record writes, %u header writes, "
+		   "%u erases (%u at the wrap); %u restored minutes checked\n",
+		   boots, s_sh->cuts[CUT_RECORDS], s_sh->cuts[CUT_HEADER],
+		   s_sh->cuts[CUT_ERASE], s_sh->cuts[CUT_ERASE_WRAP], s_sh->restored);
+
+	for (int k = 0; k < CUT_KINDS; k++)
+		CHECK(s_sh->cuts[k] > 0);
+	CHECK(s_sh->restored > 0);
+	return host_test_result("test_history_log_crash");
+}
@@ -0,0 +1,142 @@
+/*
+ * Aggregate throughput with one bus vs two buses carrying the same load
+ * each (one owner task per port, port_i2c_service.c).
+ *
+ * Every simulated operation gets extra latency, as on a long or heavily
+ * loaded cable, so the bus rather than the conversions limits a port.
+ * Each device has a requester that samples back to back.
+ */
+
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "host_test.h"
+#include "port_i2c_service.h"
+#include "port_i2c_sim.h"
+#include "port_i2c_stats.h"
+#include "sim_rtos.h"
+
+HOST_TEST_STATE;
+
+#define WINDOW_MS 5000
+#define WARMUP_MS 500
+
+/* Bus time added to every operation: makes one bus the bottleneck. */
+#define EXTRA_LATENCY_US 8000
+
+#define SHT40_SCL_HZ 400000
+#define SHT40_MEASURE_HIGH 0xFD
+#define SHT40_CONV_TICKS (pdMS_TO_TICKS(9) + 1)
+
+/* SHT40 sockets used per port (the service takes 8 devices in total). */
+static const uint8_t s_addrs[] = {0x44, 0x45};
+#define N_ADDRS ((int)(sizeof(s_addrs) / sizeof(s_addrs[0])))
+
+typedef struct {
+	i2c_master_dev_handle_t dev;
+	QueueHandle_t reply_q;
+	volatile bool run;
+	uint32_t done; ///< Good samples completed inside the window
+} requester_t;
+
+static volatile bool s_measuring;
+
+static void requester_task(void *arg) {
+	requester_t *r = arg;
+	uint8_t rx[6];
+	uint32_t id = 0;
+
+	while (r->run) {
+		port_i2c_req_t req = {
+			.request_id = ++id,
+			.cmd = SHT40_MEASURE_HIGH,
+			.cmd_len = 1,
+			.rx = rx,
+			.rx_len = sizeof(rx),
+			.post_cmd_delay_ticks = SHT40_CONV_TICKS,
+			.dev = r->dev,
+			.reply_queue = r->reply_q,
+		};
+		(void)port_i2c_service_submit(&req, portMAX_DELAY);
+		port_i2c_resp_t resp;
+		(void)xQueueReceive(r->reply_q, &resp, portMAX_DELAY);
+		if (s_measuring && resp.err == ESP_OK)
+			r->done++;
+	}
+	vTaskDelete(NULL);
+}
+
+/**
+ * @brief Sample `n` devices (ports[i], addrs[i]) for one window.
+ *
+ * @param[out] busy_pct Occupancy of ports[0] over the window.
+ *
+ * @return Aggregate good samples per second.
+ */
+static double run(const port_i2c_port_t *ports, const uint8_t *addrs, int n,
+				  float *busy_pct) {
+	requester_t rs[8] = {0};
+
+	for (int i = 0; i < n; i++) {
+		CHECK_EQ(port_i2c_sim_set_present(ports[i], addrs[i], true), ESP_OK);
+		CHECK_EQ(port_i2c_service_add_device(ports[i], addrs[i], SHT40_SCL_HZ,
+											 &rs[i].dev),
+				 ESP_OK);
+		rs[i].reply_q = xQueueCreate(1, sizeof(port_i2c_resp_t));
+		rs[i].run = true;
+		(void)xTaskCreatePinnedToCore(requester_task, "requester", 4096,
+									  &rs[i], 5, NULL, 1);
+	}
+
+	vTaskDelay(pdMS_TO_TICKS(WARMUP_MS));
+	port_i2c_stats_reset();
+	s_measuring = true;
+	vTaskDelay(pdMS_TO_TICKS(WINDOW_MS));
+	s_measuring = false;
+
+	port_i2c_bus_stats_t bus = {0};
+	CHECK_EQ(port_i2c_stats_get_bus(ports[0], &bus), ESP_OK);
+	*busy_pct = bus.busy_pct;
+
+	uint32_t total = 0;
+	for (int i = 0; i < n; i++) {
+		total += rs[i].done;
+		rs[i].run = false;
+	}
+	/* Let the requesters finish their last sample and exit */
+	vTaskDelay(pdMS_TO_TICKS(WARMUP_MS));
+	return total * 1000.0 / WINDOW_MS;
+}
+
+static void test_main(void *arg) {
+	const port_i2c_sim_faults_t faults = {.extra_latency_us = EXTRA_LATENCY_US};
+	port_i2c_sim_set_faults(&faults);
+
+	/* Two SHT40s on port A; the same two on each of ports B and C */
+	const port_i2c_port_t one_bus[] = {PORT_I2C_PORT_A, PORT_I2C_PORT_A};
+	const port_i2c_port_t two_buses[] = {PORT_I2C_PORT_B, PORT_I2C_PORT_B,
+										 PORT_I2C_PORT_C, PORT_I2C_PORT_C};
+	const uint8_t addrs2[] = {0x44, 0x45, 0x44, 0x45};
+
+	float busy_one, busy_two;
+	double one = run(one_bus, s_addrs, N_ADDRS, &busy_one);
+	double two = run(two_buses, addrs2, 2 * N_ADDRS, &busy_two);
+
+	printf("1 bus,   %d devices: %6.1f samples/s, bus busy %.1f%%\n",
+		   N_ADDRS, one, busy_one);
+	printf("2 buses, %d devices: %6.1f samples/s, bus busy %.1f%% (x%.2f)\n",
+		   2 * N_ADDRS, two, busy_two, one > 0 ? two / one : 0);
+
+	/* One bus is the bottleneck, so a second one doubles the total */
+	CHECK(busy_one >= 90.0f);
+	CHECK(two >= 1.9 * one);
+	CHECK(two <= 2.1 * one);
+}
+
+int main(void) {
+	sim_rtos_run(test_main, NULL);
+	return host_test_result("test_port_i2c_buses");
+}
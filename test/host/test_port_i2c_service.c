@@ -0,0 +1,125 @@
+/*
+ * Owner task scheduling on the simulated bus (port_i2c_service.c).
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "host_test.h"
+#include "port_i2c_service.h"
+#include "port_i2c_sim.h"
+#include "sim_rtos.h"
+
+HOST_TEST_STATE;
+
+#define SHT40_ADDR 0x44
+#define SHT40_SCL_HZ 400000
+#define SHT40_MEASURE_HIGH 0xFD
+#define SHT40_SERIAL 0x89
+#define SHT40_SOFT_RESET 0x94
+
+/* An unplugged address, so scan probes never touch the device under test. */
+#define SCAN_ADDR 0x45
+
+static volatile int s_probes;
+
+static void on_probe(port_i2c_port_t port, uint8_t addr, esp_err_t err,
+					 void *arg) {
+	s_probes++;
+}
+
+/**
+ * @brief Requests queued behind a parked read run in order once it is done.
+ *
+ * A is parked while the SHT40 converts, so B, C and D are deferred. B (a
+ * write) and C (a batch) complete as soon as they start; the owner must
+ * keep going until D parks, or C and D are stranded and the deferred FIFO
+ * never drains, which also stops the background scan.
+ */
+static void test_deferred_behind_parked_read(void) {
+	i2c_master_dev_handle_t dev = NULL;
+	CHECK_EQ(port_i2c_service_add_device(PORT_I2C_PORT_A, SHT40_ADDR,
+										 SHT40_SCL_HZ, &dev),
+			 ESP_OK);
+	const uint8_t scan_addr = SCAN_ADDR;
+	CHECK_EQ(port_i2c_service_set_scan(PORT_I2C_PORT_A, &scan_addr, 1,
+									   pdMS_TO_TICKS(50), on_probe, NULL),
+			 ESP_OK);
+
+	QueueHandle_t replies = xQueueCreate(8, sizeof(port_i2c_resp_t));
+	uint8_t rx_a[6], rx_c[6], rx_d[6];
+	static const uint8_t serial_cmd = SHT40_SERIAL;
+	const port_i2c_op_t serial_ops[] = {
+		{.type = PORT_I2C_OP_DELAY, .delay_ticks = 1}, // reset settles
+		{.type = PORT_I2C_OP_WRITE, .tx = &serial_cmd, .tx_len = 1},
+		{.type = PORT_I2C_OP_DELAY, .delay_ticks = 1},
+		{.type = PORT_I2C_OP_READ, .rx = rx_c, .rx_len = sizeof(rx_c)},
+	};
+	const port_i2c_req_t reqs[] = {
+		{.request_id = 1,
+		 .cmd = SHT40_MEASURE_HIGH,
+		 .cmd_len = 1,
+		 .rx = rx_a,
+		 .rx_len = sizeof(rx_a),
+		 .post_cmd_delay_ticks = 1,
+		 .dev = dev,
+		 .reply_queue = replies},
+		{.request_id = 2,
+		 .cmd = SHT40_SOFT_RESET,
+		 .cmd_len = 1,
+		 .dev = dev,
+		 .reply_queue = replies},
+		{.request_id = 3,
+		 .dev = dev,
+		 .reply_queue = replies,
+		 .ops = serial_ops,
+		 .n_ops = 4},
+		{.request_id = 4,
+		 .cmd = SHT40_MEASURE_HIGH,
+		 .cmd_len = 1,
+		 .rx = rx_d,
+		 .rx_len = sizeof(rx_d),
+		 .post_cmd_delay_ticks = 1,
+		 .dev = dev,
+		 .reply_queue = replies},
+	};
+	for (size_t i = 0; i < sizeof(reqs) / sizeof(reqs[0]); i++) {
+		CHECK_EQ(port_i2c_service_submit(&reqs[i], 0), ESP_OK);
+	}
+
+	for (uint32_t id = 1; id <= 4; id++) {
+		port_i2c_resp_t resp = {0};
+		if (xQueueReceive(replies, &resp, pdMS_TO_TICKS(1000)) != pdTRUE) {
+			CHECK(!"reply missing");
+			break;
+		}
+		CHECK_EQ(resp.request_id, id);
+		CHECK_EQ(resp.err, ESP_OK);
+	}
+
+	/* Deferred FIFO drained: the scan gets its idle gaps again */
+	int probes = s_probes;
+	vTaskDelay(pdMS_TO_TICKS(500));
+	CHECK(s_probes >= probes + 5);
+
+	/* A new request for the device is not held back by leftovers */
+	port_i2c_req_t again = reqs[0];
+	again.request_id = 5;
+	CHECK_EQ(port_i2c_service_submit(&again, 0), ESP_OK);
+	port_i2c_resp_t resp = {0};
+	CHECK(xQueueReceive(replies, &resp, pdMS_TO_TICKS(1000)) == pdTRUE);
+	CHECK_EQ(resp.request_id, 5);
+	CHECK_EQ(resp.err, ESP_OK);
+}
+
+static void test_main(void *arg) {
+	test_deferred_behind_parked_read();
+}
+
+int main(void) {
+	sim_rtos_run(test_main, NULL);
+	return host_test_result("test_port_i2c_service");
+}
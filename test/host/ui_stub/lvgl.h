@@ -0,0 +1,16 @@
+#pragma once
+
+/*
+ * Just the LVGL types ui.h and ui_screens.h name, so ui_task.c builds
+ * without LVGL (bench_ui_task). The UI modules that call LVGL are not
+ * built against it.
+ */
+
+#include <stdint.h>
+
+typedef struct _lv_obj_t lv_obj_t;
+typedef struct _lv_disp_t lv_disp_t;
+
+typedef union {
+	uint16_t full;
+} lv_color_t;